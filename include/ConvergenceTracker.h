@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief
+///  Detects when the progressive drawing has converged, so the renderer can stop submitting frames.
+///
+/// The prepare pass counts the pixels whose vertex index changed since its previous pass. The image is converged
+/// once the camera is still, the whole cloud is drawn and almost no pixel changed for several frames in a row: each
+/// new frame would then present the same image. A few pixels may keep alternating between points at the same depth,
+/// so a small fraction of the image is tolerated.
+class ConvergenceTracker
+{
+public:
+    /// Number of consecutive stable frames before the image is converged, besides the frames in flight: the pixel
+    /// count is read as many frames late.
+    static constexpr uint32_t STABLE_FRAME_COUNT = 2;
+    /// Fraction of the pixels allowed to change in a stable frame.
+    static constexpr double CHANGED_PIXEL_FRACTION = 1e-4;
+
+    ///  Feeds a frame.
+    /// @param[in] iChangedPixelCount Pixels whose vertex index changed in the last finished prepare pass.
+    /// @param[in] iPixelCount Number of pixels of the image.
+    /// @param[in] iCameraStill True if the view did not change since the previous frame.
+    /// @param[in] iDrawComplete True if every point of the cloud was drawn.
+    void Update(uint32_t iChangedPixelCount, uint32_t iPixelCount, bool iCameraStill, bool iDrawComplete);
+
+    ///  Sets the number of frames in flight, 2 by default.
+    /// @param[in] iFrameCount Number of frames in flight.
+    void SetFramesInFlight(uint32_t iFrameCount);
+
+    ///  True once the image no longer changes.
+    bool IsConverged() const { return m_StableFrameCount >= m_RequiredFrameCount; }
+
+    ///  Restarts the detection, after a change of the scene or of the rendering parameters.
+    void Reset() { m_StableFrameCount = 0; }
+
+private:
+    /// Number of consecutive stable frames.
+    uint32_t m_StableFrameCount = 0;
+    /// Number of consecutive stable frames before the image is converged.
+    uint32_t m_RequiredFrameCount = STABLE_FRAME_COUNT + 2;
+};
@@ -12,7 +12,7 @@ struct OptiCloudVertex
     glm::vec3 Pos{};
     /// Color (3 bytes).
     glm::u8vec3 Color{};
-    /// Attribute (1 byte) - not used.
+    /// Attribute (1 byte) - index of the source cloud, see MultiCloudReader.
     uint8_t Attribute{};
 
     static VkVertexInputBindingDescription GetBindingDescription();
@@ -18,6 +18,10 @@ public:
 
     void InitCube();
     void InitQuad();
+
+    ///  Imports a mesh file (OBJ or PLY) and uploads it.
+    /// @param[in] iFilePath Path to the mesh file.
+    void Load(const std::filesystem::path &iFilePath);
     void Destroy();
 
     VkBuffer GetVertexBuffer() const { return m_VertexBuffer.Buffer; }
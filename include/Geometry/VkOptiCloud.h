@@ -4,6 +4,14 @@
 #include "Olympus/CommandBuffer.h"
 #include "Olympus/MemoryBuffer.h"
 #include "Geometry/OptiCloudVertex.h"
+#include "Vulkan/ChunkResidency.h"
+#include "Vulkan/ChunkStreamer.h"
+#include "Vulkan/ShufflePass.h"
+#include "Vulkan/StepCounter.h"
+#include <glm/mat4x4.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
 
 ///  Class which holds, allocates and draws a optimize cloud.
 class VkOptiCloud
@@ -19,37 +27,145 @@ public:
 
     olp::MemoryBuffer &GetVertexBuffer() { return m_VertexBuffer; }
     olp::MemoryBuffer &GetReprojectedBuffer() { return m_ReprojectedBuffer; }
+    ///  VkDrawIndirectCommand of the reprojected buffer, whose vertex count is set by the prepare pass.
+    olp::MemoryBuffer &GetReprojectedDrawBuffer() { return m_ReprojectedDrawBuffer; }
 
-    uint32_t GetVertexBufferSize() { return m_VertexBufferSize; }
+    ///  One uint per slot of ChunkStreamer::CHUNK_SIZE points of the vertex buffer, 0 while the points of the slot
+    ///  must not be reprojected (see ChunkResidency).
+    olp::MemoryBuffer &GetResidentSlotBuffer() { return m_ResidentSlotBuffer; }
+
+    VkDeviceSize GetVertexBufferSize() { return m_VertexBufferSize; }
     uint32_t GetReprojectedBufferSize() { return m_ReprojectedBufferSize; }
 
-    void SetPointsByStep(uint32_t iPointCount) { m_NbPointByStep = iPointCount; }
+    void SetPointsByStep(uint32_t iPointCount);
+    uint32_t GetPointsByStep() const { return m_NbPointByStep; }
+
+    ///  Model matrix of each source cloud, indexed by the Attribute of the vertices. A single identity by default.
+    const std::vector<glm::mat4> &GetTransforms() const { return m_Transforms; }
+    void SetTransforms(const std::vector<glm::mat4> &iTransforms) { m_Transforms = iTransforms; }
 
     void Init();
 
+    ///  Starts streaming the cloud decoded by a reader. If the cloud fits in the memory budget, the vertex buffer is
+    ///  allocated at once and filled chunk by chunk by UpdateStreaming(), the loaded points are drawn while the rest
+    ///  is decoded. Otherwise the vertex buffer only holds a working set of chunks, see ChunkResidency: such a cloud
+    ///  must be shuffled, an exception is thrown otherwise.
+    ///  A background cloud is not drawn until IsReadyToJoin(): its chunks are copied on the asynchronous queue and
+    ///  the first frame drawing it waits on TakeUploadSemaphore().
+    ///  A cloud which is not shuffled (see CloudReader::IsShuffled()) is uploaded in file order to a second buffer
+    ///  and is not drawn until the ShufflePass has gathered it into the vertex buffer.
+    /// @param[in] iReader Reader of the cloud file.
+    /// @param[in] iBackground True if the cloud is loaded while another one is drawn.
+    void Stream(std::unique_ptr<CloudReader> iReader, bool iBackground = false);
+
+    ///  Uploads the chunks decoded since the last call. To call once per frame, before recording the draws.
+    /// @param[in,out] ioPrepareSemaphore Semaphore signaled by the last prepare pass, that the next graphics
+    ///                                   submission waits on. The copies refilling the slots of an out-of-core cloud
+    ///                                   wait on it, and replace it with a semaphore they signal (see
+    ///                                   ChunkStreamer::Update()).
+    void UpdateStreaming(VkSemaphore &ioPrepareSemaphore);
+
+    ///  Same as UpdateStreaming(VkSemaphore &), for a cloud which is not drawn yet.
+    void UpdateStreaming();
+
+    ///  True while the cloud is being streamed.
+    bool IsStreaming() const { return m_Streamer != nullptr; }
+
+    ///  True if the cloud does not fit in the vertex buffer and is streamed in and out of it.
+    bool IsOutOfCore() const { return m_Residency != nullptr; }
+
+    ///  True once a background cloud can replace the drawn one: all its copies are submitted, or it is out-of-core
+    ///  and loads its working set while it is drawn. A cloud in file order is ready once its shuffle is submitted.
+    bool IsReadyToJoin() const;
+
+    ///  Semaphore signaled by the last copy of a background cloud, VK_NULL_HANDLE if there is none. The caller
+    ///  becomes its owner and waits on it at the vertex input and compute shader stages of the next frame, which must
+    ///  also call RecordPendingAcquire(). The whole cloud is drawable afterwards.
+    VkSemaphore TakeUploadSemaphore();
+
+    ///  True between TakeUploadSemaphore() and RecordPendingAcquire().
+    bool IsAcquirePending() const { return m_AcquirePending; }
+
+    ///  Records the acquisition of the vertex buffer by the graphics queue after TakeUploadSemaphore(), once.
+    /// @param[in] iCommandBuffer Current command buffer, outside of a render pass.
+    void RecordPendingAcquire(VkCommandBuffer iCommandBuffer);
+
     void CreateReprojectedBuffer(uint32_t iWidth, uint32_t iHeight);
     void DestroyReprojectedBuffer();
 
     void Destroy();
 
-    ///  Draw NbPointByStep of the VertexBuffer and increment the step.
+    ///  Records the advance of the step on the device, see StepCounter. The commands drawing the step then do not
+    ///  depend on it, they can be submitted again. Nothing is recorded for an out-of-core cloud, whose steps are
+    ///  chosen while recording their draws.
+    /// @param[in] iCommandBuffer Current command buffer, outside of a render pass.
+    /// @param[in] iSlot Slot of the frame, receiving the size of the step (see TakeStepPointCount()).
+    void RecordAdvance(VkCommandBuffer iCommandBuffer, uint32_t iSlot);
+
+    ///  Hands the resets and the loaded points since the last call to the advance of a slot, see StepCounter::Commit().
+    /// @param[in] iSlot Slot given to RecordAdvance(), whose previous frame is finished.
+    void CommitStep(uint32_t iSlot) { m_StepCounter->Commit(iSlot); }
+
+    ///  Draw the step of the VertexBuffer, NbPointByStep points.
     /// @param[in] iCommandBuffer Current command buffer.
-    void DrawVertexBuffer(VkCommandBuffer iCommandBuffer);
+    /// @param[in] iSlot Slot given to RecordAdvance().
+    void DrawVertexBuffer(VkCommandBuffer iCommandBuffer, uint32_t iSlot);
+
+    ///  Advances the step of an out-of-core cloud like DrawVertexBuffer(), recording the points with another backend.
+    ///  The steps of a resident cloud are drawn with the indirect commands of GetStepCounter().
+    /// @param[in] iRecordRange Records the draw of iCount points of the vertex buffer from iFirst.
+    /// @param[in] iSlot Slot given to RecordAdvance().
+    void RecordStep(const std::function<void(uint32_t iFirst, uint32_t iCount)> &iRecordRange, uint32_t iSlot);
+
+    ///  Number of points drawn by the step of a slot, 0 if the cloud is fully drawn or the step was not loaded yet.
+    ///  The frame of the slot must be finished. Each step is only counted once.
+    /// @param[in] iSlot Slot given to RecordAdvance().
+    uint32_t TakeStepPointCount(uint32_t iSlot) { return m_StepCounter->TakeStepPointCount(iSlot); }
+
+    ///  True once the progressive drawing has drawn every point of the loaded cloud since the last reset.
+    bool IsDrawComplete() const;
 
-    ///  Draw the reprojected buffer.
+    ///  Progressive step of the cloud, advanced on the device.
+    const StepCounter &GetStepCounter() const { return *m_StepCounter; }
+
+    ///  Draw the points appended to the reprojected buffer, with the count written by the prepare pass.
     /// @param[in] iCommandBuffer Current command buffer.
     void DrawReprojectedBuffer(VkCommandBuffer iCommandBuffer);
 
-    ///  Reset the current step to 0. To use when the scene is moving.
+    ///  Reset the current step to 0 from the next advance. To use when the scene is moving.
     void ResetDraw();
 
+    ///  Draws again the last points of the progressive drawing, to fill the parts of the image uncovered by a camera
+    ///  motion. An out-of-core cloud restarts its pass.
+    /// @param[in] iFraction Fraction of the drawn points to draw again, in [0, 1].
+    void RewindDraw(float iFraction);
+
 protected:
     void CreateVertexBuffer(const std::vector<OptiCloudVertex> &iPoints);
 
+    ///  Sends the point counts of the cloud to the step counter.
+    void UpdateStepCounter();
+
+    ///  Allocates the resident slots of the vertex buffer, see GetResidentSlotBuffer().
+    /// @param[in] iResident True if the slots hold points from the start, false for an out-of-core cloud.
+    void CreateResidentSlotBuffer(bool iResident);
+
+    ///  Allocates the buffer the cloud is uploaded to in file order, before the shuffle.
+    void CreateFileOrderBuffer();
+
+    ///  Submits the shuffle of the file order buffer into the vertex buffer. The points are drawable afterwards.
+    void SubmitShuffle();
+
+    ///  Size of the largest vertex buffer to allocate: half the device local memory, within the storage buffer range
+    ///  of the prepare pass.
+    VkDeviceSize GetMemoryBudget() const;
+
     /// Number of vertex in the cloud.
     uint32_t m_NbVertex = 0;
+    /// Number of vertex already in the vertex buffer (less than m_NbVertex while streaming).
+    uint32_t m_NbLoadedVertex = 0;
     /// Size of the vertex buffer. nbVertex * sizeof(OptiCloudVertex).
-    uint32_t m_VertexBufferSize = 0;
+    VkDeviceSize m_VertexBufferSize = 0;
     /// Number of points to draw at each step. Convergence speed.
     uint32_t m_NbPointByStep = 100'000;
     /// Size of the reprojected buffer. Surface size * sizeof(CloudVertex).
@@ -57,12 +173,40 @@ protected:
     /// Number of vertex in the reprojected buffer.
     uint32_t m_NbReprojectedVertex = 0;
 
-    /// Current step. Used by DrawVertexBuffer.
+    /// Model matrices of the source clouds.
+    std::vector<glm::mat4> m_Transforms{glm::mat4(1.0f)};
+
+    /// Current step of an out-of-core cloud. Used by RecordStep.
     uint32_t m_Step = 0;
 
     const olp::Device &m_Device;
     /// A OptiCloudVertex buffer the size of the cloud.
     olp::MemoryBuffer m_VertexBuffer;
-    /// A CloudVertex buffer the size of the surface.
+    /// Flag of each slot of the vertex buffer, mapped in m_ResidentSlots.
+    olp::MemoryBuffer m_ResidentSlotBuffer;
+    uint32_t *m_ResidentSlots = nullptr;
+    /// A CloudVertex buffer the size of the surface, holding the points visible in the previous frame.
     olp::MemoryBuffer m_ReprojectedBuffer;
+    /// Indirect draw of m_ReprojectedBuffer.
+    olp::MemoryBuffer m_ReprojectedDrawBuffer;
+    /// Progressive step of a resident cloud, and size of the steps of each slot.
+    std::unique_ptr<StepCounter> m_StepCounter;
+    /// Uploads the cloud while it is decoded, null once it is fully loaded.
+    std::unique_ptr<ChunkStreamer> m_Streamer;
+    /// Chunks already copied by m_Streamer.
+    std::vector<bool> m_LoadedChunks;
+    /// Number of chunks at the start of the cloud that are all loaded.
+    uint32_t m_LoadedChunkPrefix = 0;
+    /// Points of a cloud in file order, destroyed once shuffled into m_VertexBuffer.
+    olp::MemoryBuffer m_FileOrderBuffer;
+    /// Shuffle of m_FileOrderBuffer, null once finished.
+    std::unique_ptr<ShufflePass> m_ShufflePass;
+    /// True while the cloud is uploaded to m_FileOrderBuffer, before the shuffle is submitted.
+    bool m_ShufflePending = false;
+    /// Working set of a cloud larger than the memory budget, null otherwise.
+    std::unique_ptr<ChunkResidency> m_Residency;
+    /// True if m_Streamer copies on the asynchronous queue.
+    bool m_BackgroundUpload = false;
+    /// True between TakeUploadSemaphore() and RecordPendingAcquire().
+    bool m_AcquirePending = false;
 };
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Geometry/OptiCloudVertex.h"
+#include <glm/vec3.hpp>
+#include <filesystem>
+#include <memory>
+
+/// @brief
+///  Interface of the point cloud file readers.
+///
+/// A reader decodes the points of a file straight into caller-provided memory (usually a mapped staging buffer),
+/// so no intermediate copy of the cloud is kept on the host.
+class CloudReader
+{
+public:
+    virtual ~CloudReader() = default;
+
+    ///  Opens a cloud file, choosing the reader from the file extension.
+    /// @param[in] iFilePath Path to the cloud file.
+    /// @return Reader of the file.
+    static std::unique_ptr<CloudReader> Open(const std::filesystem::path &iFilePath);
+
+    ///  Number of points in the file.
+    virtual uint32_t GetPointCount() const = 0;
+
+    ///  Decodes a range of points, in file order. Disjoint ranges can be decoded concurrently.
+    /// @param[in] iFirst Index of the first point to decode.
+    /// @param[in] iCount Number of points to decode.
+    /// @param[out] oPoints Destination of the decoded points, iCount elements.
+    virtual void ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const = 0;
+
+    ///  World position of the cloud origin, to be added to the decoded positions.
+    virtual glm::dvec3 GetOrigin() const { return glm::dvec3(0.0); }
+
+    ///  True if the points are already in progressive order, i.e. any range of them is a uniform sample of the cloud.
+    ///  The points of the other readers are in file order, they are shuffled on the device after the upload.
+    virtual bool IsShuffled() const { return false; }
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "IO/CloudReader.h"
+#include "IO/MappedFile.h"
+#include <glm/vec3.hpp>
+
+/// @brief
+///  Reader of uncompressed LAS 1.2 to 1.4 clouds (point formats 0 to 10).
+///
+/// Coordinates are stored as scaled int32, they are dequantized relative to the center of the bounding box
+/// so the float positions keep their precision on georeferenced data. 16-bit colors are reduced to 8 bits;
+/// files that store 8-bit values in the 16-bit fields are detected and kept as is.
+class LasReader : public CloudReader
+{
+public:
+    ///  Maps the file and parses its public header.
+    /// @param[in] iFilePath Path to the LAS file.
+    explicit LasReader(const std::filesystem::path &iFilePath);
+
+    uint32_t GetPointCount() const override { return m_PointCount; }
+
+    void ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const override;
+
+    glm::dvec3 GetOrigin() const override { return m_Origin; }
+
+private:
+    ///  Checks a sample of the colors to find out if they use the full 16-bit range.
+    void DetectColorDepth();
+
+    /// Mapped file.
+    MappedFile m_File;
+    /// Number of points.
+    uint32_t m_PointCount = 0;
+    /// Offset of the first point record from the beginning of the file.
+    size_t m_PointOffset = 0;
+    /// Size of a point record.
+    uint32_t m_RecordLength = 0;
+    /// Offset of the RGB channels in a point record, 0 if the format has no color.
+    uint32_t m_ColorOffset = 0;
+    /// Right shift applied to the 16-bit color channels (8, or 0 for 8-bit values).
+    int m_ColorShift = 8;
+    /// Scale of the int32 coordinates.
+    glm::dvec3 m_Scale{1.0};
+    /// Offset of the int32 coordinates, relative to m_Origin.
+    glm::dvec3 m_Offset{0.0};
+    /// Center of the bounding box.
+    glm::dvec3 m_Origin{0.0};
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+/// @brief
+///  Memory mapping of a whole file, read-only or for writing a new file.
+///
+/// The file content is paged in on demand by the OS, so readers can decode it without an intermediate copy.
+class MappedFile
+{
+public:
+    ///  Maps the file in memory.
+    /// @param[in] iFilePath Path to the file to map.
+    explicit MappedFile(const std::filesystem::path &iFilePath);
+
+    ///  Creates (or truncates) a file of the given size and maps it for writing.
+    /// @param[in] iFilePath Path to the file to create.
+    /// @param[in] iSize Size of the file in bytes.
+    MappedFile(const std::filesystem::path &iFilePath, size_t iSize);
+
+    ///  Unmaps the file.
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(MappedFile &&ioFile) noexcept;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile &operator=(MappedFile &&ioFile) noexcept;
+
+    const uint8_t *GetData() const { return m_Data; }
+    /// Only valid for files mapped for writing.
+    uint8_t *GetMutableData() { return const_cast<uint8_t *>(m_Data); }
+    size_t GetSize() const { return m_Size; }
+
+private:
+    ///  Releases the mapping and the file handles.
+    void Close();
+
+    /// First byte of the mapped file.
+    const uint8_t *m_Data = nullptr;
+    /// Size of the mapped file in bytes.
+    size_t m_Size = 0;
+
+#ifdef _WIN32
+    /// File handle.
+    void *m_File = nullptr;
+    /// File mapping handle.
+    void *m_Mapping = nullptr;
+#endif
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Geometry/Mesh.h"
+#include <filesystem>
+
+///  Loads a Wavefront OBJ mesh.
+///
+/// The file is memory mapped and split in ranges of lines parsed by worker threads. Each range de-duplicates its
+/// (position, normal) pairs, the pairs are then merged across ranges with hash maps sharded by thread, and the
+/// vertices and indices are written in one final pass. Polygons are fan triangulated, texture coordinates ignored
+/// and missing normals computed from the faces.
+/// @param[in] iFilePath Path to the OBJ file.
+/// @return Loaded mesh.
+Mesh ReadObjMesh(const std::filesystem::path &iFilePath);
+
+///  Loads a PLY mesh (ASCII or binary little-endian) from its vertex and face elements.
+///
+/// Vertices and faces are decoded in parallel ranges. Binary files made of triangles only are read with fixed-size
+/// records, other binary files fall back to a sequential walk of the faces. PLY vertices are already shared so no
+/// de-duplication is done. Missing normals are computed from the faces.
+/// @param[in] iFilePath Path to the PLY file.
+/// @return Loaded mesh.
+Mesh ReadPlyMesh(const std::filesystem::path &iFilePath);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "IO/CloudReader.h"
+#include <glm/mat4x4.hpp>
+#include <vector>
+
+/// A cloud of a scene, usually a scan station, with its placement.
+struct CloudSource
+{
+    /// Path to the cloud file.
+    std::filesystem::path FilePath;
+    /// Model matrix of the cloud, applied after its origin.
+    glm::mat4 Transform{1.0f};
+};
+
+/// @brief
+///  Reader merging the clouds of a scene into one progressive order.
+///
+/// When each source is in progressive order, any run of consecutive points is a uniform sample of it. The
+/// sources are cut in blocks of BLOCK_SIZE points and the blocks are interleaved by their relative position in their
+/// source: every prefix of the merged cloud holds the same fraction of every source, a step refines all the stations
+/// at once. If a source is in file order, the merged cloud is not shuffled either and is shuffled after the upload.
+/// The index of the source is stored in the Attribute byte of the points, to look up its model matrix.
+class MultiCloudReader : public CloudReader
+{
+public:
+    /// Largest number of sources, the source index is stored on 8 bits.
+    static constexpr uint32_t MAX_SOURCE_COUNT = 256;
+    /// Number of consecutive points of a source in the merged order.
+    static constexpr uint32_t BLOCK_SIZE = 1024;
+
+    ///  Interleaves the blocks of the sources.
+    /// @param[in] iReaders Readers of the sources, at most MAX_SOURCE_COUNT.
+    /// @param[in] iTransforms Model matrix of each source.
+    MultiCloudReader(std::vector<std::unique_ptr<CloudReader>> iReaders, const std::vector<glm::mat4> &iTransforms);
+
+    uint32_t GetPointCount() const override { return m_PointCount; }
+
+    void ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const override;
+
+    ///  Origin of the first source, the other ones are placed relative to it.
+    glm::dvec3 GetOrigin() const override { return m_Readers.front()->GetOrigin(); }
+
+    ///  True if all the sources are shuffled.
+    bool IsShuffled() const override;
+
+    ///  Model matrix of each source, including the offset of its origin from GetOrigin().
+    const std::vector<glm::mat4> &GetTransforms() const { return m_Transforms; }
+
+private:
+    /// A run of points of one source in the merged order.
+    struct Block
+    {
+        /// Index of the first point of the block in the merged cloud.
+        uint32_t First = 0;
+        /// Index of the first point of the block in its source.
+        uint32_t SourceFirst = 0;
+        /// Number of points.
+        uint32_t Count = 0;
+        /// Index of the source.
+        uint32_t Source = 0;
+    };
+
+    /// Readers of the sources.
+    std::vector<std::unique_ptr<CloudReader>> m_Readers;
+    /// Model matrices of the sources.
+    std::vector<glm::mat4> m_Transforms;
+    /// Blocks in merged order.
+    std::vector<Block> m_Blocks;
+    /// Number of points of all the sources.
+    uint32_t m_PointCount = 0;
+};
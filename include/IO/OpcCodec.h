@@ -0,0 +1,34 @@
+#pragma once
+
+#include "IO/OpcFormat.h"
+#include <cstddef>
+#include <vector>
+
+/// @brief
+///  Compression of the .opc chunks (Opc::ENCODING_COMPRESSED).
+///
+/// Positions are quantized relative to the bounding box of the chunk, on 24 bits per axis or on the quantization
+/// grid of the file if it is coarser. Each axis is kept as is or delta encoded along the progressive order, whichever
+/// is smaller. The quantized records keep the 16-byte OptiCloudVertex layout, and each of their 16 bytes (4 per axis,
+/// the 3 colors and the attribute) forms a stream entropy coded with its own rANS model, so colors and the high bytes
+/// of the positions are packed separately from the noisy low bytes.
+///
+/// Chunk layout, little-endian:
+///  - uint32 delta flags, bit a set if axis a is delta encoded;
+///  - uint32 size of each of the 16 streams;
+///  - the streams: 256 uint16 symbol frequencies summing to 4096, then the rANS bytes.
+
+///  Compresses a chunk.
+/// @param[in] iPoints Points of the chunk, iChunk.PointCount elements.
+/// @param[in] iChunk Chunk table entry, with its bounding box.
+/// @param[in] iQuantization Quantization step of the file, 0 if none.
+/// @return Compressed chunk.
+std::vector<uint8_t> EncodeOpcChunk(const OptiCloudVertex *iPoints, const OpcChunk &iChunk, float iQuantization);
+
+///  Decompresses a chunk.
+/// @param[in] iData Compressed chunk.
+/// @param[in] iSize Size of the compressed chunk in bytes.
+/// @param[in] iChunk Chunk table entry, with its bounding box.
+/// @param[in] iQuantization Quantization step of the file, 0 if none.
+/// @param[out] oPoints Decoded points, iChunk.PointCount elements.
+void DecodeOpcChunk(const uint8_t *iData, size_t iSize, const OpcChunk &iChunk, float iQuantization, OptiCloudVertex *oPoints);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Geometry/OptiCloudVertex.h"
+#include <glm/vec3.hpp>
+#include <cstdint>
+
+/// @brief
+///  Native cloud format (.opc), written once from any imported cloud and memory mapped at load.
+///
+/// Layout, little-endian:
+///  - OpcHeader, at offset 0;
+///  - ChunkCount OpcChunk, at ChunkTableOffset;
+///  - the payload at PayloadOffset (page aligned): PointCount OptiCloudVertex, exactly as in the GPU vertex buffer,
+///    already in progressive rendering order, so any prefix of the payload is a uniform sample of the cloud.
+///
+/// With ENCODING_COMPRESSED, the chunks of the payload are compressed independently and found from the chunk table,
+/// see OpcCodec.h.
+namespace Opc
+{
+/// First bytes of the file.
+constexpr char MAGIC[8] = {'O', 'P', 'T', 'I', 'C', 'L', 'D', '\0'};
+/// Current version of the format.
+constexpr uint32_t VERSION = 1;
+/// Number of points in a chunk (4 MiB of OptiCloudVertex), the last chunk may be smaller.
+constexpr uint32_t CHUNK_SIZE = 1 << 18;
+/// Alignment of the payload.
+constexpr uint64_t PAYLOAD_ALIGNMENT = 4096;
+/// The payload is stored as is.
+constexpr uint32_t ENCODING_RAW = 0;
+/// Each chunk of the payload is compressed.
+constexpr uint32_t ENCODING_COMPRESSED = 1;
+} // namespace Opc
+
+/// Header of an .opc file.
+struct OpcHeader
+{
+    /// Opc::MAGIC.
+    char Magic[8];
+    /// Opc::VERSION.
+    uint32_t Version;
+    /// Number of points.
+    uint32_t PointCount;
+    /// Number of points in a chunk.
+    uint32_t ChunkSize;
+    /// Number of chunks.
+    uint32_t ChunkCount;
+    /// World position of the cloud origin, to be added to the stored positions.
+    glm::dvec3 Origin;
+    /// Bounding box of the stored positions.
+    glm::vec3 BoundsMin;
+    glm::vec3 BoundsMax;
+    /// Step of the grid the positions were snapped to, 0 if they are stored unchanged.
+    float Quantization;
+    /// Opc::ENCODING_RAW or Opc::ENCODING_COMPRESSED.
+    uint32_t Encoding;
+    /// Offset of the chunk table from the beginning of the file.
+    uint64_t ChunkTableOffset;
+    /// Offset of the payload from the beginning of the file.
+    uint64_t PayloadOffset;
+};
+static_assert(sizeof(OpcHeader) == 96, "OpcHeader is read straight from the file");
+
+/// Entry of the chunk table.
+struct OpcChunk
+{
+    /// Offset of the chunk from the beginning of the file.
+    uint64_t Offset;
+    /// Number of points in the chunk.
+    uint32_t PointCount;
+    /// Size of the chunk in bytes.
+    uint32_t ByteSize;
+    /// Bounding box of the points of the chunk.
+    glm::vec3 BoundsMin;
+    glm::vec3 BoundsMax;
+};
+static_assert(sizeof(OpcChunk) == 40, "OpcChunk is read straight from the file");
+static_assert(sizeof(OptiCloudVertex) == 16, "The payload is laid out like the GPU vertex buffer");
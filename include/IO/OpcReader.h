@@ -0,0 +1,40 @@
+#pragma once
+
+#include "IO/CloudReader.h"
+#include "IO/MappedFile.h"
+#include "IO/OpcFormat.h"
+
+/// @brief
+///  Reader of the native .opc clouds.
+///
+/// The payload is already in vertex buffer layout and progressive order: reading points is a plain copy from the
+/// mapped file. Compressed payloads are decoded chunk by chunk, by the threads calling ReadPoints().
+class OpcReader : public CloudReader
+{
+public:
+    ///  Maps the file and checks its header and chunk table.
+    /// @param[in] iFilePath Path to the .opc file.
+    explicit OpcReader(const std::filesystem::path &iFilePath);
+
+    uint32_t GetPointCount() const override { return m_Header.PointCount; }
+
+    void ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const override;
+
+    glm::dvec3 GetOrigin() const override { return m_Header.Origin; }
+
+    bool IsShuffled() const override { return true; }
+
+    const OpcHeader &GetHeader() const { return m_Header; }
+
+    ///  Chunk table, GetHeader().ChunkCount entries.
+    const OpcChunk *GetChunks() const { return reinterpret_cast<const OpcChunk *>(m_File.GetData() + m_Header.ChunkTableOffset); }
+
+private:
+    ///  Decodes the compressed chunks overlapping a range of points.
+    void ReadCompressedPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const;
+
+    /// Mapped file.
+    MappedFile m_File;
+    /// Copy of the header.
+    OpcHeader m_Header{};
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "IO/CloudReader.h"
+#include "IO/ProgressiveOrder.h"
+#include <filesystem>
+
+///  Converts a cloud to the native .opc format (see OpcFormat.h).
+///
+/// The points are decoded in parallel and scattered to their place in the progressive order, straight into the
+/// mapped output file: the whole preprocessing is paid once here instead of at each load.
+/// @param[in] iReader Reader of the cloud to convert.
+/// @param[in] iFilePath Path of the .opc file to write.
+/// @param[in] iQuantization Step of the grid the positions are snapped to, 0 to store them unchanged.
+/// @param[in] iCompress True to compress the chunks, see OpcCodec.h. The shuffled cloud is then kept in memory.
+/// @param[in] iOrder Progressive order of the points.
+void WriteOpcCloud(
+    const CloudReader &iReader,
+    const std::filesystem::path &iFilePath,
+    float iQuantization = 0.0f,
+    bool iCompress = false,
+    ProgressiveOrder iOrder = ProgressiveOrder::Random);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief
+///  Header of a PLY file: format and layout of the elements.
+struct PlyHeader
+{
+    /// Encoding of the data following the header.
+    enum class Format
+    {
+        Ascii,
+        BinaryLittleEndian,
+        BinaryBigEndian
+    };
+
+    /// Scalar types of the properties.
+    enum class ScalarType
+    {
+        Int8,
+        UInt8,
+        Int16,
+        UInt16,
+        Int32,
+        UInt32,
+        Float32,
+        Float64
+    };
+
+    /// A property of an element.
+    struct Property
+    {
+        /// Name of the property.
+        std::string Name;
+        /// Type of the property, or of the list items.
+        ScalarType Type = ScalarType::Float32;
+        /// True for list properties.
+        bool IsList = false;
+        /// Type of the list size.
+        ScalarType CountType = ScalarType::UInt8;
+        /// Offset of the property in a binary record, only meaningful before the first list.
+        uint32_t Offset = 0;
+    };
+
+    /// An element (vertex, face, ...).
+    struct Element
+    {
+        /// Name of the element.
+        std::string Name;
+        /// Number of records.
+        uint64_t Count = 0;
+        /// Properties, in file order.
+        std::vector<Property> Properties;
+        /// Size of a binary record, 0 if the element has list properties or no property.
+        uint32_t Stride = 0;
+
+        ///  Finds a property by name.
+        /// @param[in] iNames Accepted names of the property.
+        /// @return Index of the property, -1 if not found.
+        int Find(std::initializer_list<std::string_view> iNames) const;
+    };
+
+    ///  Parses the header at the beginning of a file.
+    /// @param[in] iContent Content of the file.
+    /// @param[in] iFilePath Path of the file, used in error messages.
+    /// @return Parsed header.
+    static PlyHeader Parse(std::string_view iContent, const std::filesystem::path &iFilePath);
+
+    ///  Size in bytes of a type.
+    static uint32_t GetTypeSize(ScalarType iType);
+
+    ///  Reads a little-endian binary scalar.
+    /// @param[in] iData Address of the scalar, no alignment required.
+    /// @param[in] iType Type of the scalar.
+    /// @return Value of the scalar.
+    static double LoadScalar(const uint8_t *iData, ScalarType iType);
+
+    ///  Finds an element by name.
+    /// @param[in] iName Name of the element.
+    /// @return Index of the element, -1 if not found.
+    int FindElement(std::string_view iName) const;
+
+    ///  Offset of an element's data from the beginning of the file.
+    ///  Only binary elements preceded by fixed-size elements can be located without scanning the file.
+    /// @param[in] iElement Index of the element.
+    /// @return Offset of the first record.
+    size_t GetElementOffset(int iElement) const;
+
+    /// Encoding of the data.
+    Format Encoding = Format::Ascii;
+    /// Elements, in file order.
+    std::vector<Element> Elements;
+    /// Offset of the data from the beginning of the file.
+    size_t DataOffset = 0;
+};
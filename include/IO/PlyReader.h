@@ -0,0 +1,54 @@
+#pragma once
+
+#include "IO/CloudReader.h"
+#include "IO/MappedFile.h"
+#include "IO/PlyHeader.h"
+#include <array>
+
+/// @brief
+///  Reader of binary little-endian PLY clouds.
+///
+/// The file is memory mapped and the vertex element is converted point by point to OptiCloudVertex.
+/// Positions are read from the x, y, z properties and colors from red, green, blue (white if absent).
+class PlyReader : public CloudReader
+{
+public:
+    ///  Maps the file and parses its header.
+    /// @param[in] iFilePath Path to the PLY file.
+    explicit PlyReader(const std::filesystem::path &iFilePath);
+
+    uint32_t GetPointCount() const override { return m_PointCount; }
+
+    void ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const override;
+
+private:
+    using ScalarType = PlyHeader::ScalarType;
+
+    /// A scalar property of the vertex element.
+    struct Property
+    {
+        /// Type of the property.
+        ScalarType Type = ScalarType::Float32;
+        /// Offset of the property in a vertex record.
+        uint32_t Offset = 0;
+        /// True if the property exists in the file.
+        bool Found = false;
+    };
+
+    ///  Parses the header and fills the vertex layout.
+    /// @param[in] iFilePath Path to the PLY file, used in error messages.
+    void ParseHeader(const std::filesystem::path &iFilePath);
+
+    /// Mapped file.
+    MappedFile m_File;
+    /// Number of vertices.
+    uint32_t m_PointCount = 0;
+    /// Offset of the first vertex from the beginning of the file.
+    size_t m_VertexOffset = 0;
+    /// Size of one vertex record.
+    uint32_t m_Stride = 0;
+    /// x, y, z properties.
+    std::array<Property, 3> m_Position{};
+    /// red, green, blue properties.
+    std::array<Property, 3> m_Color{};
+};
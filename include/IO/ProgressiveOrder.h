@@ -0,0 +1,32 @@
+#pragma once
+
+#include "IO/CloudReader.h"
+#include <vector>
+
+/// Order of the points of a cloud converted to .opc.
+enum class ProgressiveOrder
+{
+    /// Uniform random order (Permutation): every prefix is a uniform sample, dense areas converge first.
+    Random,
+    /// Round robin over the cells of a coarse grid: every prefix is spatially stratified, sparse areas get as many
+    /// points as dense ones until they run out.
+    Stratified
+};
+
+/// Number of cells per axis of the stratification grid, as a power of two.
+constexpr uint32_t STRATIFICATION_LEVEL = 6;
+
+///  Computes the stratified progressive order of a cloud.
+///
+/// The points are bucketed by the Morton code of their cell in a cubic grid of 2^STRATIFICATION_LEVEL cells per axis
+/// over the cloud bounds, in random order inside each cell. The order takes one point of each occupied cell in Morton
+/// order, then a second one of each cell which has more, and so on. Needs 8 bytes per point.
+/// @param[in] iReader Reader of the cloud.
+/// @return Index of each point of the reader in the progressive order.
+std::vector<uint32_t> ComputeStratifiedOrder(const CloudReader &iReader);
+
+///  Prints the number of pixels covered by the prefixes of the random and of the stratified order of a cloud, the
+///  cloud being projected orthographically on the plane of its two largest extents.
+/// @param[in] iReader Reader of the cloud.
+/// @param[in] iResolution Number of pixels along the largest extent.
+void BenchmarkProgressiveOrders(const CloudReader &iReader, uint32_t iResolution = 1024);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+///  Splits a text in ranges of whole lines, so each range can be parsed by its own thread.
+/// @param[in] iText Text to split.
+/// @param[in] iRangeCount Wanted number of ranges, fewer are returned for short texts.
+/// @return Contiguous ranges covering the text, each one ending after a newline (except the last one).
+std::vector<std::string_view> SplitLines(std::string_view iText, uint32_t iRangeCount);
+
+///  Counts the lines of a text, a last line without newline included.
+/// @param[in] iText Text to scan.
+/// @return Number of lines.
+uint64_t CountLines(std::string_view iText);
+
+///  Skips spaces and tabulations.
+/// @param[in] iCursor Current position.
+/// @param[in] iEnd End of the text.
+/// @return First character which is not a blank.
+inline const char *SkipBlanks(const char *iCursor, const char *iEnd)
+{
+    while (iCursor != iEnd && (*iCursor == ' ' || *iCursor == '\t'))
+        ++iCursor;
+    return iCursor;
+}
+
+///  Skips the rest of the current line, newline included.
+/// @param[in] iCursor Current position.
+/// @param[in] iEnd End of the text.
+/// @return Beginning of the next line.
+inline const char *SkipLine(const char *iCursor, const char *iEnd)
+{
+    while (iCursor != iEnd && *iCursor != '\n')
+        ++iCursor;
+    return iCursor == iEnd ? iEnd : iCursor + 1;
+}
+
+///  Parses a number after optional blanks with std::from_chars (no locale, no allocation).
+/// @param[in,out] ioCursor Current position, moved after the number on success.
+/// @param[in] iEnd End of the text.
+/// @param[out] oValue Parsed value.
+/// @return False if no number could be read.
+template <typename T>
+bool ParseNumber(const char *&ioCursor, const char *iEnd, T &oValue)
+{
+    const char *begin = SkipBlanks(ioCursor, iEnd);
+    // from_chars rejects the explicit plus sign that some exporters write.
+    if (begin != iEnd && *begin == '+')
+        ++begin;
+    const std::from_chars_result result = std::from_chars(begin, iEnd, oValue);
+    if (result.ec != std::errc())
+        return false;
+    ioCursor = result.ptr;
+    return true;
+}
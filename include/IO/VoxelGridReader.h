@@ -0,0 +1,64 @@
+#pragma once
+
+#include "IO/CloudReader.h"
+#include <glm/mat4x4.hpp>
+#include <memory>
+#include <vector>
+
+/// Result of a voxel grid decimation.
+struct VoxelGridStatistics
+{
+    /// Number of points of the source.
+    uint32_t InputCount = 0;
+    /// Number of points kept.
+    uint32_t OutputCount = 0;
+    /// Number of occupied cells.
+    uint64_t CellCount = 0;
+    /// Largest number of source points in a cell.
+    uint32_t MaxCellPointCount = 0;
+    /// Duration of the decimation in seconds.
+    double Seconds = 0.0;
+};
+
+/// @brief
+///  Reader keeping at most N points per cell of a voxel grid, to drop the near duplicates of overlapping scans.
+///
+/// The source is read once at construction by parallel workers which hash the cell of each point into shards; each
+/// shard then keeps the first N points of its cells in source order. Since the source is in progressive order, the
+/// kept points are random representatives and keep that order. Only the indices of the kept points are stored, they
+/// are read back from the source in batches. The construction needs 16 bytes per source point.
+/// Points of a multi-cloud scene are placed in the grid by the model matrix of their source (see MultiCloudReader),
+/// so the duplicates of overlapping stations fall in the same cells.
+class VoxelGridReader : public CloudReader
+{
+public:
+    ///  Decimates a cloud and prints the statistics.
+    /// @param[in] iReader Reader of the source cloud.
+    /// @param[in] iCellSize Size of the cells of the grid.
+    /// @param[in] iPointsPerCell Number of points kept per cell.
+    /// @param[in] iTransforms Model matrix of each source cloud, indexed by the point attribute. Empty if the points
+    ///                        are already in world space.
+    VoxelGridReader(
+        std::unique_ptr<CloudReader> iReader,
+        float iCellSize,
+        uint32_t iPointsPerCell = 1,
+        const std::vector<glm::mat4> &iTransforms = {});
+
+    uint32_t GetPointCount() const override { return static_cast<uint32_t>(m_Kept.size()); }
+
+    void ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const override;
+
+    glm::dvec3 GetOrigin() const override { return m_Reader->GetOrigin(); }
+
+    bool IsShuffled() const override { return m_Reader->IsShuffled(); }
+
+    const VoxelGridStatistics &GetStatistics() const { return m_Statistics; }
+
+private:
+    /// Reader of the source cloud.
+    std::unique_ptr<CloudReader> m_Reader;
+    /// Source indices of the kept points, in increasing order.
+    std::vector<uint32_t> m_Kept;
+    /// Statistics of the decimation.
+    VoxelGridStatistics m_Statistics;
+};
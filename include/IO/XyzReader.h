@@ -0,0 +1,44 @@
+#pragma once
+
+#include "IO/CloudReader.h"
+#include <glm/vec3.hpp>
+#include <vector>
+
+/// @brief
+///  Reader of ASCII XYZ and PTS clouds, one point per line: "x y z [intensity] [r g b]".
+///
+/// Text cannot be decoded at random offsets, so the whole file is parsed when the reader is opened: the mapped file
+/// is split at newlines in one range per thread, each thread parses its range with std::from_chars into its own block
+/// of points, and ReadPoints() copies the blocks straight into the destination. The column layout is taken from the
+/// first point; the point count line of PTS files, comments and lines without three coordinates are skipped. Points
+/// without color are white, positions are stored relative to the first point to keep the float precision.
+class XyzReader : public CloudReader
+{
+public:
+    ///  Maps and parses the file, then prints the parse throughput.
+    /// @param[in] iFilePath Path to the XYZ or PTS file.
+    explicit XyzReader(const std::filesystem::path &iFilePath);
+
+    uint32_t GetPointCount() const override { return m_PointCount; }
+
+    void ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const override;
+
+    glm::dvec3 GetOrigin() const override { return m_Origin; }
+
+private:
+    /// Points parsed from one range of lines.
+    struct Block
+    {
+        /// Index of the first point of the block in the cloud.
+        uint32_t First = 0;
+        /// Parsed points.
+        std::vector<OptiCloudVertex> Points;
+    };
+
+    /// Blocks in file order.
+    std::vector<Block> m_Blocks;
+    /// Number of points.
+    uint32_t m_PointCount = 0;
+    /// Position of the first point.
+    glm::dvec3 m_Origin{0.0};
+};
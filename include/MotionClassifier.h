@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <cstdint>
+
+/// Effect of a camera change on the progressive drawing.
+enum class CameraMotion
+{
+    /// Same view as the previous frame: the refinement continues.
+    Still,
+    /// The reprojected points still cover the image: the refinement continues.
+    Small,
+    /// Parts of the image are uncovered: the last points drawn are drawn again to fill them.
+    Medium,
+    /// The reprojected points are of little use: the drawing restarts.
+    Large
+};
+
+/// @brief
+///  Classifies the camera motion between two frames by its displacement on screen.
+///
+/// A grid of probe points is placed in the previous view, at the distance of the scene origin, and reprojected with
+/// the new view. Their largest displacement in pixels gives the class. The probe distance makes the translations
+/// count in proportion to the size of the scene, whatever its unit.
+class MotionClassifier
+{
+public:
+    /// Largest displacement of a small motion, in pixels.
+    static constexpr float SMALL_MOTION_PIXELS = 4.0f;
+    /// Smallest displacement of a large motion, in pixels.
+    static constexpr float LARGE_MOTION_PIXELS = 64.0f;
+
+    ///  Compares the view to the one of the previous call.
+    /// @param[in] iView View matrix.
+    /// @param[in] iProj Projection matrix.
+    /// @param[in] iWidth Width of the image in pixels.
+    /// @param[in] iHeight Height of the image in pixels.
+    /// @return Class of the motion, Large on the first call.
+    CameraMotion Update(const glm::mat4 &iView, const glm::mat4 &iProj, uint32_t iWidth, uint32_t iHeight);
+
+    ///  Largest displacement measured by the last Update(), in pixels.
+    float GetDisplacement() const { return m_Displacement; }
+
+    ///  Forgets the previous view: the next Update() returns Large.
+    void Reset() { m_HasPrevious = false; }
+
+private:
+    /// View and projection of the previous call.
+    glm::mat4 m_PreviousView{1.0f};
+    glm::mat4 m_PreviousProj{1.0f};
+    bool m_HasPrevious = false;
+    /// Displacement measured by the last call.
+    float m_Displacement = 0.0f;
+};
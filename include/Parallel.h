@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///  Number of worker threads used by the parallel loaders.
+/// @return Hardware concurrency, at least 1.
+inline uint32_t GetWorkerCount()
+{
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+///  Runs iTask(i) for each i in [0, iTaskCount), one thread per task, and waits for all of them.
+///  The first exception thrown by a task is rethrown once every thread has joined.
+/// @param[in] iTaskCount Number of tasks.
+/// @param[in] iTask Callable taking the task index.
+template <typename Task>
+void ParallelFor(uint32_t iTaskCount, Task &&iTask)
+{
+    if (iTaskCount == 1)
+    {
+        iTask(0u);
+        return;
+    }
+
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::vector<std::thread> threads;
+    threads.reserve(iTaskCount);
+    for (uint32_t i = 0; i < iTaskCount; ++i)
+    {
+        threads.emplace_back([&, i]()
+                             {
+                                 try
+                                 {
+                                     iTask(i);
+                                 }
+                                 catch (...)
+                                 {
+                                     std::lock_guard<std::mutex> lock(errorMutex);
+                                     if (!error)
+                                         error = std::current_exception();
+                                 }
+                             });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/// @brief
+///  Keyed pseudo-random bijection of [0, N), used to shuffle the clouds into their progressive order.
+///
+/// The indices are encrypted by a balanced Feistel network on the smallest even number of bits covering N; the
+/// values falling outside of [0, N) are encrypted again until they come back in range (cycle walking). The domain is
+/// less than 4N, so this takes less than 4 rounds of the network on average. Any N up to 2^32 - 1 is supported with a
+/// few words of state, and each index is permuted independently, on any thread or in a compute shader
+/// (shaders/permutation.glsl implements the same function from GetHalfBits() and GetKeys()).
+class Permutation
+{
+public:
+    /// Number of rounds of the Feistel network.
+    static constexpr uint32_t ROUND_COUNT = 4;
+
+    ///  Builds a permutation.
+    /// @param[in] iCount Number of elements N.
+    /// @param[in] iSeed Seed of the round keys, the same seed gives the same permutation.
+    explicit Permutation(uint32_t iCount, uint64_t iSeed = 0x9e3779b97f4a7c15ull);
+
+    ///  Permutes an index.
+    /// @param[in] iIndex Index in [0, N).
+    /// @return Permuted index in [0, N).
+    uint32_t operator()(uint32_t iIndex) const
+    {
+        if (m_Count <= 1)
+            return iIndex;
+        uint32_t index = Encrypt(iIndex);
+        while (index >= m_Count)
+            index = Encrypt(index);
+        return index;
+    }
+
+    uint32_t GetCount() const { return m_Count; }
+
+    /// Number of bits of each half of the Feistel network, the domain is [0, 2^(2 * GetHalfBits())).
+    uint32_t GetHalfBits() const { return m_HalfBits; }
+
+    const std::array<uint32_t, ROUND_COUNT> &GetKeys() const { return m_Keys; }
+
+private:
+    ///  One pass through the Feistel network, a bijection of the whole domain.
+    uint32_t Encrypt(uint32_t iValue) const
+    {
+        const uint32_t mask = (1u << m_HalfBits) - 1;
+        uint32_t left = iValue >> m_HalfBits;
+        uint32_t right = iValue & mask;
+        for (uint32_t key : m_Keys)
+        {
+            const uint32_t next = left ^ (Round(right, key) & mask);
+            left = right;
+            right = next;
+        }
+        return left << m_HalfBits | right;
+    }
+
+    ///  Round function: a 32-bit integer hash of the half block and the round key.
+    static uint32_t Round(uint32_t iValue, uint32_t iKey)
+    {
+        iValue ^= iKey;
+        iValue ^= iValue >> 16;
+        iValue *= 0x7feb352du;
+        iValue ^= iValue >> 15;
+        iValue *= 0x846ca68bu;
+        iValue ^= iValue >> 16;
+        return iValue;
+    }
+
+    /// Number of elements.
+    uint32_t m_Count;
+    /// Number of bits of each half.
+    uint32_t m_HalfBits = 1;
+    /// Round keys.
+    std::array<uint32_t, ROUND_COUNT> m_Keys{};
+};
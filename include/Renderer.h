@@ -1,10 +1,15 @@
 #pragma once
 
 #include "Vulkan/ComputePass.h"
+#include "Vulkan/FrameScheduler.h"
+#include "Vulkan/PointRasterizer.h"
+#include "Vulkan/SecondaryCommandBuffers.h"
+#include "Vulkan/TimestampQueries.h"
 #include "Geometry/OptiCloudVertex.h"
 #include "Geometry/VkMesh.h"
 #include "Geometry/VkCloud.h"
 #include "Geometry/VkOptiCloud.h"
+#include "IO/MultiCloudReader.h"
 #include "Olympus/Instance.h"
 #include "Olympus/CloudPipeline.h"
 #include "Olympus/MeshPipeline.h"
@@ -17,8 +22,13 @@
 #include "Olympus/Swapchain.h"
 #include "Olympus/Texture.h"
 #include "Olympus/UniformBuffer.h"
+#include "ConvergenceTracker.h"
+#include "MotionClassifier.h"
+#include "StepController.h"
 #include <glm/glm.hpp>
+#include <future>
 #include <memory>
+#include <vector>
 
 class Camera;
 
@@ -55,10 +65,20 @@ struct PointSize
     uint32_t Size;
 };
 
+struct CloudTransforms
+{
+    glm::mat4 Model[MultiCloudReader::MAX_SOURCE_COUNT];
+};
+
 struct UniformBuffers
 {
-    olp::UniformBuffer Model;
-    olp::UniformBuffer Camera;
+    /// Written each frame, one copy per swapchain image: the copy of an image is only written once the last frame
+    /// drawn to it is finished.
+    std::vector<olp::UniformBuffer> Model;
+    std::vector<olp::UniformBuffer> Camera;
+    std::vector<olp::UniformBuffer> CloudTransforms;
+    /// Cloud transforms read by the prepare pass, one copy per frame in flight.
+    std::vector<olp::UniformBuffer> PrepareCloudTransforms;
     olp::UniformBuffer ScreenSize;
     olp::UniformBuffer Lighting;
     olp::UniformBuffer PointSize;
@@ -98,10 +118,25 @@ public:
     void RecreatePipelines();
 
     /// @brief
-    ///  Imports & adds a cloud to be rendered.
+    ///  Imports & adds a cloud to be rendered. Returns immediately: the file is opened on a background thread and
+    ///  uploaded while the current cloud is still drawn, the new cloud replaces it once its upload is submitted.
     /// @param iFilePath Path to the mesh to be imported.
     void AddCloud(const std::filesystem::path &iFilePath);
 
+    /// @brief
+    ///  Imports clouds placed by their own model matrix, typically the stations of a scan, and renders them as one
+    ///  optimize cloud whose steps refine all the clouds at once. Returns immediately, as AddCloud().
+    /// @param iSources Clouds of the scene.
+    /// @param iVoxelSize Size of the voxel grid decimating the scene at import (see VoxelGridReader), 0 to keep all
+    ///                   the points.
+    /// @param iPointsPerVoxel Number of points kept per voxel.
+    void AddClouds(const std::vector<CloudSource> &iSources, float iVoxelSize = 0.0f, uint32_t iPointsPerVoxel = 1);
+
+    /// @brief
+    ///  Imports & adds a mesh to be rendered.
+    /// @param iFilePath Path to the OBJ or PLY mesh to be imported.
+    void AddMesh(const std::filesystem::path &iFilePath);
+
     /// @brief
     ///  Enables [3-point lighting](https://en.wikipedia.org/wiki/Three-point_lighting).
     /// @param iEnabled True to enable, false to disable.
@@ -123,13 +158,58 @@ public:
     void UpdatePointSize(uint32_t iPointSize);
 
     /// @brief
-    ///  Sets the number of points to be loaded each step.
+    ///  Sets the number of points to be loaded each step, and stops adapting it to the frame time.
     /// @param iPointCount New points by step count.
     void UpdatePointsByStep(uint32_t iPointCount);
 
-    ///  Renders the next frame.
+    /// @brief
+    ///  Adapts the number of points drawn each step to reach a GPU frame time, measured by timestamps around the
+    ///  frame, the optimize cloud draw and the prepare pass (see StepController). 16 ms by default.
+    /// @param iMilliseconds Frame time target, 0 to keep the current step size.
+    void SetFrameTimeTarget(float iMilliseconds);
+
+    /// @brief
+    ///  Chooses how the points of the optimize cloud are drawn. The compute rasterization (see PointRasterizer) is
+    ///  kept off if it is not built or if the device lacks 64-bit buffer atomics.
+    /// @param iRasterization Point backend.
+    void SetPointRasterization(PointRasterization iRasterization);
+
+    /// @brief
+    ///  Fills the holes between the points drawn by the compute rasterization with a push-pull, so the splats grow
+    ///  where the points are sparse (see HoleFillingPass). The hardware points keep the fixed point size.
+    ///  Disabled by default.
+    /// @param iEnabled True to fill the holes.
+    void EnableHoleFilling(bool iEnabled = true);
+
+    /// @brief
+    ///  Records the command buffer of each swapchain image once, and submits it again until the scene, the pipelines
+    ///  or the swapchain change. The per-frame data travels through the uniform buffers and the step counter of the
+    ///  optimize cloud. An out-of-core cloud, whose steps are chosen while recording, is recorded every frame.
+    ///  Enabled by default.
+    /// @param iEnabled False to record the command buffers every frame.
+    void EnableCommandBufferReuse(bool iEnabled = true);
+
+    /// @brief
+    ///  Renders the next frame. Once the image has converged (see ConvergenceTracker), nothing is submitted and the
+    ///  last image stays presented until the view, the scene or a rendering parameter changes.
     void DrawNextFrame(const glm::mat4 &iView, const glm::mat4 &iProj);
 
+    /// @brief
+    ///  Sets the number of frames the host may submit before waiting for the oldest one, 2 by default. More frames
+    ///  hide longer GPU stalls at the cost of latency.
+    /// @param iFrameCount Number of frames in flight, at least 1.
+    void SetFramesInFlight(uint32_t iFrameCount);
+
+    /// @brief
+    ///  Prints, every OVERLAP_REPORT_FRAMES frames, the average GPU time of the prepare pass, the part of it run
+    ///  while the graphics queue already executes the next frame, and the time the host waited for a frame in
+    ///  flight. Disabled by default.
+    /// @param iEnabled True to print the report.
+    void EnableOverlapReport(bool iEnabled = true);
+
+    ///  True while the image has converged and DrawNextFrame() submits nothing: the caller may wait for events.
+    bool IsIdle() const { return m_Convergence.IsConverged(); }
+
 protected:
     ///  Creates swapchain resources (pipelines, framebuffers, descriptors, ...).
     void CreateSwapchainRessources();
@@ -163,7 +243,7 @@ protected:
     void CreateCommandBuffers();
 
     /// @brief
-    ///  Creates the synchronization objets.
+    ///  Creates the frame scheduler and the per-frame state of the renderer, for m_FramesInFlight frames.
     void CreateSyncObjects();
 
     /// @brief
@@ -178,14 +258,52 @@ protected:
     ///  Creates the pipelines.
     void CreatePipelines();
 
-    ///  Updates the camera's uniform buffers.
-    void UpdateUniformBuffers(const glm::mat4 &iView, const glm::mat4 &iProj);
+    ///  Advances the background loading of the cloud given to AddCloud(), and makes it the drawn cloud when ready.
+    void UpdateCloudLoading();
+
+    ///  Replaces the drawn cloud by the loaded one.
+    void JoinLoadedCloud();
+
+    ///  Replaces the drawn cloud, once the frames drawing it are finished.
+    /// @param[in] iCloud New cloud to draw.
+    void ReplaceCloud(std::unique_ptr<VkOptiCloud> iCloud);
+
+    ///  Advances the streaming of the drawn cloud. A cloud whose file can not be read is replaced by a placeholder.
+    /// @param[in,out] ioPrepareSemaphore Semaphore of the last prepare pass, to wait on before the draws. It may be
+    ///                                   replaced by the one of the copies of the streaming, see
+    ///                                   VkOptiCloud::UpdateStreaming().
+    void UpdateCloudStreaming(VkSemaphore &ioPrepareSemaphore);
+
+    ///  Measures the overlap of the finished prepare pass with the next graphics frame, see EnableOverlapReport().
+    void UpdatePrepareOverlap();
+
+    ///  Feeds the timestamps of the finished frame to the step controller.
+    /// @param iIndex Index of the swapchain image the frame was drawn to.
+    void UpdateStepSize(uint32_t iIndex);
+
+    ///  Updates the camera's uniform buffers, and rewinds the progressive drawing by the camera motion.
+    /// @param iIndex Index of the swapchain image of the frame, whose last frame is finished.
+    /// @param iFrame Slot of the frame in flight.
+    /// @return Class of the camera motion since the previous frame.
+    CameraMotion UpdateUniformBuffers(const glm::mat4 &iView, const glm::mat4 &iProj, uint32_t iIndex, uint32_t iFrame);
 
     /// @brief
     ///  Builds the command buffer at the given index.
     /// @param iIndex Index of the command buffer to build.
     void BuildCommandBuffer(uint32_t iIndex);
 
+    /// @brief
+    ///  Records the draws of the final subpass, the meshes then the clouds, numbered from 0.
+    /// @param iCommandBuffer Secondary command buffer of the final subpass.
+    /// @param iIndex Index of the swapchain image.
+    /// @param iFirst First draw.
+    /// @param iCount Number of draws.
+    void RecordFinalSubpassDraws(VkCommandBuffer iCommandBuffer, uint32_t iIndex, uint32_t iFirst, uint32_t iCount);
+
+    /// @brief
+    ///  Makes the next frames record their command buffer again, after a change of the recorded commands.
+    void InvalidateCommandBuffers();
+
     /// @brief
     ///  Finds the appropriate depth format.
     /// @return Chosen depth format.
@@ -196,8 +314,8 @@ protected:
     /// Swapchain.
     olp::Swapchain m_Swapchain;
 
-    /// Descriptor of the main render pass (cloud , mesh and optimize cloud).
-    olp::DescriptorSet m_MainPassDescriptor;
+    /// Descriptors of the main render pass (cloud , mesh and optimize cloud), one per swapchain image.
+    std::vector<olp::DescriptorSet> m_MainPassDescriptors;
     /// Descriptor of the gradient pass.
     olp::DescriptorSet m_GradientPassDescriptor;
     /// Descriptor pool.
@@ -217,28 +335,41 @@ protected:
     olp::CloudPipeline<CloudVertex> m_CloudPipeline;
     /// Mesh pipeline.
     olp::MeshPipeline<MeshVertex> m_MeshPipeline;
+    /// Resolve of the compute rasterized points. (Render a quad, so need a mesh pipeline).
+    olp::MeshPipeline<MeshVertex> m_ResolvePipeline;
 
     /// Graphics render pass.
     VkRenderPass m_RenderPass = VK_NULL_HANDLE;
 
     /// Command buffer for the graphics queue. ( 1 by framebuffer of the swapchain).
     std::vector<olp::CommandBuffer> m_CommandBuffers{};
+    /// True for the command buffers which can be submitted again without recording them.
+    std::vector<bool> m_RecordedCommandBuffers{};
+    /// False to record the command buffers every frame.
+    bool m_CommandBufferReuse = true;
+    /// Draws of the final subpass, recorded by worker threads.
+    std::unique_ptr<SecondaryCommandBuffers> m_FinalSubpassCommandBuffers;
 
     /// Compute pass for the optimize cloud rendering.
     ComputePass m_PreparePass;
-
-    /// Maximum number of frames to calculate in parallel.
-    static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-    /// Semaphore to know if the current image is available. Already presented by the swapchain.
-    std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> m_ImageAvailableSemaphores{};
-    /// Semaphore to know if the rendering is finished for current image.
-    std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> m_RenderFinishedSemaphores{};
-    /// Fence to synchronize GPU/CPU for update uniform buffer.
-    std::array<VkFence, MAX_FRAMES_IN_FLIGHT> m_InFlightFences{};
-    std::vector<VkFence> m_ImagesInFlight{};
-    /// Current frame index in the swapchain
-    size_t m_CurrentFrame = 0;
+    /// Point backend of the optimize cloud.
+    PointRasterization m_PointRasterization = PointRasterization::Hardware;
+    /// Compute rasterization of the optimize cloud, null with hardware points.
+    std::unique_ptr<PointRasterizer> m_PointRasterizer;
+    /// True to fill the holes between the points of the compute rasterization.
+    bool m_HoleFilling = false;
+
+    /// Default number of frames to calculate in parallel.
+    static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+    /// Number of frames to calculate in parallel.
+    uint32_t m_FramesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+
+    /// Numbers the frames and owns their synchronisation objects.
+    std::unique_ptr<FrameScheduler> m_FrameScheduler;
+    /// Number of the last frame drawn to each swapchain image, 0 for none.
+    std::vector<uint64_t> m_ImageFrames;
+    /// Swapchain image drawn by each frame in flight.
+    std::vector<uint32_t> m_FrameImages;
 
     /// Depth buffer image.
     olp::Image m_DepthBuffer;
@@ -253,7 +384,49 @@ protected:
     std::unique_ptr<VkMesh> m_Quad;
     /// Optimize cloud to draw.
     std::unique_ptr<VkOptiCloud> m_OptiCloud;
+    /// Cloud opened in the background by AddClouds().
+    struct OpenedCloud
+    {
+        /// Reader of the merged scene.
+        std::unique_ptr<CloudReader> Reader;
+        /// Model matrix of each cloud of the scene.
+        std::vector<glm::mat4> Transforms;
+    };
+    /// Cloud being opened by AddClouds(), invalid when no cloud is being opened.
+    std::future<OpenedCloud> m_CloudReader;
+    /// Cloud being uploaded, drawn once joined.
+    std::unique_ptr<VkOptiCloud> m_LoadingCloud;
+    /// Signaled by the upload of the joined cloud, waited by the next frame which then retires it.
+    VkSemaphore m_CloudUploadSemaphore = VK_NULL_HANDLE;
 
     /// Uniform buffers.
     UniformBuffers m_UniformBuffers;
+
+    /// Timestamps of each swapchain image: frame begin, step draw begin and end, frame end.
+    static constexpr uint32_t TIMESTAMPS_PER_FRAME = 4;
+    std::unique_ptr<TimestampQueries> m_Timestamps;
+    /// Adapts the step size to the frame time.
+    StepController m_StepController;
+    /// Classifies the camera motion of each frame.
+    MotionClassifier m_MotionClassifier;
+    /// Sums of the prepare pass timings since the last overlap report, in milliseconds.
+    struct OverlapStats
+    {
+        double Prepare = 0.0;
+        double Overlap = 0.0;
+        double HostWait = 0.0;
+        uint32_t FrameCount = 0;
+        /// GPU times of the last prepare pass read, to pair with the next graphics frame.
+        bool HasPrepareTimes = false;
+        double PrepareBegin = 0.0;
+        double PrepareEnd = 0.0;
+    };
+    /// Number of frames averaged by an overlap report.
+    static constexpr uint32_t OVERLAP_REPORT_FRAMES = 300;
+    bool m_OverlapReport = false;
+    OverlapStats m_OverlapStats;
+    /// Detects the convergence of the image, and the view it converged with.
+    ConvergenceTracker m_Convergence;
+    glm::mat4 m_ConvergedView{1.0f};
+    glm::mat4 m_ConvergedProj{1.0f};
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief
+///  Chooses the number of points drawn at each step of the optimize cloud to fill a GPU frame time target.
+///
+/// The frame is modeled as a fixed cost plus a cost per drawn point, both smoothed over the measured frames. The step
+/// is only changed when the predicted frame time leaves the hysteresis band around the target, and by at most a factor
+/// of 2 per frame, so measurement noise does not make it oscillate.
+class StepController
+{
+public:
+    /// Bounds of the step size.
+    static constexpr uint32_t MIN_POINT_COUNT = 10'000;
+    static constexpr uint32_t MAX_POINT_COUNT = 20'000'000;
+    /// Relative distance to the target tolerated before the step changes.
+    static constexpr double HYSTERESIS = 0.1;
+    /// Weight of the last frame in the smoothed costs.
+    static constexpr double SMOOTHING = 0.2;
+
+    ///  Sets the GPU frame time to reach, 0 to keep the step size.
+    void SetTarget(double iMilliseconds) { m_Target = iMilliseconds; }
+    double GetTarget() const { return m_Target; }
+    bool IsEnabled() const { return m_Target > 0.0; }
+
+    ///  Feeds the timings of a finished frame.
+    /// @param[in] iStepPointCount Current step size.
+    /// @param[in] iDrawnPointCount Number of points drawn by the frame, no update if 0.
+    /// @param[in] iFrameMilliseconds GPU time of the whole frame.
+    /// @param[in] iDrawMilliseconds GPU time of the step draw.
+    /// @return Step size for the next frames.
+    uint32_t Update(uint32_t iStepPointCount, uint32_t iDrawnPointCount, double iFrameMilliseconds, double iDrawMilliseconds);
+
+private:
+    /// GPU frame time to reach, 0 if disabled.
+    double m_Target = 16.0;
+    /// Smoothed cost of a point and of the rest of the frame, in milliseconds. Negative before the first frame.
+    double m_PointCost = -1.0;
+    double m_FixedCost = 0.0;
+};
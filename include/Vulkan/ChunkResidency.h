@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Vulkan/ChunkStreamer.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+///  Keeps a working set of the chunks of a cloud larger than the device memory.
+///
+/// The vertex buffer is split in slots of ChunkStreamer::CHUNK_SIZE points. Missing chunks are streamed into free
+/// slots, or into the slot of the least recently drawn chunk. The progressive drawing only walks the resident chunks:
+/// a chunk of a pre-shuffled cloud is a uniform sample of it, so the chunks can be drawn in any order.
+///
+/// The reprojected points keep the index of their vertex, and the prepare pass reads them again from the vertex buffer
+/// at each frame. An evicted slot is first marked in the resident slots read by the prepare pass, which drops its
+/// points from the reprojection. Its refill is decoded meanwhile, and its copy waits for the prepare pass submitted
+/// after the eviction: no pixel references the slot any more when it is overwritten.
+class ChunkResidency
+{
+public:
+    ///  Starts streaming the first chunks.
+    /// @param[in] iDevice Device owning the vertex buffer.
+    /// @param[in] iReader Reader of the cloud file.
+    /// @param[in] iDstBuffer Vertex buffer of iSlotCount * CHUNK_SIZE points.
+    /// @param[in] iSlotCount Number of chunks held by the vertex buffer.
+    /// @param[in] iResidentSlots Mapped buffer of iSlotCount flags read by the prepare pass, all 0. A flag is 1 while
+    ///                           the points of its slot can be reprojected.
+    ChunkResidency(
+        const olp::Device &iDevice,
+        std::unique_ptr<CloudReader> iReader,
+        VkBuffer iDstBuffer,
+        uint32_t iSlotCount,
+        uint32_t *iResidentSlots);
+
+    ///  Retires the finished uploads and requests the chunks missing for the current pass, evicting the least
+    ///  recently drawn ones. To call once per frame, before recording the draws.
+    /// @param[in,out] ioPrepareSemaphore Semaphore signaled by the last prepare pass, see ChunkStreamer::Update().
+    void Update(VkSemaphore &ioPrepareSemaphore);
+
+    ///  Starts a new pass over the cloud. The resident chunks are drawn first.
+    void ResetPass();
+
+    ///  Draws the next points of the pass from the resident chunks.
+    /// @param[in] iRecordRange Records the draw of iCount points of the vertex buffer from iFirst.
+    /// @param[in] iPointCount Maximum number of points to draw.
+    /// @return Number of points drawn, less than iPointCount if the resident chunks are exhausted.
+    uint32_t DrawNext(const std::function<void(uint32_t iFirst, uint32_t iCount)> &iRecordRange, uint32_t iPointCount);
+
+    ///  True once every chunk has been drawn during the current pass.
+    bool IsPassFinished() const { return m_DrawnChunkCount == m_Chunks.size(); }
+
+private:
+    /// Residency of a chunk.
+    struct Chunk
+    {
+        /// Slot holding the chunk, -1 if not resident.
+        int32_t Slot = -1;
+        /// True while the chunk is uploaded to its slot.
+        bool Loading = false;
+        /// True once the chunk has been fully drawn during the current pass.
+        bool Drawn = false;
+        /// Value of m_Clock when the chunk was last drawn.
+        uint64_t LastDrawn = 0;
+    };
+
+    ///  Requests the chunks missing for the current pass.
+    void RequestChunks();
+
+    ///  Finds a slot for a new chunk: a free one, or the one of the least recently drawn chunk already drawn during
+    ///  the pass.
+    /// @return Slot index, -1 if all slots hold chunks still needed.
+    int32_t AcquireSlot();
+
+    /// Streams the chunks to the slots.
+    ChunkStreamer m_Streamer;
+    /// Residency of each chunk.
+    std::vector<Chunk> m_Chunks;
+    /// Chunk held by each slot, -1 if free.
+    std::vector<int32_t> m_SlotChunks;
+    /// Flag of each slot read by the prepare pass, 1 once the chunk of the slot is copied, 0 from its eviction.
+    uint32_t *m_ResidentSlots = nullptr;
+
+    /// Chunk being drawn, -1 if none.
+    int32_t m_CurrentChunk = -1;
+    /// Number of points of the current chunk already drawn.
+    uint32_t m_CurrentOffset = 0;
+    /// Number of chunks fully drawn during the pass.
+    uint32_t m_DrawnChunkCount = 0;
+    /// Incremented at each draw, orders the chunks for eviction.
+    uint64_t m_Clock = 0;
+};
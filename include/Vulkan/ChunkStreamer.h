@@ -0,0 +1,171 @@
+#pragma once
+
+#include "IO/CloudReader.h"
+#include "Olympus/Device.h"
+#include "Olympus/MemoryBuffer.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+///  Streams the chunks of a cloud to a device vertex buffer.
+///
+/// Requested chunks are decoded by threads into a ring of staging slots while Update() copies them to the vertex
+/// buffer, so the loaded points can be drawn while the rest of the file is still being read.
+///
+/// The copies go to the graphics queue, or to the asynchronous queue for a cloud loaded in the background: the last
+/// copy then releases the vertex buffer to the graphics family and signals a semaphore that the first frame drawing
+/// the cloud waits on.
+class ChunkStreamer
+{
+public:
+    /// Number of points in a chunk (4 MiB of OptiCloudVertex).
+    static constexpr uint32_t CHUNK_SIZE = 1 << 18;
+
+    ///  Starts the decoder threads, idle until the first request.
+    /// @param[in] iDevice Device owning the vertex buffer.
+    /// @param[in] iReader Reader of the cloud file.
+    /// @param[in] iDstBuffer Vertex buffer the chunks are copied to.
+    /// @param[in] iAsyncQueue True to copy on the asynchronous queue, for a cloud which is not drawn yet.
+    ChunkStreamer(const olp::Device &iDevice, std::unique_ptr<CloudReader> iReader, VkBuffer iDstBuffer, bool iAsyncQueue = false);
+
+    ///  Stops the decoder threads and waits for the pending copies.
+    ~ChunkStreamer();
+
+    ChunkStreamer(const ChunkStreamer &) = delete;
+    ChunkStreamer &operator=(const ChunkStreamer &) = delete;
+
+    uint32_t GetChunkCount() const { return m_ChunkCount; }
+
+    ///  Number of points in a chunk, CHUNK_SIZE except for the last one.
+    uint32_t GetChunkPointCount(uint32_t iChunk) const;
+
+    ///  Number of staging slots, i.e. of chunks decoded at the same time.
+    uint32_t GetSlotCount() const { return static_cast<uint32_t>(m_Slots.size()); }
+
+    ///  Queues the upload of a chunk. Chunks are decoded in request order.
+    /// @param[in] iChunk Chunk to upload.
+    /// @param[in] iDstOffset Offset of the chunk in the vertex buffer, in bytes.
+    void Request(uint32_t iChunk, VkDeviceSize iDstOffset);
+
+    ///  Number of requested chunks whose copy is not finished.
+    uint32_t GetPendingCount() const { return m_PendingCount; }
+
+    ///  True once the copies of all the requested chunks are submitted.
+    bool IsSubmitted() const { return m_SubmittedCount == m_RequestedCount; }
+
+    ///  Semaphore signaled by the last copy on the asynchronous queue, once IsSubmitted(). The caller becomes its
+    ///  owner and must wait on it before drawing the cloud.
+    VkSemaphore TakeSemaphore() { return std::exchange(m_Semaphore, VK_NULL_HANDLE); }
+
+    ///  Records the acquisition of the vertex buffer by the graphics family, matching the release done by the
+    ///  last copy. Nothing is recorded if the copies use the graphics family.
+    /// @param[in] iCommandBuffer Graphics command buffer, outside of a render pass.
+    void RecordAcquire(VkCommandBuffer iCommandBuffer) const;
+
+    ///  Retires the finished copies and submits the chunks decoded since the last call. Never blocks.
+    ///  The copies wait for the draws submitted before them: a slot of the vertex buffer can be reused for another chunk
+    ///  as soon as no command buffer recorded afterwards draws it.
+    ///  Rethrows the exception of a chunk which failed to decode: the load can not complete, and the streamer must be
+    ///  destroyed.
+    /// @return Chunks whose copy finished since the last call.
+    std::vector<uint32_t> Update();
+
+    ///  Same as Update(), for the copies overwriting slots that the prepare pass may still read on the compute queue.
+    /// @param[in,out] ioPrepareSemaphore Semaphore signaled by the last prepare pass, that the next graphics
+    ///                                   submission waits on, VK_NULL_HANDLE if none. The copies on the graphics queue
+    ///                                   wait on it, and replace it with a semaphore they signal, owned by the streamer.
+    /// @return Chunks whose copy finished since the last call.
+    std::vector<uint32_t> Update(VkSemaphore &ioPrepareSemaphore);
+
+private:
+    /// State of a staging slot.
+    enum class SlotState
+    {
+        Free,
+        Decoding,
+        Decoded,
+        Uploading
+    };
+
+    /// A staging slot, holding one chunk.
+    struct Slot
+    {
+        /// Chunk held by the slot.
+        uint32_t Chunk = 0;
+        /// Destination of the chunk in the vertex buffer.
+        VkDeviceSize DstOffset = 0;
+        /// State of the slot.
+        SlotState State = SlotState::Free;
+    };
+
+    /// Copies submitted together.
+    struct Submission
+    {
+        /// Command buffer holding the copies.
+        VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+        /// Signaled when the copies are done.
+        VkFence Fence = VK_NULL_HANDLE;
+        /// Slots released by the copies.
+        std::vector<uint32_t> Slots;
+    };
+
+    ///  Body of the decoder threads.
+    void DecodeLoop();
+
+    ///  Records and submits the copy of the given slots.
+    /// @param[in] iSlots Decoded slots.
+    /// @param[in,out] ioPrepareSemaphore See Update().
+    void Submit(std::vector<uint32_t> iSlots, VkSemaphore &ioPrepareSemaphore);
+
+    /// Vulkan device.
+    const olp::Device &m_Device;
+    /// Reader of the cloud file.
+    std::unique_ptr<CloudReader> m_Reader;
+    /// Destination vertex buffer.
+    VkBuffer m_DstBuffer = VK_NULL_HANDLE;
+    /// Number of chunks in the cloud.
+    uint32_t m_ChunkCount = 0;
+
+    /// Host visible ring of slots, CHUNK_SIZE points each.
+    olp::MemoryBuffer m_StagingBuffer;
+    /// Persistent mapping of the staging buffer.
+    OptiCloudVertex *m_StagingData = nullptr;
+    /// Queue of the copies and its family.
+    VkQueue m_Queue = VK_NULL_HANDLE;
+    uint32_t m_QueueFamily = 0;
+    /// Family of the queue drawing the cloud.
+    uint32_t m_GraphicsFamily = 0;
+    /// Signaled by the last copy on the asynchronous queue.
+    VkSemaphore m_Semaphore = VK_NULL_HANDLE;
+    /// Signaled by the copies on the graphics queue which waited for the prepare pass, in its place.
+    VkSemaphore m_PrepareSemaphore = VK_NULL_HANDLE;
+    /// Command pool of the copies.
+    VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+    /// Copies in flight, in submission order.
+    std::deque<Submission> m_Submissions;
+
+    /// Staging slots, guarded by m_Mutex.
+    std::vector<Slot> m_Slots;
+    /// Chunks to hand to the decoder threads with their destination, guarded by m_Mutex.
+    std::deque<std::pair<uint32_t, VkDeviceSize>> m_Requests;
+    /// Asks the decoder threads to return, guarded by m_Mutex.
+    bool m_Stop = false;
+    /// First exception thrown by the reader in a decoder thread, guarded by m_Mutex.
+    std::exception_ptr m_Error;
+    std::mutex m_Mutex;
+    /// Notified when a chunk is requested or a slot is released.
+    std::condition_variable m_WorkAvailable;
+    /// Decoder threads.
+    std::vector<std::thread> m_Threads;
+
+    /// Number of requested chunks not copied yet.
+    uint32_t m_PendingCount = 0;
+    /// Number of chunks requested and submitted for copy.
+    uint32_t m_RequestedCount = 0;
+    uint32_t m_SubmittedCount = 0;
+};
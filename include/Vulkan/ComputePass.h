@@ -1,13 +1,28 @@
 #pragma once
 #include "Geometry/VkOptiCloud.h"
+#include "Vulkan/TimestampQueries.h"
+#include "Vulkan/WorkgroupTuner.h"
 #include "Olympus/PipelineLayout.h"
 #include "Olympus/DescriptorSet.h"
 #include "Olympus/Device.h"
 #include "Olympus/MemoryBuffer.h"
+#include <memory>
+#include <vector>
 
 ///  Compute pass for the optimize cloud rendering.
 ///
-/// Use the vertex buffer and the Vertex index image to fill the reprojected buffer.
+/// Use the vertex buffer and the Vertex index image to fill the reprojected buffer. Only the pixels holding a point
+/// are appended, their count is written in the indirect draw command of the reprojected buffer. The pass also counts
+/// the pixels whose vertex index changed since its previous execution, see ConvergenceTracker.
+///
+/// Each frame in flight has its own command buffer, semaphores, timestamps, read back count and descriptor set, which
+/// points to the cloud transforms of the frame; the fence of each submission belongs to the FrameScheduler, which the
+/// host waits on before reusing them. The pass of a frame waits for its graphics submission, and the next graphics
+/// submission waits for it on the device (see TakeFinishedSemaphore()): the executions are chained, which lets them
+/// share the reprojected buffer, the vertex index image and the buffer of the previous indices.
+///
+/// The workgroup size is chosen by a WorkgroupTuner: while it tunes, each frame is recorded again with the size to
+/// measure before its submission.
 class ComputePass
 {
 public:
@@ -23,72 +38,156 @@ public:
     /// @param[in] iOptiCloud Optimize cloud.
     /// @param[in] iVertexIndexImageView Vertex index image filled by the graphic pass.
     /// @param[in] iScreenSize Uniform buffer of the screen size.
+    /// @param[in] iCloudTransforms Uniform buffers of the model matrices of the source clouds, one per frame in
+    ///                             flight.
     /// @param[in] iWidth VertexIndexImage width.
     /// @param[in] iHeight VertexIndexImage height.
+    /// @param[in] iFrameCount Number of frames in flight.
     void Create(
         VkDescriptorPool &iDescriptorPool,
         VkOptiCloud &iOptiCloud,
         VkImageView iVertexIndexImageView,
         olp::UniformBuffer &iScreenSize,
+        std::vector<olp::UniformBuffer> &iCloudTransforms,
         uint32_t iWidth,
-        uint32_t iHeight);
+        uint32_t iHeight,
+        uint32_t iFrameCount);
+
+    ///  Points the pass to the buffers of another cloud. The pass must not be in flight.
+    /// @param[in] iOptiCloud Optimize cloud, with its reprojected buffer created.
+    /// @param[in] iWidth VertexIndexImage width.
+    /// @param[in] iHeight VertexIndexImage height.
+    void UpdateCloud(VkOptiCloud &iOptiCloud, uint32_t iWidth, uint32_t iHeight);
+
+    ///  Submits the command buffer of a frame to the compute queue. The previous execution of the frame must be
+    ///  finished.
+    /// @param[in] iFrame Frame in flight.
+    /// @param[in] iSignalSemaphore Semaphore to signal when the execution is finished, besides the one of
+    ///                             TakeFinishedSemaphore().
+    /// @param[in] iFence Fence to signal when the execution is finished.
+    void Process(uint32_t iFrame, VkSemaphore iSignalSemaphore, VkFence iFence);
+
+    ///  Semaphore the graphics submission of a frame signals, waited by the pass of the frame.
+    /// @param[in] iFrame Frame in flight.
+    VkSemaphore GetSemaphore(uint32_t iFrame) const { return m_Frames[iFrame].Semaphore; }
+
+    ///  Semaphore signaled by the last pass submitted, VK_NULL_HANDLE if it was already taken. The next graphics
+    ///  submission waits on it before it draws the reprojected buffer or writes the vertex index image, or waits
+    ///  for the copies of the streaming which waited on it.
+    VkSemaphore TakeFinishedSemaphore();
 
-    ///  Submits the command buffer to the compute queue.
-    /// @param[in] iWaitSemaphore Semaphore to wait before execute the pass.
-    /// @param[in] iSignalSemaphore Semaphore to signal when the execution is finished.
-    void Process(VkSemaphore iWaitSemaphore, VkSemaphore iSignalSemaphore);
+    ///  GPU duration of the last finished execution of the pass of a frame.
+    /// @param[in] iFrame Frame in flight, whose last execution was waited.
+    /// @param[out] oMilliseconds Duration.
+    /// @return False if it is not available.
+    bool GetDuration(uint32_t iFrame, double &oMilliseconds) const;
 
-    /// Wait the fence of the compute pass.
-    void WaitFence();
+    ///  GPU times of the beginning and the end of the last finished execution of the pass of a frame, in the time
+    ///  domain of the device (see TimestampQueries::GetTime()).
+    /// @param[in] iFrame Frame in flight, whose last execution was waited.
+    /// @param[out] oBegin Beginning.
+    /// @param[out] oEnd End.
+    /// @return False if they are not available.
+    bool GetTimes(uint32_t iFrame, double &oBegin, double &oEnd) const;
 
-    VkSemaphore GetSemaphore() { return m_Semaphore; }
-    VkCommandBuffer GetCommandBuffer() { return m_CommandBuffer; }
+    ///  Number of pixels whose vertex index changed in the last finished execution of the pass of a frame.
+    /// @param[in] iFrame Frame in flight, whose last execution was waited.
+    uint32_t GetChangedPixelCount(uint32_t iFrame) const { return m_ChangedPixelCounts[iFrame]; }
 
 protected:
+    /// Resources of a frame in flight.
+    struct Frame
+    {
+        /// Command buffer storing the dispatch commands and barriers.
+        VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+        /// Signaled by the graphics submission, waited by the pass.
+        VkSemaphore Semaphore = VK_NULL_HANDLE;
+        /// Signaled by the pass, waited by the next graphics submission.
+        VkSemaphore FinishedSemaphore = VK_NULL_HANDLE;
+        /// Workgroup size the command buffer was recorded with.
+        WorkgroupSize Size;
+        /// True once the command buffer was submitted since it was recorded.
+        bool Executed = false;
+    };
+
     ///  Create the pipeline layout.
     void CreatePipelineLayout();
 
+    ///  Create the buffer of the vertex indices of the previous execution, the counter of changed pixels and the host
+    ///  visible buffer the count of each frame is copied to.
+    /// @param[in] iWidth VertexIndexImage width.
+    /// @param[in] iHeight VertexIndexImage height.
+    void CreateConvergenceBuffers(uint32_t iWidth, uint32_t iHeight);
+
     ///  Create the descriptors.
     /// @param[in] iDescriptorPool Descriptor pool to allocate descriptor of the pass.
     /// @param[in] iOptiCloud Optimize cloud.
     /// @param[in] iVertexIndexImageView Vertex index image filled by the graphic pass.
     /// @param[in] iScreenSize Uniform buffer of the screen size.
+    /// @param[in] iCloudTransforms Uniform buffers of the model matrices of the source clouds, one per frame.
     void CreateDescriptor(
         VkDescriptorPool &iDescriptorPool,
         VkOptiCloud &iOptiCloud,
         VkImageView iVertexIndexImageView,
-        olp::UniformBuffer &iScreenSize);
+        olp::UniformBuffer &iScreenSize,
+        std::vector<olp::UniformBuffer> &iCloudTransforms);
 
     ///  Create the pipeline.
     void CreatePipeline();
 
-    ///  Create the command pool and the command buffer.
+    ///  Create the command pool and the command buffer of each frame.
     void CreateCommandPoolAndBuffer();
 
-    /// Create the sempahore and the fence used for the sync.
+    /// Create the sempahores of each frame.
     void CreateSemaphore();
 
-    ///  Build the command buffer.
+    ///  Build the command buffer of each frame.
     /// @param[in] iWidth VertexIndexImage width.
     /// @param[in] iHeight VertexIndexImage height.
     void BuildCommandBuffer(uint32_t iWidth, uint32_t iHeight);
 
+    ///  Record the command buffer of a frame with the workgroup size of the current pipeline.
+    /// @param[in] iFrame Frame in flight, not executing.
+    void RecordCommandBuffer(uint32_t iFrame);
+
+    ///  Feeds the duration of the last execution of a frame to the workgroup tuner, and records the frame again if
+    ///  the size to use changed.
+    /// @param[in] iFrame Frame in flight, not executing.
+    void UpdateWorkgroupSize(uint32_t iFrame);
+
     /// Vulkan device.
     const olp::Device &m_Device;
 
     /// Command pool for the compute queue.
     VkCommandPool m_CommandPool;
-    /// Command buffer storing the dispatch commands and barriers.
-    VkCommandBuffer m_CommandBuffer;
-    /// Execution dependency between compute & graphic submission.
-    VkSemaphore m_Semaphore;
-    /// Synchronisation GPU/CPU. Need to find a better solution.
-    VkFence m_Fence;
+    /// Resources of each frame in flight.
+    std::vector<Frame> m_Frames;
+    /// Finished semaphore of the last pass submitted, until it is taken.
+    VkSemaphore m_PendingSemaphore = VK_NULL_HANDLE;
 
     /// Layout of the compute pipeline.
     olp::PipelineLayout m_PipelineLayout;
-    /// Descriptor of the compute pass.
-    olp::DescriptorSet m_DescriptorSet;
-    /// Compute pipeline.
+    /// Descriptor of the compute pass, one per frame in flight.
+    std::vector<olp::DescriptorSet> m_DescriptorSets;
+    /// Compute pipeline, and its workgroup size.
     VkPipeline m_Pipeline;
-};
\ No newline at end of file
+    WorkgroupSize m_PipelineSize;
+    /// Pipelines of the sizes measured before, recorded in frames which may still execute. Destroyed with the pass.
+    std::vector<VkPipeline> m_RetiredPipelines;
+    /// Chooses the workgroup size, kept when the pass is created again.
+    std::unique_ptr<WorkgroupTuner> m_WorkgroupTuner;
+    /// VertexIndexImage size.
+    uint32_t m_Width = 0;
+    uint32_t m_Height = 0;
+    /// Indirect draw command of the reprojected buffer, its vertex count is reset before each dispatch.
+    VkBuffer m_ReprojectedDrawBuffer = VK_NULL_HANDLE;
+    /// Vertex index of each pixel in the previous execution. Its initial content only delays the convergence.
+    olp::MemoryBuffer m_PreviousIndexBuffer;
+    /// Number of pixels whose vertex index changed, reset before each dispatch.
+    olp::MemoryBuffer m_ConvergenceBuffer;
+    /// Count of each frame copied from m_ConvergenceBuffer, mapped in m_ChangedPixelCounts.
+    olp::MemoryBuffer m_ReadbackBuffer;
+    uint32_t *m_ChangedPixelCounts = nullptr;
+    /// Timestamps around the dispatch, two per frame.
+    std::unique_ptr<TimestampQueries> m_Timestamps;
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include "Olympus/Device.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/// @brief
+///  Numbers the frames and owns the synchronisation of the frames in flight.
+///
+/// Each frame gets an increasing number, and the number of the last finished frame acts as a timeline: callers wait
+/// for a frame number (the frame that last used a swapchain image, the frame that last used a slot of per-frame
+/// resources) instead of for a fence, and the wait returns at once when the frame is already known to be finished.
+/// The frame N uses the slot N % GetFrameCount() of the per-frame resources.
+///
+/// The device is created without the timeline semaphore feature, so the timeline is tracked on the host: each slot
+/// holds one fence per queue, signaled by the submissions of the frame. The graphics submission of a frame waits for
+/// the prepare pass of the previous one, which waits for its graphics submission: once both queues finished a frame,
+/// all the frames before it are finished too.
+class FrameScheduler
+{
+public:
+    /// Queues a frame submits to.
+    enum class Queue
+    {
+        Graphics,
+        Compute,
+        Count
+    };
+
+    ///  Constructor.
+    /// @param[in] iDevice Vulkan device.
+    /// @param[in] iFrameCount Number of frames in flight, at least 1.
+    FrameScheduler(const olp::Device &iDevice, uint32_t iFrameCount);
+
+    ///  Destructor. The frames must be finished.
+    ~FrameScheduler();
+
+    FrameScheduler(const FrameScheduler &) = delete;
+    FrameScheduler &operator=(const FrameScheduler &) = delete;
+
+    ///  Numbers the next frame, and waits for the frame that last used its slot. The semaphores retired by that frame
+    ///  are destroyed.
+    /// @return Number of the new frame.
+    uint64_t BeginFrame();
+
+    ///  Waits until a frame is finished on all the queues. Returns at once for a frame already finished or never
+    ///  submitted.
+    /// @param[in] iFrame Frame number, 0 for none.
+    void WaitFrame(uint64_t iFrame);
+
+    ///  Waits until every submitted frame is finished.
+    void WaitIdle();
+
+    ///  Fence to pass to the submission of the current frame on a queue. It is reset, and the frame counts as
+    ///  submitted from now on.
+    /// @param[in] iQueue Queue of the submission.
+    VkFence Submit(Queue iQueue);
+
+    ///  Destroys a semaphore once the current frame is finished.
+    /// @param[in] iSemaphore Semaphore waited by a submission of the current frame, may be VK_NULL_HANDLE.
+    void RetireSemaphore(VkSemaphore iSemaphore);
+
+    ///  Number of frames in flight.
+    uint32_t GetFrameCount() const { return static_cast<uint32_t>(m_Slots.size()); }
+
+    ///  Number of the current frame, 0 before the first BeginFrame().
+    uint64_t GetFrame() const { return m_Frame; }
+
+    ///  Slot of the per-frame resources used by the current frame.
+    uint32_t GetSlot() const { return static_cast<uint32_t>(m_Frame % m_Slots.size()); }
+
+    ///  Number of the last frame known to be finished.
+    uint64_t GetFinishedFrame() const { return m_FinishedFrame; }
+
+    ///  Semaphore signaled when the swapchain image of the current frame is acquired.
+    VkSemaphore GetImageAvailableSemaphore() const { return m_Slots[GetSlot()].ImageAvailable; }
+
+    ///  Semaphore signaled when the current frame can be presented.
+    VkSemaphore GetRenderFinishedSemaphore() const { return m_Slots[GetSlot()].RenderFinished; }
+
+    ///  Time the host was blocked by the waits of the last BeginFrame().
+    double GetLastWaitMilliseconds() const { return m_LastWaitMilliseconds; }
+
+private:
+    /// Synchronisation objects of a slot.
+    struct Slot
+    {
+        /// Number of the last frame submitted with the slot, 0 for none.
+        uint64_t Frame = 0;
+        VkSemaphore ImageAvailable = VK_NULL_HANDLE;
+        VkSemaphore RenderFinished = VK_NULL_HANDLE;
+        /// Signaled by the submissions of the frame on each queue, created signaled.
+        std::array<VkFence, static_cast<size_t>(Queue::Count)> Fences{};
+        /// Semaphores to destroy once the frame is finished.
+        std::vector<VkSemaphore> RetiredSemaphores;
+    };
+
+    /// Vulkan device.
+    const olp::Device &m_Device;
+    /// Synchronisation objects of each frame in flight.
+    std::vector<Slot> m_Slots;
+    /// Number of the current frame.
+    uint64_t m_Frame = 0;
+    /// Number of the last frame known to be finished.
+    uint64_t m_FinishedFrame = 0;
+    /// Time the host was blocked by the waits of the last BeginFrame().
+    double m_LastWaitMilliseconds = 0.0;
+};
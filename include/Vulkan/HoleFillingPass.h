@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Olympus/DescriptorSet.h"
+#include "Olympus/Device.h"
+#include "Olympus/MemoryBuffer.h"
+#include "Olympus/UniformBuffer.h"
+#include <vector>
+
+///  Compute pass filling the holes between the points kept by the compute rasterizer, with a push-pull.
+///
+/// The pull builds an image pyramid from the nearest point of each pixel: each texel averages the colors of its 2x2
+/// children which lie on their nearest surface, and keeps their coverage as weight. The push then goes back down and
+/// blends each texel with its parent by the weight it lacks. A hole is so filled from the first level dense enough
+/// to cover it: the sparser the points around it, the larger the splat. The empty pixels are finally written to the
+/// depth and index buffer with the filling color and a flag instead of a vertex index (see resolve.frag), so the
+/// rasterized points are left as they are and the filled pixels are never reprojected.
+class HoleFillingPass
+{
+public:
+    /// Number of levels of the pyramid. The largest hole filled is 2^(LEVEL_COUNT - 1) pixels wide: larger ones are
+    /// the background, not a lack of points.
+    static constexpr uint32_t LEVEL_COUNT = 5;
+    /// Width and height of a workgroup, as declared by pushpull.comp.
+    static constexpr uint32_t WORKGROUP_SIZE = 8;
+
+    ///  Creates the pyramid, the pipeline and the descriptor of the pass.
+    /// @param[in] iDevice Device owning the buffers.
+    /// @param[in] iDepthIndexBuffer Depth and index buffer of the compute rasterizer.
+    /// @param[in] iVertexBuffer Vertex buffer of the drawn cloud.
+    /// @param[in] iVertexBufferSize Size of the vertex buffer.
+    /// @param[in] iCamera Uniform buffers of the camera matrices, one per swapchain image.
+    /// @param[in] iWidth Image width.
+    /// @param[in] iHeight Image height.
+    HoleFillingPass(
+        const olp::Device &iDevice,
+        VkBuffer iDepthIndexBuffer,
+        VkBuffer iVertexBuffer,
+        VkDeviceSize iVertexBufferSize,
+        std::vector<olp::UniformBuffer> &iCamera,
+        uint32_t iWidth,
+        uint32_t iHeight);
+
+    ///  Destroys the pass. It must not be in flight.
+    ~HoleFillingPass();
+
+    HoleFillingPass(const HoleFillingPass &) = delete;
+    HoleFillingPass &operator=(const HoleFillingPass &) = delete;
+
+    ///  Points the pass to the vertex buffer of another cloud. The pass must not be in flight.
+    /// @param[in] iVertexBuffer Vertex buffer of the drawn cloud.
+    /// @param[in] iVertexBufferSize Size of the vertex buffer.
+    void UpdateVertexBuffer(VkBuffer iVertexBuffer, VkDeviceSize iVertexBufferSize);
+
+    ///  Records the pull, the push and the write of the filled pixels.
+    /// @param[in] iCommandBuffer Command buffer, after the rasterization and outside of a render pass.
+    /// @param[in] iImage Index of the swapchain image, whose camera matrices are read.
+    void Record(VkCommandBuffer iCommandBuffer, uint32_t iImage);
+
+private:
+    /// Texels of a level of the pyramid.
+    struct Level
+    {
+        uint32_t Offset;
+        uint32_t Width;
+        uint32_t Height;
+    };
+
+    ///  Creates the descriptor set layout, the pipeline layout and the compute pipeline.
+    void CreatePipeline();
+
+    ///  Allocates the descriptor sets pointing to the buffers.
+    /// @param[in] iCamera Uniform buffers of the camera matrices, one per swapchain image.
+    void CreateDescriptors(std::vector<olp::UniformBuffer> &iCamera);
+
+    ///  Records a step of pushpull.comp over the texels of a level, after the previous step.
+    /// @param[in] iCommandBuffer Command buffer.
+    /// @param[in] iMode Step of the shader.
+    /// @param[in] iSource Level read by the step.
+    /// @param[in] iDestination Level written by the step.
+    void RecordStep(VkCommandBuffer iCommandBuffer, uint32_t iMode, const Level &iSource, const Level &iDestination);
+
+    /// Vulkan device.
+    const olp::Device &m_Device;
+    /// Levels of the pyramid, from the image size.
+    std::vector<Level> m_Levels;
+    /// Depth and index buffer of the compute rasterizer.
+    VkBuffer m_DepthIndexBuffer = VK_NULL_HANDLE;
+    /// Vertex buffer of the drawn cloud.
+    VkBuffer m_VertexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize m_VertexBufferSize = 0;
+    /// Texels of all the levels, (color and weight, linear depth) each.
+    olp::MemoryBuffer m_PyramidBuffer;
+
+    VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_Pipeline = VK_NULL_HANDLE;
+    VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+    /// Descriptor of each swapchain image, which only differ by their camera matrices.
+    std::vector<olp::DescriptorSet> m_DescriptorSets;
+};
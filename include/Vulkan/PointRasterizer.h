@@ -0,0 +1,151 @@
+#pragma once
+
+#include "Geometry/VkOptiCloud.h"
+#include "Vulkan/HoleFillingPass.h"
+#include "Olympus/DescriptorSet.h"
+#include "Olympus/Device.h"
+#include "Olympus/MemoryBuffer.h"
+#include "Olympus/UniformBuffer.h"
+#include <memory>
+#include <vector>
+
+/// Backend drawing the points of the optimize cloud.
+enum class PointRasterization
+{
+    /// Point list drawn by the graphics pipeline.
+    Hardware,
+    /// Compute shader rasterization, see PointRasterizer.
+    Compute
+};
+
+///  Compute pass rasterizing the points of the optimize cloud.
+///
+/// Each invocation projects a point and keeps the nearest one of its pixel with a 64-bit atomicMin of
+/// (depth << 32 | vertex index) in a buffer the size of the image. The depth is in [0, 1], so the order of its bits is
+/// the order of the floats. The reprojected buffer and the steps are rasterized before the render pass. A fullscreen
+/// quad drawn in the optimize cloud subpass then resolves each pixel to its color, vertex index and depth, so the
+/// prepare pass and the final subpass see the same attachments as with hardware points. A point covers one pixel,
+/// whatever the point size: the optional HoleFillingPass instead grows the points to the local density.
+/// The device must be created with the shaderInt64 and shaderBufferInt64Atomics features, on a Vulkan 1.1 instance.
+/// Olympus does not enable them yet: the pass is only available in a build with the CLOUD_RENDERING_COMPUTE_RASTER
+/// option, for an Olympus which does.
+class PointRasterizer
+{
+public:
+    /// Number of invocations of a workgroup, as declared by rasterize.comp.
+    static constexpr uint32_t WORKGROUP_SIZE = 256;
+
+    ///  True if the pass is built and the physical device supports the 64-bit buffer atomics it needs.
+    /// @param[in] iDevice Device to query.
+    static bool IsSupported(const olp::Device &iDevice);
+
+    ///  Creates the pipelines, the depth and index buffer and the descriptors of the pass.
+    /// @param[in] iDevice Device owning the buffers.
+    /// @param[in] iOptiCloud Optimize cloud, with its reprojected buffer created.
+    /// @param[in] iModel Uniform buffers of the model and view projection matrices, one per swapchain image.
+    /// @param[in] iCloudTransforms Uniform buffers of the model matrices of the source clouds, one per swapchain image.
+    /// @param[in] iScreenSize Uniform buffer of the screen size.
+    /// @param[in] iCamera Uniform buffers of the camera matrices, one per swapchain image.
+    /// @param[in] iWidth Image width.
+    /// @param[in] iHeight Image height.
+    /// @param[in] iHoleFilling True to fill the holes between the points, see HoleFillingPass.
+    PointRasterizer(
+        const olp::Device &iDevice,
+        VkOptiCloud &iOptiCloud,
+        std::vector<olp::UniformBuffer> &iModel,
+        std::vector<olp::UniformBuffer> &iCloudTransforms,
+        olp::UniformBuffer &iScreenSize,
+        std::vector<olp::UniformBuffer> &iCamera,
+        uint32_t iWidth,
+        uint32_t iHeight,
+        bool iHoleFilling);
+
+    ///  Destroys the pass. It must not be in flight.
+    ~PointRasterizer();
+
+    PointRasterizer(const PointRasterizer &) = delete;
+    PointRasterizer &operator=(const PointRasterizer &) = delete;
+
+    ///  Points the pass to the buffers of another cloud. The pass must not be in flight.
+    /// @param[in] iOptiCloud Optimize cloud, with its reprojected buffer created.
+    void UpdateCloud(VkOptiCloud &iOptiCloud);
+
+    ///  Records the clear of the depth and index buffer and the rasterization of the reprojected buffer.
+    /// @param[in] iCommandBuffer Command buffer, outside of a render pass.
+    /// @param[in] iImage Index of the swapchain image, whose matrices are read.
+    void RecordBegin(VkCommandBuffer iCommandBuffer, uint32_t iImage);
+
+    ///  Records the rasterization of points of the vertex buffer, for an out-of-core cloud.
+    /// @param[in] iCommandBuffer Command buffer, between RecordBegin() and RecordEnd().
+    /// @param[in] iFirst Index of the first point.
+    /// @param[in] iCount Number of points.
+    void RecordPoints(VkCommandBuffer iCommandBuffer, uint32_t iFirst, uint32_t iCount);
+
+    ///  Records the rasterization of the step advanced by the StepCounter of the cloud, with an indirect dispatch.
+    /// @param[in] iCommandBuffer Command buffer, between RecordBegin() and RecordEnd(), after the advance.
+    void RecordStep(VkCommandBuffer iCommandBuffer);
+
+    ///  Records the hole filling, if enabled, and the barrier making the rasterized points visible to the resolve.
+    /// @param[in] iCommandBuffer Command buffer, outside of a render pass.
+    /// @param[in] iImage Index of the swapchain image given to RecordBegin().
+    void RecordEnd(VkCommandBuffer iCommandBuffer, uint32_t iImage);
+
+    ///  Binds the descriptor set of the resolve, drawn by a pipeline of GetResolvePipelineLayout().
+    /// @param[in] iCommandBuffer Command buffer, in the optimize cloud subpass.
+    void BindResolveDescriptor(VkCommandBuffer iCommandBuffer);
+
+    VkPipelineLayout GetResolvePipelineLayout() const { return m_ResolvePipelineLayout; }
+
+private:
+    ///  Creates the descriptor set layouts, the pipeline layouts and the compute pipelines.
+    void CreatePipelines();
+
+    ///  Allocates the descriptor sets pointing to the buffers.
+    /// @param[in] iModel Uniform buffers of the model and view projection matrices, one per swapchain image.
+    /// @param[in] iCloudTransforms Uniform buffers of the model matrices of the source clouds, one per swapchain image.
+    /// @param[in] iScreenSize Uniform buffer of the screen size.
+    void CreateDescriptors(
+        std::vector<olp::UniformBuffer> &iModel,
+        std::vector<olp::UniformBuffer> &iCloudTransforms,
+        olp::UniformBuffer &iScreenSize);
+
+    ///  Records a dispatch over a range of points.
+    /// @param[in] iCommandBuffer Command buffer.
+    /// @param[in] iPipeline Pipeline of the vertex buffer or of the reprojected buffer.
+    /// @param[in] iFirst Index of the first point.
+    /// @param[in] iCount Number of points.
+    void RecordDispatch(VkCommandBuffer iCommandBuffer, VkPipeline iPipeline, uint32_t iFirst, uint32_t iCount);
+
+    /// Vulkan device.
+    const olp::Device &m_Device;
+    /// Image size.
+    uint32_t m_Width = 0;
+    uint32_t m_Height = 0;
+    /// Largest number of workgroups of a dispatch.
+    uint32_t m_MaxGroupCount = 1;
+    /// Vertex and reprojected buffers of the drawn cloud.
+    VkBuffer m_VertexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize m_VertexBufferSize = 0;
+    VkBuffer m_ReprojectedBuffer = VK_NULL_HANDLE;
+    VkDeviceSize m_ReprojectedBufferSize = 0;
+    VkBuffer m_ReprojectedDrawBuffer = VK_NULL_HANDLE;
+    /// State of the StepCounter of the cloud.
+    VkBuffer m_StepBuffer = VK_NULL_HANDLE;
+    /// Nearest point of each pixel, depth in the high word and vertex index in the low one.
+    olp::MemoryBuffer m_DepthIndexBuffer;
+    /// Filling of the holes between the points, null if disabled.
+    std::unique_ptr<HoleFillingPass> m_HoleFilling;
+
+    VkDescriptorSetLayout m_RasterizeDescriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_RasterizePipelineLayout = VK_NULL_HANDLE;
+    /// Rasterization of a range of the vertex buffer, of the reprojected buffer and of the step of the step counter.
+    VkPipeline m_PointPipeline = VK_NULL_HANDLE;
+    VkPipeline m_ReprojectedPipeline = VK_NULL_HANDLE;
+    VkPipeline m_StepPipeline = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_ResolveDescriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_ResolvePipelineLayout = VK_NULL_HANDLE;
+    VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+    /// Rasterization descriptor of each swapchain image, which only differ by their matrices.
+    std::vector<olp::DescriptorSet> m_RasterizeDescriptorSets;
+    olp::DescriptorSet m_ResolveDescriptorSet;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Olympus/Device.h"
+#include <functional>
+#include <vector>
+
+///  Records a list of draws into secondary command buffers, split in chunks recorded by worker threads.
+///
+/// Each swapchain image has one command pool per thread, so the threads never share a pool and the buffers of an
+/// image are reset while the other images are in flight. The caller executes the recorded buffers with
+/// vkCmdExecuteCommands, in a subpass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+class SecondaryCommandBuffers
+{
+public:
+    /// Smallest number of draws given to a thread, below which spawning it costs more than it saves.
+    static constexpr uint32_t MIN_DRAWS_PER_THREAD = 64;
+
+    ///  Creates the command pools and allocates their buffer.
+    /// @param[in] iDevice Vulkan device.
+    /// @param[in] iImageCount Number of swapchain images.
+    /// @param[in] iThreadCount Largest number of threads recording an image.
+    SecondaryCommandBuffers(const olp::Device &iDevice, uint32_t iImageCount, uint32_t iThreadCount);
+
+    ///  Destroys the pools. The buffers must not be in flight.
+    ~SecondaryCommandBuffers();
+
+    SecondaryCommandBuffers(const SecondaryCommandBuffers &) = delete;
+    SecondaryCommandBuffers &operator=(const SecondaryCommandBuffers &) = delete;
+
+    ///  Records the draws of an image. Its previous buffers must not be in flight anymore.
+    /// @param[in] iImage Index of the swapchain image.
+    /// @param[in] iInheritance Render pass, subpass and framebuffer the buffers are executed in.
+    /// @param[in] iDrawCount Number of draws.
+    /// @param[in] iRecordDraws Records the draws [iFirst, iFirst + iCount) in a buffer, with its own pipeline and
+    ///                         descriptor bindings. Called concurrently on several threads.
+    /// @return Recorded buffers, to execute in this order. Empty if there is no draw.
+    std::vector<VkCommandBuffer> Record(
+        uint32_t iImage,
+        const VkCommandBufferInheritanceInfo &iInheritance,
+        uint32_t iDrawCount,
+        const std::function<void(VkCommandBuffer iCommandBuffer, uint32_t iFirst, uint32_t iCount)> &iRecordDraws);
+
+private:
+    /// Vulkan device.
+    const olp::Device &m_Device;
+    /// Number of threads, and of pools of each image.
+    uint32_t m_ThreadCount = 1;
+    /// Pool of each image and thread, indexed by image * m_ThreadCount + thread, and its buffer.
+    std::vector<VkCommandPool> m_CommandPools;
+    std::vector<VkCommandBuffer> m_CommandBuffers;
+};
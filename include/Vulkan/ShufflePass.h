@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Olympus/Device.h"
+#include "Permutation.h"
+
+///  Compute pass shuffling a cloud uploaded in file order into its progressive order.
+///
+/// Each invocation gathers oDst[i] = iSrc[P(i)], with P the Permutation of the point count: the writes are coalesced
+/// and the permutation is evaluated on the fly, the host never touches the points. The pass is submitted once on the
+/// graphics queue, so the draws and the prepare pass submitted after it see the shuffled buffer.
+class ShufflePass
+{
+public:
+    /// Number of invocations of a workgroup, as declared by shuffle.comp.
+    static constexpr uint32_t WORKGROUP_SIZE = 256;
+
+    ///  Creates the pipeline and the descriptors of the pass.
+    /// @param[in] iDevice Device owning the buffers.
+    /// @param[in] iSrcBuffer Storage buffer of the points in file order.
+    /// @param[in] iDstBuffer Storage buffer of the shuffled points.
+    /// @param[in] iPointCount Number of points of both buffers.
+    ShufflePass(const olp::Device &iDevice, VkBuffer iSrcBuffer, VkBuffer iDstBuffer, uint32_t iPointCount);
+
+    ///  Waits for the pass and destroys it.
+    ~ShufflePass();
+
+    ShufflePass(const ShufflePass &) = delete;
+    ShufflePass &operator=(const ShufflePass &) = delete;
+
+    ///  Records and submits the dispatch. The source buffer must be written by commands already submitted to the
+    ///  graphics queue.
+    void Submit();
+
+    ///  True once the submitted pass is finished, the source buffer can then be destroyed.
+    bool IsFinished() const;
+
+    ///  Blocks until the submitted pass is finished.
+    void Wait() const;
+
+private:
+    ///  Creates the descriptor set layout, the pipeline layout and the pipeline.
+    void CreatePipeline();
+
+    ///  Allocates the descriptor set pointing to the buffers.
+    void CreateDescriptor();
+
+    /// Vulkan device.
+    const olp::Device &m_Device;
+    /// Buffers of the points, in file and in progressive order.
+    VkBuffer m_SrcBuffer = VK_NULL_HANDLE;
+    VkBuffer m_DstBuffer = VK_NULL_HANDLE;
+    /// Permutation applied by the shader.
+    Permutation m_Permutation;
+
+    VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_Pipeline = VK_NULL_HANDLE;
+    VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+    VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+    VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
+    /// Signaled when the dispatch is done.
+    VkFence m_Fence = VK_NULL_HANDLE;
+    /// True once Submit() was called.
+    bool m_Submitted = false;
+};
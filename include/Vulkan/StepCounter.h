@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Olympus/Device.h"
+#include "Olympus/MemoryBuffer.h"
+
+///  Progressive step of a resident optimize cloud, kept and advanced on the device.
+///
+/// A single invocation advances the step at the start of each frame: it applies the pending rewind, and writes the
+/// next range of points as a VkDrawIndirectCommand for the point pipeline and as a VkDispatchIndirectCommand for the
+/// compute rasterizer. The commands drawing the step do not change from one frame to the next. The state lives in host
+/// visible memory: it is a few words, and the host reads back the size of each finished step.
+///
+/// The frames in flight advance the same step, so the device owns the commands and the number of drawn points. The
+/// host requests (point counts, rewinds) are gathered on the host, and copied by Commit() to the block of the slot
+/// of the next frame, whose previous frame is finished. The advance of that frame reads them, and writes the size of
+/// its step back to the same block.
+class StepCounter
+{
+public:
+    /// Number of slots the step sizes are read back from, one per frame that may be in flight.
+    static constexpr uint32_t SLOT_COUNT = 8;
+    /// Offsets in GetBuffer() of the indirect commands of the step.
+    static constexpr VkDeviceSize DRAW_OFFSET = 0;
+    static constexpr VkDeviceSize DISPATCH_OFFSET = sizeof(VkDrawIndirectCommand);
+
+    ///  Creates the buffer, the pipeline and the descriptor of the counter, at step 0.
+    /// @param[in] iDevice Device owning the buffer.
+    StepCounter(const olp::Device &iDevice);
+
+    ///  Destroys the counter. It must not be in flight.
+    ~StepCounter();
+
+    StepCounter(const StepCounter &) = delete;
+    StepCounter &operator=(const StepCounter &) = delete;
+
+    ///  Sets the point counts read by the advances committed from now on.
+    /// @param[in] iPointCount Number of points of the cloud.
+    /// @param[in] iLoadedCount Number of points already in the vertex buffer, a step is only drawn once loaded.
+    /// @param[in] iPointsByStep Number of points of a step.
+    void SetPointCounts(uint32_t iPointCount, uint32_t iLoadedCount, uint32_t iPointsByStep);
+
+    ///  Draws again the last points at the next committed advance. The rewinds requested before it add up.
+    /// @param[in] iFraction Fraction of the drawn points to draw again, 1 to restart the drawing.
+    void Rewind(float iFraction);
+
+    ///  Hands the point counts and the rewind requested since the last call to the advance of a slot. To call before
+    ///  each submission of the advance of the slot, once the previous frame of the slot is finished.
+    /// @param[in] iSlot Slot given to RecordAdvance().
+    void Commit(uint32_t iSlot);
+
+    ///  Records the advance of the step, and the barrier making it visible to the indirect commands.
+    /// @param[in] iCommandBuffer Command buffer, outside of a render pass.
+    /// @param[in] iSlot Slot receiving the size of the step, below SLOT_COUNT.
+    void RecordAdvance(VkCommandBuffer iCommandBuffer, uint32_t iSlot);
+
+    ///  Records the draw of the step, with the vertex buffer bound.
+    /// @param[in] iCommandBuffer Command buffer, in a render pass.
+    void RecordDraw(VkCommandBuffer iCommandBuffer);
+
+    ///  Size of the step advanced in a slot, 0 once taken. The frame which advanced it must be finished. Also reads
+    ///  whether the advance drew the last points, see IsComplete().
+    /// @param[in] iSlot Slot given to RecordAdvance().
+    uint32_t TakeStepPointCount(uint32_t iSlot);
+
+    ///  Writes the size of a step chosen by the host, for a cloud whose steps are not advanced on the device.
+    /// @param[in] iSlot Slot of the frame drawing the step.
+    /// @param[in] iPointCount Number of points of the step.
+    void SetStepPointCount(uint32_t iSlot, uint32_t iPointCount);
+
+    ///  True once a finished advance drew every point, and no rewind or point count was requested since.
+    bool IsComplete() const { return m_Complete; }
+
+    ///  Buffer holding the indirect commands at DRAW_OFFSET and DISPATCH_OFFSET, and the rest of the state.
+    VkBuffer GetBuffer() const { return m_StateBuffer.Buffer; }
+
+private:
+    /// Layout of the state buffer, see advancestep.comp.
+    struct State;
+
+    ///  Creates the descriptor set layout, the pipeline layout and the pipeline.
+    void CreatePipeline();
+
+    ///  Allocates the descriptor set pointing to the state buffer.
+    void CreateDescriptor();
+
+    /// Vulkan device.
+    const olp::Device &m_Device;
+    /// State of the step, persistently mapped to m_State.
+    olp::MemoryBuffer m_StateBuffer;
+    State *m_State = nullptr;
+
+    /// Requests for the next committed advance.
+    uint32_t m_PointCount = 0;
+    uint32_t m_LoadedCount = 0;
+    uint32_t m_PointsByStep = 0;
+    /// Fraction of the drawn points to draw again, 0 if no rewind is pending.
+    float m_RewindFraction = 0.0f;
+    /// Incremented by the requests which change the completion of the drawing.
+    uint32_t m_Serial = 0;
+    /// Result of IsComplete().
+    bool m_Complete = false;
+
+    VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_Pipeline = VK_NULL_HANDLE;
+    VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Olympus/Device.h"
+
+///  Pool of GPU timestamps, to measure the duration of recorded commands.
+///
+/// If the queue family has no timestamp support, nothing is recorded and no duration is ever available.
+class TimestampQueries
+{
+public:
+    ///  Creates the pool.
+    /// @param[in] iDevice Vulkan device.
+    /// @param[in] iQueueFamily Family of the queue executing the timestamps.
+    /// @param[in] iCount Number of timestamps.
+    TimestampQueries(const olp::Device &iDevice, uint32_t iQueueFamily, uint32_t iCount);
+    ~TimestampQueries();
+
+    TimestampQueries(const TimestampQueries &) = delete;
+    TimestampQueries &operator=(const TimestampQueries &) = delete;
+
+    bool IsSupported() const { return m_Pool != VK_NULL_HANDLE; }
+
+    ///  Records the reset of a range of timestamps, outside of a render pass, before writing them again.
+    /// @param[in] iCommandBuffer Command buffer.
+    /// @param[in] iFirst First timestamp.
+    /// @param[in] iCount Number of timestamps.
+    void Reset(VkCommandBuffer iCommandBuffer, uint32_t iFirst, uint32_t iCount) const;
+
+    ///  Records the write of a timestamp once the previous commands reach a stage.
+    /// @param[in] iCommandBuffer Command buffer.
+    /// @param[in] iStage Stage of the previous commands.
+    /// @param[in] iQuery Timestamp.
+    void Write(VkCommandBuffer iCommandBuffer, VkPipelineStageFlagBits iStage, uint32_t iQuery) const;
+
+    ///  Time elapsed between two timestamps of an executed command buffer. Never blocks.
+    /// @param[in] iBegin First timestamp.
+    /// @param[in] iEnd Second timestamp.
+    /// @param[out] oMilliseconds Elapsed time.
+    /// @return False if a timestamp is not available.
+    bool GetMilliseconds(uint32_t iBegin, uint32_t iEnd, double &oMilliseconds) const;
+
+    ///  Time of a timestamp of an executed command buffer. The device writes the timestamps of all its queues in the
+    ///  same time domain, so the times of two pools can be compared. Never blocks.
+    /// @param[in] iQuery Timestamp.
+    /// @param[out] oMilliseconds Time, from an origin chosen by the device.
+    /// @return False if the timestamp is not available.
+    bool GetTime(uint32_t iQuery, double &oMilliseconds) const;
+
+private:
+    ///  Reads a timestamp, false if it is not available.
+    bool Read(uint32_t iQuery, uint64_t &oTicks) const;
+
+    /// Vulkan device.
+    const olp::Device &m_Device;
+    /// Query pool, null if timestamps are not supported.
+    VkQueryPool m_Pool = VK_NULL_HANDLE;
+    /// Mask of the valid bits of a timestamp.
+    uint64_t m_ValidMask = 0;
+    /// Nanoseconds per tick.
+    double m_Period = 0.0;
+};
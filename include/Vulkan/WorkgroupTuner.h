@@ -0,0 +1,115 @@
+#pragma once
+#include "Olympus/Device.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/// Workgroup size of a compute shader, given to its pipeline as the specialization constants 0, 1 and 2.
+struct WorkgroupSize
+{
+    uint32_t X = 1;
+    uint32_t Y = 1;
+    uint32_t Z = 1;
+
+    ///  Number of invocations of a workgroup.
+    uint32_t GetInvocationCount() const { return X * Y * Z; }
+
+    ///  Number of workgroups covering a number of invocations along an axis.
+    static uint32_t GetGroupCount(uint32_t iInvocationCount, uint32_t iSize)
+    {
+        return (iInvocationCount + iSize - 1) / iSize;
+    }
+
+    bool operator==(const WorkgroupSize &iOther) const { return X == iOther.X && Y == iOther.Y && Z == iOther.Z; }
+    bool operator!=(const WorkgroupSize &iOther) const { return !(*this == iOther); }
+};
+
+/// @brief
+///  Chooses the fastest workgroup size of a compute pass on the current device, and caches it per device.
+///
+/// The shader declares its workgroup size with local_size_x_id = 0, local_size_y_id = 1 and local_size_z_id = 2, and
+/// the pass creates its pipeline with CreatePipeline(). The candidates are tried one after the other on the real
+/// workload of the first frames: the pass uses the pipeline of GetSize(), and feeds the GPU duration of each
+/// execution to AddSample(). Once every candidate is measured, the one with the lowest median duration is kept and
+/// written to the cache file, with the identifier of the device and of its driver, so the next runs use it at once.
+class WorkgroupTuner
+{
+public:
+    /// Executions ignored after a change of size, while the caches warm up.
+    static constexpr uint32_t WARMUP_SAMPLE_COUNT = 2;
+    /// Executions measured for each candidate.
+    static constexpr uint32_t SAMPLE_COUNT = 16;
+
+    ///  Constructor. Reads the size cached for the device, if any.
+    /// @param[in] iDevice Vulkan device.
+    /// @param[in] iPassName Name of the pass in the cache file, without spaces.
+    /// @param[in] iDefault Size used first, and kept if the pass can not be measured.
+    /// @param[in] iCandidates Sizes to try besides the default one. Those beyond the limits of the device are ignored.
+    WorkgroupTuner(
+        const olp::Device &iDevice,
+        std::string iPassName,
+        const WorkgroupSize &iDefault,
+        const std::vector<WorkgroupSize> &iCandidates);
+
+    ///  Size the pass must use for its next execution.
+    const WorkgroupSize &GetSize() const { return m_Tuned ? m_Size : m_Candidates[m_Candidate]; }
+
+    ///  True once the size no longer changes.
+    bool IsTuned() const { return m_Tuned; }
+
+    ///  Feeds the duration of a finished execution.
+    /// @param[in] iSize Size the execution used. Samples of another size than GetSize() are ignored.
+    /// @param[in] iMilliseconds GPU duration.
+    void AddSample(const WorkgroupSize &iSize, double iMilliseconds);
+
+    ///  Stops the tuning on the default size, for a pass whose duration can not be measured.
+    void Cancel();
+
+    ///  Creates a compute pipeline with the given workgroup size.
+    /// @param[in] iDevice Vulkan device.
+    /// @param[in] iLayout Pipeline layout.
+    /// @param[in] iShaderPath SPIR-V file of the shader.
+    /// @param[in] iSize Workgroup size.
+    /// @param[in] iConstants Values of the uint specialization constants of the shader following the workgroup size,
+    ///                       from the id 3.
+    static VkPipeline CreatePipeline(
+        const olp::Device &iDevice,
+        VkPipelineLayout iLayout,
+        const std::filesystem::path &iShaderPath,
+        const WorkgroupSize &iSize,
+        const std::vector<uint32_t> &iConstants = {});
+
+private:
+    ///  Identifier of the device and of its driver.
+    std::string GetDeviceKey() const;
+
+    ///  Reads the size of the pass cached for the device.
+    /// @return False if there is none.
+    bool LoadCachedSize();
+
+    ///  Writes the tuned size in the cache file, and keeps the entries of the other passes and devices.
+    void SaveSize() const;
+
+    ///  Chooses the candidate with the lowest median duration.
+    void Finish();
+
+    /// Vulkan device.
+    const olp::Device &m_Device;
+    /// Name of the pass in the cache file.
+    std::string m_PassName;
+    /// Identifier of the device in the cache file.
+    std::string m_DeviceKey;
+    /// Sizes to try, the default one first.
+    std::vector<WorkgroupSize> m_Candidates;
+    /// Candidate measured.
+    size_t m_Candidate = 0;
+    /// Executions of the measured candidate fed so far, warm up included.
+    uint32_t m_FedCount = 0;
+    /// Durations measured for the current candidate.
+    std::vector<double> m_Samples;
+    /// Median duration of each measured candidate.
+    std::vector<double> m_Medians;
+    /// Chosen size, valid once tuned.
+    WorkgroupSize m_Size;
+    bool m_Tuned = false;
+};
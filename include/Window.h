@@ -22,6 +22,44 @@ public:
     /// Run render loop.
     void Run();
 
+    /// Load a cloud file and render it.
+    /// @param iFilePath Path to the cloud file.
+    void AddCloud(const std::filesystem::path &iFilePath);
+
+    /// Load the clouds of a scene, each one with its model matrix, and render them together.
+    /// @param iSources Clouds of the scene.
+    /// @param iVoxelSize Size of the voxel grid decimating the scene, 0 to keep all the points.
+    /// @param iPointsPerVoxel Number of points kept per voxel.
+    void AddClouds(const std::vector<CloudSource> &iSources, float iVoxelSize = 0.0f, uint32_t iPointsPerVoxel = 1);
+
+    /// Set the GPU frame time the number of points drawn each step adapts to.
+    /// @param iMilliseconds Frame time target, 0 to keep the step size fixed.
+    void SetFrameTimeTarget(float iMilliseconds);
+
+    /// Choose how the points of the optimize cloud are drawn.
+    /// @param iRasterization Point backend.
+    void SetPointRasterization(PointRasterization iRasterization);
+
+    /// Fill the holes between the points drawn by the compute rasterizer.
+    /// @param iEnabled True to fill the holes.
+    void EnableHoleFilling(bool iEnabled);
+
+    /// Record the command buffers once per swapchain image, or every frame.
+    /// @param iEnabled False to record the command buffers every frame.
+    void EnableCommandBufferReuse(bool iEnabled);
+
+    /// Set the number of frames the host may submit before waiting for the oldest one.
+    /// @param iFrameCount Number of frames in flight, at least 1.
+    void SetFramesInFlight(uint32_t iFrameCount);
+
+    /// Print how much of the prepare pass runs concurrently with the next frame.
+    /// @param iEnabled True to print the report.
+    void EnableOverlapReport(bool iEnabled);
+
+    /// Load a mesh file (OBJ or PLY) and render it.
+    /// @param iFilePath Path to the mesh file.
+    void AddMesh(const std::filesystem::path &iFilePath);
+
     /// Resize the window.
     /// @param iWidth Window's width.
     /// @param iHeight Window's heigth.
@@ -37,6 +75,9 @@ public:
     void KeyInput(int iKey, int iAction);
 
 private:
+    /// Longest wait for an event while the image is converged, in seconds.
+    static constexpr double IDLE_TIMEOUT_SECONDS = 0.1;
+
     /// Create glfw's surface.
     void CreateSurface();
     /// Destroy glfw's surface.
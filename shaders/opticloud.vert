@@ -20,6 +20,13 @@ layout(binding = 3) uniform PointSize
 }
 pointSizeUbo;
 
+// Model matrix of each source cloud, indexed by the attribute byte of the color.
+layout(binding = 4) uniform CloudTransforms
+{
+    mat4 model[256];
+}
+cloudUbo;
+
 vec3 UIntToVec3(uint i)
 {
     vec4 v = unpackUnorm4x8(i);
@@ -30,7 +37,7 @@ void main()
 {
 
     gl_PointSize = pointSizeUbo.size;
-    gl_Position = modelUbo.MVP * vec4(inPosition, 1.0);
+    gl_Position = modelUbo.MVP * cloudUbo.model[inColor >> 24] * vec4(inPosition, 1.0);
     fragColor = UIntToVec3(inColor);
     vertexIndex = gl_VertexIndex;
 }
\ No newline at end of file
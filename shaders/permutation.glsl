@@ -0,0 +1,37 @@
+// Keyed bijection of [0, count), the GLSL side of Permutation (include/Permutation.h): the index goes through a
+// 4-round balanced Feistel network on 2 * halfBits bits until it falls back in range.
+
+uint PermutationRound(uint value, uint key)
+{
+    value ^= key;
+    value ^= value >> 16;
+    value *= 0x7feb352du;
+    value ^= value >> 15;
+    value *= 0x846ca68bu;
+    value ^= value >> 16;
+    return value;
+}
+
+uint PermutationEncrypt(uint value, uint halfBits, uvec4 keys)
+{
+    uint mask = (1u << halfBits) - 1u;
+    uint left = value >> halfBits;
+    uint right = value & mask;
+    for (int i = 0; i < 4; ++i)
+    {
+        uint next = left ^ (PermutationRound(right, keys[i]) & mask);
+        left = right;
+        right = next;
+    }
+    return left << halfBits | right;
+}
+
+uint Permute(uint index, uint count, uint halfBits, uvec4 keys)
+{
+    if (count <= 1u)
+        return index;
+    index = PermutationEncrypt(index, halfBits, keys);
+    while (index >= count)
+        index = PermutationEncrypt(index, halfBits, keys);
+    return index;
+}
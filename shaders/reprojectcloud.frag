@@ -9,11 +9,6 @@ layout(location = 1) out int outIndex;
 
 void main()
 {
-    //Invalid point
-    if (vertexIndex == -1)
-    {
-        discard;
-    }
     outColor = vec4((fragColor), 1.0);
     outIndex = vertexIndex;
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Writes the points kept by the compute rasterizer (see PointRasterizer).
+
+layout(location = 0) out vec4 outColor;
+layout(location = 1) out int outIndex;
+
+layout(binding = 0) uniform ScreenSize
+{
+    uint Width;
+    uint Height;
+}
+screenSize;
+
+// Binding 1: Nearest point of each pixel, read as (vertex index, depth) words. A pixel filled by HoleFillingPass has
+// the FILLED_BIT and its color in place of the vertex index.
+layout(std430, binding = 1) readonly buffer DepthIndex
+{
+    uvec2 depthIndex[];
+};
+
+const uint FILLED_BIT = 0x80000000u;
+
+struct OptiVertex
+{
+    vec3 pos;
+    uint color;
+};
+
+// Binding 2: Shuffled buffer, for the colors.
+layout(std140, binding = 2) readonly buffer Shuffled
+{
+    OptiVertex shuffledVertices[];
+};
+
+void main()
+{
+    uvec2 pixel = uvec2(gl_FragCoord.xy);
+    uvec2 point = depthIndex[pixel.y * screenSize.Width + pixel.x];
+    // No point: the gradient stays.
+    if (point.y == 0xFFFFFFFFu)
+    {
+        discard;
+    }
+    // A filled pixel has no point to reproject.
+    if ((point.x & FILLED_BIT) != 0u)
+    {
+        outColor = vec4(unpackUnorm4x8(point.x).rgb, 1.0);
+        outIndex = -1;
+    }
+    else
+    {
+        outColor = vec4(unpackUnorm4x8(shuffledVertices[point.x].color).rgb, 1.0);
+        outIndex = int(point.x);
+    }
+    gl_FragDepth = uintBitsToFloat(point.y);
+}
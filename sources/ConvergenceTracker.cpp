@@ -0,0 +1,18 @@
+#include "ConvergenceTracker.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+void ConvergenceTracker::Update(uint32_t iChangedPixelCount, uint32_t iPixelCount, bool iCameraStill, bool iDrawComplete)
+{
+    const bool stable = iCameraStill && iDrawComplete && iChangedPixelCount <= CHANGED_PIXEL_FRACTION * iPixelCount;
+    if (!stable)
+        m_StableFrameCount = 0;
+    else if (m_StableFrameCount < m_RequiredFrameCount)
+        m_StableFrameCount++;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ConvergenceTracker::SetFramesInFlight(uint32_t iFrameCount)
+{
+    m_RequiredFrameCount = STABLE_FRAME_COUNT + iFrameCount;
+    Reset();
+}
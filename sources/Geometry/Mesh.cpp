@@ -1,5 +1,9 @@
 #include "Geometry/Mesh.h"
+#include "IO/MeshReader.h"
 #include <glm/geometric.hpp>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
 
 //----------------------------------------------------------------------------------------------------------------------
 Mesh Mesh::InitCube()
@@ -37,10 +41,17 @@ Mesh Mesh::InitQuad()
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-Mesh Mesh::Load(const std::filesystem::path &)
+Mesh Mesh::Load(const std::filesystem::path &iFilePath)
 {
-    Mesh m;
-    return m;
+    std::string extension = iFilePath.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (extension == ".obj")
+        return ReadObjMesh(iFilePath);
+    if (extension == ".ply")
+        return ReadPlyMesh(iFilePath);
+
+    throw std::runtime_error("unsupported mesh format: " + iFilePath.string());
 }
 
 //----------------------------------------------------------------------------------------------------------------------
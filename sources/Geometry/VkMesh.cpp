@@ -15,6 +15,16 @@ void VkMesh::InitQuad()
     CreateIndexBuffer();
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+void VkMesh::Load(const std::filesystem::path &iFilePath)
+{
+    m_Mesh = Mesh::Load(iFilePath);
+    std::cout << "Mesh " << iFilePath << ": " << m_Mesh.Vertices.size() << " vertices, " << m_Mesh.Indices.size() / 3
+              << " triangles" << std::endl;
+    CreateVertexBuffer();
+    CreateIndexBuffer();
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void VkMesh::Destroy()
 {
@@ -1,12 +1,17 @@
 #include "Geometry/VkOptiCloud.h"
 #include "Geometry/CloudVertex.h"
-#include "Prime.h"
+#include "IO/CloudReader.h"
 #include "Olympus/CommandBuffer.h"
+#include "Olympus/Debug.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <random>
+#include <stdexcept>
 
 VkOptiCloud::VkOptiCloud(const olp::Device &iDevice)
-    : m_Device(iDevice)
+    : m_Device(iDevice),
+      m_StepCounter(std::make_unique<StepCounter>(iDevice))
 {
 }
 
@@ -37,37 +42,262 @@ void VkOptiCloud::Init()
               << " m_BufferSize : " << m_VertexBufferSize << std::endl;
 
     CreateVertexBuffer(points);
+    CreateResidentSlotBuffer(true);
+    m_NbLoadedVertex = m_NbVertex;
+    UpdateStepCounter();
     ResetDraw();
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::Stream(std::unique_ptr<CloudReader> iReader, bool iBackground)
+{
+    m_NbVertex = iReader->GetPointCount();
+    if (m_NbVertex == 0)
+        throw std::runtime_error("cannot create an opti cloud without points");
+    m_VertexBufferSize = static_cast<VkDeviceSize>(m_NbVertex) * sizeof(OptiCloudVertex);
+    m_NbLoadedVertex = 0;
+
+    const VkDeviceSize chunkSize = static_cast<VkDeviceSize>(ChunkStreamer::CHUNK_SIZE) * sizeof(OptiCloudVertex);
+    const VkDeviceSize budget = GetMemoryBudget();
+    const bool outOfCore = m_VertexBufferSize > budget;
+
+    // The residency evicts chunks as uniform samples of the cloud, the chunks of a file in order are whole regions.
+    if (outOfCore && !iReader->IsShuffled())
+        throw std::runtime_error("cloud too large for the device memory and not shuffled: convert it to .opc");
+
+    // The shuffle needs the cloud twice in device memory while it runs.
+    m_ShufflePending = !iReader->IsShuffled() && 2 * m_VertexBufferSize <= budget;
+    if (!iReader->IsShuffled() && !m_ShufflePending)
+        std::cout << "Cloud too large to be shuffled on the device, it is drawn in file order: convert it to .opc" << std::endl;
+    if (outOfCore)
+    {
+        const uint32_t slotCount = static_cast<uint32_t>(budget / chunkSize);
+        if (slotCount < 2)
+            throw std::runtime_error("not enough device memory to stream the cloud");
+        m_VertexBufferSize = slotCount * chunkSize;
+        std::cout << "Stream out-of-core opti cloud with " << m_NbVertex << " points in a working set of " << slotCount
+                  << " chunks. m_BufferSize : " << m_VertexBufferSize << std::endl;
+    }
+    else
+    {
+        std::cout << "Stream opti cloud with " << m_NbVertex << " points. m_BufferSize : " << m_VertexBufferSize << std::endl;
+    }
+
+    m_VertexBuffer = m_Device.CreateMemoryBuffer(
+        m_VertexBufferSize,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    CreateResidentSlotBuffer(!outOfCore);
+
+    if (outOfCore)
+    {
+        m_Residency = std::make_unique<ChunkResidency>(
+            m_Device,
+            std::move(iReader),
+            m_VertexBuffer.Buffer,
+            static_cast<uint32_t>(m_VertexBufferSize / chunkSize),
+            m_ResidentSlots);
+    }
+    else
+    {
+        // The residency needs the draws to pick its chunks, so only a fully resident cloud is uploaded upfront.
+        // A cloud to shuffle is copied on the graphics queue, which then runs the shuffle: nothing is drawn before.
+        m_BackgroundUpload = iBackground && !m_ShufflePending;
+        m_AcquirePending = false;
+        if (m_ShufflePending)
+            CreateFileOrderBuffer();
+        m_Streamer = std::make_unique<ChunkStreamer>(
+            m_Device, std::move(iReader), m_ShufflePending ? m_FileOrderBuffer.Buffer : m_VertexBuffer.Buffer, m_BackgroundUpload);
+        m_LoadedChunks.assign(m_Streamer->GetChunkCount(), false);
+        m_LoadedChunkPrefix = 0;
+        for (uint32_t chunk = 0; chunk < m_Streamer->GetChunkCount(); ++chunk)
+            m_Streamer->Request(chunk, chunk * chunkSize);
+    }
+    UpdateStepCounter();
+    ResetDraw();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::UpdateStreaming()
+{
+    VkSemaphore prepareSemaphore = VK_NULL_HANDLE;
+    UpdateStreaming(prepareSemaphore);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::UpdateStreaming(VkSemaphore &ioPrepareSemaphore)
+{
+    if (m_ShufflePass && m_ShufflePass->IsFinished())
+    {
+        m_ShufflePass.reset();
+        m_FileOrderBuffer.Destroy();
+    }
+
+    if (m_Residency)
+    {
+        m_Residency->Update(ioPrepareSemaphore);
+        return;
+    }
+    if (!m_Streamer)
+        return;
+
+    if (m_BackgroundUpload)
+    {
+        // Nothing is drawn before the join, which makes the whole cloud visible at once through the semaphore.
+        m_Streamer->Update();
+        if (m_Streamer->GetPendingCount() == 0 && m_NbLoadedVertex == m_NbVertex && !m_AcquirePending)
+        {
+            std::cout << "Opti cloud fully loaded" << std::endl;
+            m_Streamer.reset();
+            m_LoadedChunks.clear();
+        }
+        return;
+    }
+
+    // Only the loaded prefix of the cloud is drawn, so a step is never drawn with holes.
+    for (uint32_t chunk : m_Streamer->Update())
+        m_LoadedChunks[chunk] = true;
+    while (m_LoadedChunkPrefix < m_LoadedChunks.size() && m_LoadedChunks[m_LoadedChunkPrefix])
+        ++m_LoadedChunkPrefix;
+    m_NbLoadedVertex = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(m_LoadedChunkPrefix) * ChunkStreamer::CHUNK_SIZE, m_NbVertex));
+
+    // A prefix of the file order is not a sample of the cloud: wait for the whole cloud to shuffle it.
+    if (m_ShufflePending)
+    {
+        if (m_NbLoadedVertex < m_NbVertex)
+        {
+            m_NbLoadedVertex = 0;
+            return;
+        }
+        SubmitShuffle();
+    }
+
+    UpdateStepCounter();
+    if (m_NbLoadedVertex == m_NbVertex)
+    {
+        std::cout << "Opti cloud fully loaded" << std::endl;
+        m_Streamer.reset();
+        m_LoadedChunks.clear();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool VkOptiCloud::IsReadyToJoin() const
+{
+    if (m_ShufflePending)
+        return false;
+    return !m_Streamer || !m_BackgroundUpload || m_Streamer->IsSubmitted();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+VkSemaphore VkOptiCloud::TakeUploadSemaphore()
+{
+    if (!m_Streamer || !m_BackgroundUpload)
+        return VK_NULL_HANDLE;
+
+    m_NbLoadedVertex = m_NbVertex;
+    UpdateStepCounter();
+    m_AcquirePending = true;
+    return m_Streamer->TakeSemaphore();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::RecordPendingAcquire(VkCommandBuffer iCommandBuffer)
+{
+    if (!m_AcquirePending)
+        return;
+
+    m_Streamer->RecordAcquire(iCommandBuffer);
+    m_AcquirePending = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+VkDeviceSize VkOptiCloud::GetMemoryBudget() const
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(m_Device.GetPhysicalDevice(), &memoryProperties);
+    VkDeviceSize deviceMemory = 0;
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            deviceMemory = std::max(deviceMemory, memoryProperties.memoryHeaps[i].size);
+    }
+
+    // The rest of the memory is left to the swapchain, the meshes and the other applications.
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_Device.GetPhysicalDevice(), &properties);
+    return std::min<VkDeviceSize>(deviceMemory / 2, properties.limits.maxStorageBufferRange);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void VkOptiCloud::DestroyReprojectedBuffer()
 {
     m_ReprojectedBuffer.Destroy();
+    m_ReprojectedDrawBuffer.Destroy();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void VkOptiCloud::Destroy()
 {
+    m_Streamer.reset();
+    m_Residency.reset();
+    m_ShufflePass.reset();
+    m_ShufflePending = false;
+    m_FileOrderBuffer.Destroy();
+    m_BackgroundUpload = false;
+    m_AcquirePending = false;
     m_VertexBuffer.Destroy();
+    if (m_ResidentSlots)
+        vkUnmapMemory(m_Device.GetDevice(), m_ResidentSlotBuffer.Memory);
+    m_ResidentSlots = nullptr;
+    m_ResidentSlotBuffer.Destroy();
     DestroyReprojectedBuffer();
+    m_StepCounter.reset();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-void VkOptiCloud::DrawVertexBuffer(VkCommandBuffer iCommandBuffer)
+void VkOptiCloud::SetPointsByStep(uint32_t iPointCount)
 {
-    if (m_Step * m_NbPointByStep >= m_NbVertex)
-        return;
+    m_NbPointByStep = iPointCount;
+    UpdateStepCounter();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::UpdateStepCounter()
+{
+    m_StepCounter->SetPointCounts(m_NbVertex, m_NbLoadedVertex, m_NbPointByStep);
+}
 
-    uint32_t drawPointCount = m_NbVertex - m_Step * m_NbPointByStep;
-    drawPointCount = std::min(drawPointCount, m_NbPointByStep);
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::RecordAdvance(VkCommandBuffer iCommandBuffer, uint32_t iSlot)
+{
+    if (!m_Residency)
+        m_StepCounter->RecordAdvance(iCommandBuffer, iSlot);
+}
 
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::DrawVertexBuffer(VkCommandBuffer iCommandBuffer, uint32_t iSlot)
+{
     VkBuffer vertexBuffers[] = {m_VertexBuffer.Buffer};
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(iCommandBuffer, 0, 1, vertexBuffers, offsets);
-    vkCmdDraw(
-        iCommandBuffer, drawPointCount, 1, m_Step * m_NbPointByStep, 0);
-    m_Step++;
+    if (m_Residency)
+        RecordStep([iCommandBuffer](uint32_t iFirst, uint32_t iCount) { vkCmdDraw(iCommandBuffer, iCount, 1, iFirst, 0); }, iSlot);
+    else
+        m_StepCounter->RecordDraw(iCommandBuffer);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::RecordStep(const std::function<void(uint32_t, uint32_t)> &iRecordRange, uint32_t iSlot)
+{
+    if (!m_Residency || m_Residency->IsPassFinished())
+        return;
+
+    // The resident chunks are only known while recording: the size of the step is written by the host.
+    const uint32_t drawPointCount = m_Residency->DrawNext(iRecordRange, m_NbPointByStep);
+    m_StepCounter->SetStepPointCount(iSlot, drawPointCount);
+    if (drawPointCount > 0)
+        m_Step++;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -76,7 +306,7 @@ void VkOptiCloud::DrawReprojectedBuffer(VkCommandBuffer iCommandBuffer)
     VkBuffer vertexBuffers[] = {m_ReprojectedBuffer.Buffer};
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(iCommandBuffer, 0, 1, vertexBuffers, offsets);
-    vkCmdDraw(iCommandBuffer, m_NbReprojectedVertex, 1, 0, 0);
+    vkCmdDrawIndirect(iCommandBuffer, m_ReprojectedDrawBuffer.Buffer, 0, 1, sizeof(VkDrawIndirectCommand));
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -98,6 +328,44 @@ void VkOptiCloud::CreateVertexBuffer(const std::vector<OptiCloudVertex> &iPoints
     stagingBuffer.Destroy();
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::CreateResidentSlotBuffer(bool iResident)
+{
+    const VkDeviceSize chunkSize = static_cast<VkDeviceSize>(ChunkStreamer::CHUNK_SIZE) * sizeof(OptiCloudVertex);
+    const VkDeviceSize slotCount = std::max<VkDeviceSize>((m_VertexBufferSize + chunkSize - 1) / chunkSize, 1);
+    const VkDeviceSize bufferSize = slotCount * sizeof(uint32_t);
+
+    // Written by the host as the working set changes, read by each prepare pass.
+    m_ResidentSlotBuffer = m_Device.CreateMemoryBuffer(
+        bufferSize,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    void *data = nullptr;
+    VK_CHECK_RESULT(vkMapMemory(m_Device.GetDevice(), m_ResidentSlotBuffer.Memory, 0, bufferSize, 0, &data))
+    m_ResidentSlots = static_cast<uint32_t *>(data);
+    std::fill(m_ResidentSlots, m_ResidentSlots + slotCount, iResident ? 1u : 0u);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::CreateFileOrderBuffer()
+{
+    m_FileOrderBuffer = m_Device.CreateMemoryBuffer(
+        m_VertexBufferSize,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::SubmitShuffle()
+{
+    const auto start = std::chrono::steady_clock::now();
+    m_ShufflePass = std::make_unique<ShufflePass>(m_Device, m_FileOrderBuffer.Buffer, m_VertexBuffer.Buffer, m_NbVertex);
+    m_ShufflePass->Submit();
+    m_ShufflePending = false;
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Shuffle of " << m_NbVertex << " points submitted in " << elapsed.count() << " s" << std::endl;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void VkOptiCloud::CreateReprojectedBuffer(uint32_t iWidth, uint32_t iHeight)
 {
@@ -107,9 +375,41 @@ void VkOptiCloud::CreateReprojectedBuffer(uint32_t iWidth, uint32_t iHeight)
         m_ReprojectedBufferSize,
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // Nothing to reproject before the first prepare pass. The command is small, it stays in host memory.
+    const std::vector<VkDrawIndirectCommand> drawCommand{{0, 1, 0, 0}};
+    m_ReprojectedDrawBuffer = m_Device.CreateMemoryBuffer(
+        sizeof(VkDrawIndirectCommand),
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    m_ReprojectedDrawBuffer.TransferDataInBuffer(drawCommand, sizeof(VkDrawIndirectCommand));
 }
+
+//----------------------------------------------------------------------------------------------------------------------
+bool VkOptiCloud::IsDrawComplete() const
+{
+    if (m_Residency)
+        return m_Residency->IsPassFinished();
+    return !m_Streamer && !m_ShufflePending && !m_AcquirePending && m_StepCounter->IsComplete();
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void VkOptiCloud::ResetDraw()
 {
     m_Step = 0;
+    m_StepCounter->Rewind(1.0f);
+    if (m_Residency)
+        m_Residency->ResetPass();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void VkOptiCloud::RewindDraw(float iFraction)
+{
+    if (m_Residency || iFraction >= 1.0f)
+    {
+        ResetDraw();
+        return;
+    }
+
+    m_StepCounter->Rewind(std::max(iFraction, 0.0f));
 }
\ No newline at end of file
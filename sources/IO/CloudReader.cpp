@@ -0,0 +1,26 @@
+#include "IO/CloudReader.h"
+#include "IO/LasReader.h"
+#include "IO/OpcReader.h"
+#include "IO/PlyReader.h"
+#include "IO/XyzReader.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+//----------------------------------------------------------------------------------------------------------------------
+std::unique_ptr<CloudReader> CloudReader::Open(const std::filesystem::path &iFilePath)
+{
+    std::string extension = iFilePath.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (extension == ".ply")
+        return std::make_unique<PlyReader>(iFilePath);
+    if (extension == ".las" || extension == ".laz")
+        return std::make_unique<LasReader>(iFilePath);
+    if (extension == ".opc")
+        return std::make_unique<OpcReader>(iFilePath);
+    if (extension == ".xyz" || extension == ".pts" || extension == ".txt")
+        return std::make_unique<XyzReader>(iFilePath);
+
+    throw std::runtime_error("unsupported cloud format: " + iFilePath.string());
+}
@@ -0,0 +1,159 @@
+#include "IO/LasReader.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CLOUD_RENDERING_LAS_SSE2
+#endif
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T>
+T Load(const uint8_t *iData)
+{
+    T value;
+    std::memcpy(&value, iData, sizeof(T));
+    return value;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t GetColorOffset(uint8_t iPointFormat)
+{
+    switch (iPointFormat)
+    {
+    case 2:
+        return 20;
+    case 3:
+    case 5:
+        return 28;
+    case 7:
+    case 8:
+    case 10:
+        return 30;
+    default:
+        return 0;
+    }
+}
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+LasReader::LasReader(const std::filesystem::path &iFilePath)
+    : m_File(iFilePath)
+{
+    const std::string error = "invalid LAS file " + iFilePath.string() + ": ";
+    const uint8_t *data = m_File.GetData();
+
+    if (m_File.GetSize() < 227 || std::memcmp(data, "LASF", 4) != 0)
+        throw std::runtime_error(error + "missing LASF signature");
+
+    const uint8_t versionMinor = data[25];
+    const uint8_t pointFormat = data[104];
+    if (pointFormat & 0xC0)
+        throw std::runtime_error(error + "compressed (LAZ) point data is not supported, decompress it first");
+    if (pointFormat > 10)
+        throw std::runtime_error(error + "unknown point data format " + std::to_string(pointFormat));
+
+    m_PointOffset = Load<uint32_t>(data + 96);
+    m_RecordLength = Load<uint16_t>(data + 105);
+    m_ColorOffset = GetColorOffset(pointFormat);
+
+    uint64_t pointCount = Load<uint32_t>(data + 107);
+    if (versionMinor >= 4 && m_File.GetSize() >= 255)
+        pointCount = std::max<uint64_t>(pointCount, Load<uint64_t>(data + 247));
+    if (pointCount > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error(error + "too many points");
+    m_PointCount = static_cast<uint32_t>(pointCount);
+
+    // Every format starts with X, Y, Z, Intensity: the decoder reads these 16 bytes at once.
+    if (m_RecordLength < 20 || (m_ColorOffset != 0 && m_RecordLength < m_ColorOffset + 6))
+        throw std::runtime_error(error + "point records are too short");
+    if (m_PointOffset + static_cast<size_t>(m_PointCount) * m_RecordLength > m_File.GetSize())
+        throw std::runtime_error(error + "file is truncated");
+
+    const glm::dvec3 scale(Load<double>(data + 131), Load<double>(data + 139), Load<double>(data + 147));
+    const glm::dvec3 offset(Load<double>(data + 155), Load<double>(data + 163), Load<double>(data + 171));
+    const glm::dvec3 max(Load<double>(data + 179), Load<double>(data + 195), Load<double>(data + 211));
+    const glm::dvec3 min(Load<double>(data + 187), Load<double>(data + 203), Load<double>(data + 219));
+
+    m_Origin = (min + max) * 0.5;
+    m_Scale = scale;
+    m_Offset = offset - m_Origin;
+
+    DetectColorDepth();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void LasReader::DetectColorDepth()
+{
+    if (m_ColorOffset == 0)
+        return;
+
+    // Many writers store 8-bit colors in the 16-bit fields, keep them unshifted in that case.
+    const uint32_t sampleCount = std::min(m_PointCount, 65'536u);
+    const uint8_t *record = m_File.GetData() + m_PointOffset + m_ColorOffset;
+    for (uint32_t i = 0; i < sampleCount; ++i, record += m_RecordLength)
+    {
+        if ((Load<uint16_t>(record) | Load<uint16_t>(record + 2) | Load<uint16_t>(record + 4)) > 255)
+            return;
+    }
+    m_ColorShift = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void LasReader::ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const
+{
+    const uint8_t *record = m_File.GetData() + m_PointOffset + static_cast<size_t>(iFirst) * m_RecordLength;
+
+#ifdef CLOUD_RENDERING_LAS_SSE2
+    // X and Y are dequantized together, Z shares a register with the intensity which is scaled to 0.
+    const __m128d scaleXY = _mm_set_pd(m_Scale.y, m_Scale.x);
+    const __m128d offsetXY = _mm_set_pd(m_Offset.y, m_Offset.x);
+    const __m128d scaleZ = _mm_set_pd(0.0, m_Scale.z);
+    const __m128d offsetZ = _mm_set_pd(0.0, m_Offset.z);
+    const __m128i colorShift = _mm_cvtsi32_si128(m_ColorShift);
+    const __m128i white = _mm_cvtsi32_si128(0x00FFFFFF);
+
+    for (uint32_t i = 0; i < iCount; ++i, record += m_RecordLength)
+    {
+        const __m128i xyzi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(record));
+        const __m128d xy = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(xyzi), scaleXY), offsetXY);
+        const __m128d z = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(xyzi, 8)), scaleZ), offsetZ);
+        const __m128i position = _mm_castps_si128(_mm_movelh_ps(_mm_cvtpd_ps(xy), _mm_cvtpd_ps(z)));
+
+        __m128i color = white;
+        if (m_ColorOffset != 0)
+        {
+            uint64_t rgb = 0;
+            std::memcpy(&rgb, record + m_ColorOffset, 6);
+            color = _mm_srl_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(&rgb)), colorShift);
+            color = _mm_packus_epi16(color, color);
+        }
+
+        // The last lane holds 0.0f, replace it by the packed color and attribute.
+        const __m128i vertex = _mm_or_si128(position, _mm_slli_si128(color, 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(oPoints + i), vertex);
+    }
+#else
+    for (uint32_t i = 0; i < iCount; ++i, record += m_RecordLength)
+    {
+        oPoints[i].Pos.x = static_cast<float>(Load<int32_t>(record) * m_Scale.x + m_Offset.x);
+        oPoints[i].Pos.y = static_cast<float>(Load<int32_t>(record + 4) * m_Scale.y + m_Offset.y);
+        oPoints[i].Pos.z = static_cast<float>(Load<int32_t>(record + 8) * m_Scale.z + m_Offset.z);
+        if (m_ColorOffset != 0)
+        {
+            oPoints[i].Color.r = static_cast<uint8_t>(std::min(Load<uint16_t>(record + m_ColorOffset) >> m_ColorShift, 255));
+            oPoints[i].Color.g = static_cast<uint8_t>(std::min(Load<uint16_t>(record + m_ColorOffset + 2) >> m_ColorShift, 255));
+            oPoints[i].Color.b = static_cast<uint8_t>(std::min(Load<uint16_t>(record + m_ColorOffset + 4) >> m_ColorShift, 255));
+        }
+        else
+        {
+            oPoints[i].Color = glm::u8vec3(255);
+        }
+        oPoints[i].Attribute = 0;
+    }
+#endif
+}
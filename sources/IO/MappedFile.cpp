@@ -0,0 +1,175 @@
+#include "IO/MappedFile.h"
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+MappedFile::MappedFile(const std::filesystem::path &iFilePath)
+{
+#ifdef _WIN32
+    m_File = CreateFileW(
+        iFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+    {
+        m_File = nullptr;
+        throw std::runtime_error("failed to open " + iFilePath.string());
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(m_File, &size))
+    {
+        Close();
+        throw std::runtime_error("failed to stat " + iFilePath.string());
+    }
+    m_Size = static_cast<size_t>(size.QuadPart);
+    if (m_Size == 0)
+        return;
+
+    m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_Mapping == nullptr)
+    {
+        Close();
+        throw std::runtime_error("failed to map " + iFilePath.string());
+    }
+    m_Data = static_cast<const uint8_t *>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    int fd = open(iFilePath.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("failed to open " + iFilePath.string());
+
+    struct stat status
+    {
+    };
+    if (fstat(fd, &status) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("failed to stat " + iFilePath.string());
+    }
+    m_Size = static_cast<size_t>(status.st_size);
+    if (m_Size == 0)
+    {
+        close(fd);
+        return;
+    }
+
+    void *data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference on the file.
+    close(fd);
+    if (data != MAP_FAILED)
+        m_Data = static_cast<const uint8_t *>(data);
+#endif
+
+    if (m_Data == nullptr)
+    {
+        Close();
+        throw std::runtime_error("failed to map " + iFilePath.string());
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+MappedFile::MappedFile(const std::filesystem::path &iFilePath, size_t iSize)
+    : m_Size(iSize)
+{
+#ifdef _WIN32
+    m_File = CreateFileW(
+        iFilePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+    {
+        m_File = nullptr;
+        throw std::runtime_error("failed to create " + iFilePath.string());
+    }
+    if (m_Size == 0)
+        return;
+
+    const uint64_t size = m_Size;
+    m_Mapping = CreateFileMappingW(
+        m_File, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), nullptr);
+    if (m_Mapping == nullptr)
+    {
+        Close();
+        throw std::runtime_error("failed to map " + iFilePath.string());
+    }
+    m_Data = static_cast<const uint8_t *>(MapViewOfFile(m_Mapping, FILE_MAP_WRITE, 0, 0, 0));
+#else
+    int fd = open(iFilePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("failed to create " + iFilePath.string());
+    if (m_Size == 0)
+    {
+        close(fd);
+        return;
+    }
+    if (ftruncate(fd, static_cast<off_t>(m_Size)) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("failed to resize " + iFilePath.string());
+    }
+
+    void *data = mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data != MAP_FAILED)
+        m_Data = static_cast<const uint8_t *>(data);
+#endif
+
+    if (m_Data == nullptr)
+    {
+        Close();
+        throw std::runtime_error("failed to map " + iFilePath.string());
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+MappedFile::MappedFile(MappedFile &&ioFile) noexcept
+{
+    *this = std::move(ioFile);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+MappedFile &MappedFile::operator=(MappedFile &&ioFile) noexcept
+{
+    if (this != &ioFile)
+    {
+        Close();
+        m_Data = std::exchange(ioFile.m_Data, nullptr);
+        m_Size = std::exchange(ioFile.m_Size, 0);
+#ifdef _WIN32
+        m_File = std::exchange(ioFile.m_File, nullptr);
+        m_Mapping = std::exchange(ioFile.m_Mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+    if (m_File)
+        CloseHandle(m_File);
+    m_Mapping = nullptr;
+    m_File = nullptr;
+#else
+    if (m_Data)
+        munmap(const_cast<uint8_t *>(m_Data), m_Size);
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+}
@@ -0,0 +1,596 @@
+#include "IO/MeshReader.h"
+#include "IO/MappedFile.h"
+#include "IO/PlyHeader.h"
+#include "IO/TextParsing.h"
+#include "Parallel.h"
+#include <glm/geometric.hpp>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+/// Marks an OBJ index relative to the range which references it (negative index in the file).
+constexpr int64_t RELATIVE_INDEX = int64_t(1) << 62;
+
+/// Reference to an OBJ position and normal, as found in a face.
+struct VertexRef
+{
+    /// Position index, global or relative to the range.
+    int64_t Position = 0;
+    /// Normal index, global or relative to the range, -1 if absent.
+    int64_t Normal = -1;
+
+    bool operator==(const VertexRef &iOther) const { return Position == iOther.Position && Normal == iOther.Normal; }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t Mix(uint64_t iValue)
+{
+    iValue ^= iValue >> 33;
+    iValue *= 0xff51afd7ed558ccdull;
+    iValue ^= iValue >> 33;
+    iValue *= 0xc4ceb9fe1a85ec53ull;
+    iValue ^= iValue >> 33;
+    return iValue;
+}
+
+/// Hash of a vertex reference.
+struct VertexRefHash
+{
+    size_t operator()(const VertexRef &iRef) const { return static_cast<size_t>(Mix(static_cast<uint64_t>(iRef.Position) ^ Mix(static_cast<uint64_t>(iRef.Normal)))); }
+};
+
+/// Result of the parsing of a range of OBJ lines.
+struct ObjRange
+{
+    /// Positions declared in the range.
+    std::vector<glm::vec3> Positions;
+    /// Normals declared in the range.
+    std::vector<glm::vec3> Normals;
+    /// Distinct vertices referenced by the faces of the range.
+    std::vector<VertexRef> Refs;
+    /// Triangle corners, as indices in Refs.
+    std::vector<uint32_t> Indices;
+    /// Resolved Refs: global position << 32 | (global normal + 1), 0 in the low bits without normal.
+    std::vector<uint64_t> Keys;
+    /// Index in the merged mesh of each of the Refs.
+    std::vector<uint32_t> Remap;
+    /// Number of positions, normals and indices in the preceding ranges.
+    size_t FirstPosition = 0;
+    size_t FirstNormal = 0;
+    size_t FirstIndex = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+int64_t EncodeObjIndex(int64_t iFileIndex, size_t iLocalCount, const std::string &iError)
+{
+    if (iFileIndex > 0)
+        return iFileIndex - 1;
+    if (iFileIndex < 0)
+        return RELATIVE_INDEX + static_cast<int64_t>(iLocalCount) + iFileIndex;
+    throw std::runtime_error(iError + "index 0 in a face");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t DecodeObjIndex(int64_t iIndex, size_t iFirst, size_t iCount, const std::string &iError)
+{
+    const int64_t index = iIndex >= RELATIVE_INDEX / 2 ? static_cast<int64_t>(iFirst) + (iIndex - RELATIVE_INDEX) : iIndex;
+    if (index < 0 || static_cast<uint64_t>(index) >= iCount)
+        throw std::runtime_error(iError + "face index out of range");
+    return static_cast<uint64_t>(index);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ParseObjRange(std::string_view iText, ObjRange &oRange, const std::string &iError)
+{
+    const char *cursor = iText.data();
+    const char *end = iText.data() + iText.size();
+
+    auto isKeyword = [&cursor, end](std::string_view iKeyword)
+    {
+        const size_t length = iKeyword.size();
+        return static_cast<size_t>(end - cursor) > length && std::memcmp(cursor, iKeyword.data(), length) == 0 &&
+               (cursor[length] == ' ' || cursor[length] == '\t');
+    };
+
+    std::unordered_map<VertexRef, uint32_t, VertexRefHash> refIds;
+    std::vector<uint32_t> polygon;
+    while (cursor != end)
+    {
+        cursor = SkipBlanks(cursor, end);
+        if (isKeyword("v") || isKeyword("vn"))
+        {
+            std::vector<glm::vec3> &vectors = cursor[1] == 'n' ? oRange.Normals : oRange.Positions;
+            cursor += cursor[1] == 'n' ? 2 : 1;
+            glm::vec3 v;
+            if (!ParseNumber(cursor, end, v.x) || !ParseNumber(cursor, end, v.y) || !ParseNumber(cursor, end, v.z))
+                throw std::runtime_error(iError + "malformed vertex");
+            vectors.push_back(v);
+        }
+        else if (isKeyword("f"))
+        {
+            ++cursor;
+            polygon.clear();
+            int64_t position = 0;
+            while (ParseNumber(cursor, end, position))
+            {
+                int64_t normal = 0;
+                if (cursor != end && *cursor == '/')
+                {
+                    ++cursor;
+                    int64_t texCoord = 0;
+                    if (cursor != end && *cursor != '/' && !ParseNumber(cursor, end, texCoord))
+                        throw std::runtime_error(iError + "malformed face");
+                    if (cursor != end && *cursor == '/')
+                    {
+                        ++cursor;
+                        if (!ParseNumber(cursor, end, normal))
+                            throw std::runtime_error(iError + "malformed face");
+                    }
+                }
+
+                VertexRef ref;
+                ref.Position = EncodeObjIndex(position, oRange.Positions.size(), iError);
+                if (normal != 0)
+                    ref.Normal = EncodeObjIndex(normal, oRange.Normals.size(), iError);
+
+                const auto [it, inserted] = refIds.try_emplace(ref, static_cast<uint32_t>(oRange.Refs.size()));
+                if (inserted)
+                    oRange.Refs.push_back(ref);
+                polygon.push_back(it->second);
+            }
+
+            for (size_t i = 2; i < polygon.size(); ++i)
+                oRange.Indices.insert(oRange.Indices.end(), {polygon[0], polygon[i - 1], polygon[i]});
+        }
+        cursor = SkipLine(cursor, end);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ComputeMissingNormals(Mesh &ioMesh)
+{
+    std::vector<char> missing(ioMesh.Vertices.size());
+    bool anyMissing = false;
+    for (size_t i = 0; i < ioMesh.Vertices.size(); ++i)
+    {
+        missing[i] = ioMesh.Vertices[i].Normal == glm::vec3(0.0f);
+        anyMissing |= missing[i] != 0;
+    }
+    if (!anyMissing)
+        return;
+
+    // Area weighted average of the adjacent faces.
+    for (size_t i = 0; i + 2 < ioMesh.Indices.size(); i += 3)
+    {
+        const uint32_t *corners = &ioMesh.Indices[i];
+        const glm::vec3 &a = ioMesh.Vertices[corners[0]].Pos;
+        const glm::vec3 normal = glm::cross(ioMesh.Vertices[corners[1]].Pos - a, ioMesh.Vertices[corners[2]].Pos - a);
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            if (missing[corners[k]])
+                ioMesh.Vertices[corners[k]].Normal += normal;
+        }
+    }
+
+    for (size_t i = 0; i < ioMesh.Vertices.size(); ++i)
+    {
+        glm::vec3 &normal = ioMesh.Vertices[i].Normal;
+        if (missing[i] && normal != glm::vec3(0.0f))
+            normal = glm::normalize(normal);
+    }
+}
+
+/// Layout of the PLY elements used to build a mesh.
+struct PlyMeshLayout
+{
+    /// Index of the vertex and face elements.
+    int VertexElement = -1;
+    int FaceElement = -1;
+    /// Index of the x, y, z and nx, ny, nz properties, -1 for absent normals.
+    int Position[3] = {-1, -1, -1};
+    int Normal[3] = {-1, -1, -1};
+    /// Index of the vertex index list of the faces.
+    int Indices = -1;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+void FanTriangulate(const std::vector<int64_t> &iPolygon, uint32_t iVertexCount, std::vector<uint32_t> &oIndices, const std::string &iError)
+{
+    for (int64_t index : iPolygon)
+    {
+        if (index < 0 || index >= iVertexCount)
+            throw std::runtime_error(iError + "face index out of range");
+    }
+    for (size_t i = 2; i < iPolygon.size(); ++i)
+    {
+        oIndices.insert(
+            oIndices.end(),
+            {static_cast<uint32_t>(iPolygon[0]), static_cast<uint32_t>(iPolygon[i - 1]), static_cast<uint32_t>(iPolygon[i])});
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ReadAsciiPly(std::string_view iContent, const PlyHeader &iHeader, const PlyMeshLayout &iLayout, Mesh &oMesh, const std::string &iError)
+{
+    const std::vector<std::string_view> texts = SplitLines(iContent.substr(iHeader.DataOffset), GetWorkerCount());
+    const uint32_t rangeCount = static_cast<uint32_t>(texts.size());
+
+    // Every record is one line: the line index tells the element of a line.
+    std::vector<uint64_t> firstLines(rangeCount + 1, 0);
+    ParallelFor(rangeCount, [&](uint32_t i) { firstLines[i + 1] = CountLines(texts[i]); });
+    for (uint32_t i = 0; i < rangeCount; ++i)
+        firstLines[i + 1] += firstLines[i];
+
+    std::vector<uint64_t> elementFirstLines(iHeader.Elements.size() + 1, 0);
+    for (size_t e = 0; e < iHeader.Elements.size(); ++e)
+        elementFirstLines[e + 1] = elementFirstLines[e] + iHeader.Elements[e].Count;
+    if (firstLines.back() < elementFirstLines[std::max(iLayout.VertexElement, iLayout.FaceElement) + 1])
+        throw std::runtime_error(iError + "file is truncated");
+
+    const PlyHeader::Element &vertex = iHeader.Elements[iLayout.VertexElement];
+    const PlyHeader::Element &face = iHeader.Elements[iLayout.FaceElement];
+    const uint32_t vertexCount = static_cast<uint32_t>(vertex.Count);
+    std::vector<std::vector<uint32_t>> triangles(rangeCount);
+
+    ParallelFor(
+        rangeCount,
+        [&](uint32_t iRange)
+        {
+            const char *cursor = texts[iRange].data();
+            const char *end = cursor + texts[iRange].size();
+            std::vector<double> values(vertex.Properties.size());
+            std::vector<int64_t> polygon;
+
+            for (uint64_t line = firstLines[iRange]; cursor != end; ++line)
+            {
+                if (line >= elementFirstLines[iLayout.VertexElement] && line < elementFirstLines[iLayout.VertexElement + 1])
+                {
+                    for (double &value : values)
+                    {
+                        if (!ParseNumber(cursor, end, value))
+                            throw std::runtime_error(iError + "malformed vertex");
+                    }
+                    MeshVertex &v = oMesh.Vertices[line - elementFirstLines[iLayout.VertexElement]];
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        v.Pos[k] = static_cast<float>(values[iLayout.Position[k]]);
+                        if (iLayout.Normal[k] >= 0)
+                            v.Normal[k] = static_cast<float>(values[iLayout.Normal[k]]);
+                    }
+                }
+                else if (line >= elementFirstLines[iLayout.FaceElement] && line < elementFirstLines[iLayout.FaceElement + 1])
+                {
+                    for (size_t p = 0; p < face.Properties.size(); ++p)
+                    {
+                        uint64_t count = 1;
+                        if (face.Properties[p].IsList && !ParseNumber(cursor, end, count))
+                            throw std::runtime_error(iError + "malformed face");
+                        if (static_cast<int>(p) == iLayout.Indices)
+                            polygon.resize(count);
+                        for (uint64_t i = 0; i < count; ++i)
+                        {
+                            double value = 0.0;
+                            if (!ParseNumber(cursor, end, value))
+                                throw std::runtime_error(iError + "malformed face");
+                            if (static_cast<int>(p) == iLayout.Indices)
+                                polygon[i] = static_cast<int64_t>(value);
+                        }
+                    }
+                    FanTriangulate(polygon, vertexCount, triangles[iRange], iError);
+                }
+                cursor = SkipLine(cursor, end);
+            }
+        });
+
+    std::vector<size_t> firstIndices(rangeCount + 1, 0);
+    for (uint32_t i = 0; i < rangeCount; ++i)
+        firstIndices[i + 1] = firstIndices[i] + triangles[i].size();
+    oMesh.Indices.resize(firstIndices.back());
+    ParallelFor(rangeCount, [&](uint32_t i) { std::copy(triangles[i].begin(), triangles[i].end(), oMesh.Indices.begin() + firstIndices[i]); });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ReadBinaryPly(std::string_view iContent, const PlyHeader &iHeader, const PlyMeshLayout &iLayout, Mesh &oMesh, const std::string &iError)
+{
+    using ScalarType = PlyHeader::ScalarType;
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(iContent.data());
+    const PlyHeader::Element &vertex = iHeader.Elements[iLayout.VertexElement];
+    const PlyHeader::Element &face = iHeader.Elements[iLayout.FaceElement];
+    const uint32_t vertexCount = static_cast<uint32_t>(vertex.Count);
+
+    if (vertex.Stride == 0)
+        throw std::runtime_error(iError + "list properties in the vertex element are not supported");
+    const size_t vertexOffset = iHeader.GetElementOffset(iLayout.VertexElement);
+    if (vertexOffset + static_cast<size_t>(vertexCount) * vertex.Stride > iContent.size())
+        throw std::runtime_error(iError + "file is truncated");
+
+    const uint32_t workerCount = std::min(GetWorkerCount(), std::max(vertexCount, 1u));
+    ParallelFor(
+        workerCount,
+        [&](uint32_t iWorker)
+        {
+            const uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(vertexCount) * iWorker / workerCount);
+            const uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(vertexCount) * (iWorker + 1) / workerCount);
+            for (uint32_t i = first; i < last; ++i)
+            {
+                const uint8_t *record = data + vertexOffset + static_cast<size_t>(i) * vertex.Stride;
+                MeshVertex &v = oMesh.Vertices[i];
+                for (int k = 0; k < 3; ++k)
+                {
+                    const PlyHeader::Property &position = vertex.Properties[iLayout.Position[k]];
+                    v.Pos[k] = static_cast<float>(PlyHeader::LoadScalar(record + position.Offset, position.Type));
+                    if (iLayout.Normal[k] >= 0)
+                    {
+                        const PlyHeader::Property &normal = vertex.Properties[iLayout.Normal[k]];
+                        v.Normal[k] = static_cast<float>(PlyHeader::LoadScalar(record + normal.Offset, normal.Type));
+                    }
+                }
+            }
+        });
+
+    // Faces are located after the vertices, the elements in between must have a fixed size.
+    const size_t faceOffset = iHeader.GetElementOffset(iLayout.FaceElement);
+    const PlyHeader::Property &indices = face.Properties[iLayout.Indices];
+    const uint32_t countSize = PlyHeader::GetTypeSize(indices.CountType);
+    const uint32_t indexSize = PlyHeader::GetTypeSize(indices.Type);
+
+    // With triangles only and no other list, the face records have a fixed size and are read in parallel.
+    bool fixedLayout = true;
+    uint32_t prefixSize = 0;
+    uint32_t suffixSize = 0;
+    for (size_t p = 0; p < face.Properties.size(); ++p)
+    {
+        if (static_cast<int>(p) == iLayout.Indices)
+            continue;
+        fixedLayout &= !face.Properties[p].IsList;
+        (static_cast<int>(p) < iLayout.Indices ? prefixSize : suffixSize) += PlyHeader::GetTypeSize(face.Properties[p].Type);
+    }
+    const size_t triangleStride = prefixSize + countSize + 3 * indexSize + suffixSize;
+    fixedLayout &= faceOffset + face.Count * triangleStride <= iContent.size();
+
+    if (fixedLayout && face.Count > 0)
+    {
+        oMesh.Indices.resize(face.Count * 3);
+        std::atomic<bool> onlyTriangles{true};
+        std::atomic<bool> outOfRange{false};
+        const uint64_t faceCount = face.Count;
+        const uint32_t faceWorkerCount = static_cast<uint32_t>(std::min<uint64_t>(GetWorkerCount(), faceCount));
+        const bool packedIndices = indices.Type == ScalarType::Int32 || indices.Type == ScalarType::UInt32;
+        ParallelFor(
+            faceWorkerCount,
+            [&](uint32_t iWorker)
+            {
+                const uint64_t first = faceCount * iWorker / faceWorkerCount;
+                const uint64_t last = faceCount * (iWorker + 1) / faceWorkerCount;
+                for (uint64_t f = first; f < last && onlyTriangles.load(std::memory_order_relaxed); ++f)
+                {
+                    const uint8_t *record = data + faceOffset + f * triangleStride + prefixSize;
+                    if (PlyHeader::LoadScalar(record, indices.CountType) != 3.0)
+                    {
+                        onlyTriangles = false;
+                        break;
+                    }
+                    record += countSize;
+                    for (uint32_t k = 0; k < 3; ++k)
+                    {
+                        int64_t index;
+                        if (packedIndices)
+                        {
+                            uint32_t packed;
+                            std::memcpy(&packed, record + k * 4, 4);
+                            index = indices.Type == ScalarType::Int32 ? static_cast<int32_t>(packed) : static_cast<int64_t>(packed);
+                        }
+                        else
+                        {
+                            index = static_cast<int64_t>(PlyHeader::LoadScalar(record + k * indexSize, indices.Type));
+                        }
+                        // Not an error yet: the record may be misaligned by a polygon found by another thread.
+                        if (index < 0 || index >= vertexCount)
+                            outOfRange = true;
+                        oMesh.Indices[f * 3 + k] = static_cast<uint32_t>(index);
+                    }
+                }
+            });
+        if (onlyTriangles && outOfRange)
+            throw std::runtime_error(iError + "face index out of range");
+        if (onlyTriangles)
+            return;
+    }
+
+    // Polygons or several lists: walk the records one by one.
+    oMesh.Indices.clear();
+    const uint8_t *cursor = data + faceOffset;
+    const uint8_t *end = data + iContent.size();
+    std::vector<int64_t> polygon;
+    for (uint64_t f = 0; f < face.Count; ++f)
+    {
+        for (size_t p = 0; p < face.Properties.size(); ++p)
+        {
+            const PlyHeader::Property &property = face.Properties[p];
+            uint64_t count = 1;
+            if (property.IsList)
+            {
+                if (cursor + PlyHeader::GetTypeSize(property.CountType) > end)
+                    throw std::runtime_error(iError + "file is truncated");
+                count = static_cast<uint64_t>(PlyHeader::LoadScalar(cursor, property.CountType));
+                cursor += PlyHeader::GetTypeSize(property.CountType);
+            }
+
+            const uint32_t size = PlyHeader::GetTypeSize(property.Type);
+            if (static_cast<uint64_t>(end - cursor) < count * size)
+                throw std::runtime_error(iError + "file is truncated");
+            if (static_cast<int>(p) == iLayout.Indices)
+            {
+                polygon.resize(count);
+                for (uint64_t i = 0; i < count; ++i)
+                    polygon[i] = static_cast<int64_t>(PlyHeader::LoadScalar(cursor + i * size, property.Type));
+            }
+            cursor += count * size;
+        }
+        FanTriangulate(polygon, vertexCount, oMesh.Indices, iError);
+    }
+}
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+Mesh ReadObjMesh(const std::filesystem::path &iFilePath)
+{
+    const MappedFile file(iFilePath);
+    const std::string_view content(reinterpret_cast<const char *>(file.GetData()), file.GetSize());
+    const std::string error = "invalid OBJ file " + iFilePath.string() + ": ";
+
+    const std::vector<std::string_view> texts = SplitLines(content, GetWorkerCount());
+    const uint32_t rangeCount = static_cast<uint32_t>(texts.size());
+    std::vector<ObjRange> ranges(rangeCount);
+    ParallelFor(rangeCount, [&](uint32_t i) { ParseObjRange(texts[i], ranges[i], error); });
+
+    size_t positionCount = 0;
+    size_t normalCount = 0;
+    size_t indexCount = 0;
+    for (ObjRange &range : ranges)
+    {
+        range.FirstPosition = positionCount;
+        range.FirstNormal = normalCount;
+        range.FirstIndex = indexCount;
+        positionCount += range.Positions.size();
+        normalCount += range.Normals.size();
+        indexCount += range.Indices.size();
+    }
+    if (positionCount > std::numeric_limits<uint32_t>::max() || normalCount >= std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error(error + "too many vertices");
+
+    // Gather the positions and normals, and resolve the references now that the offset of each range is known.
+    std::vector<glm::vec3> positions(positionCount);
+    std::vector<glm::vec3> normals(normalCount);
+    ParallelFor(
+        rangeCount,
+        [&](uint32_t i)
+        {
+            ObjRange &range = ranges[i];
+            std::copy(range.Positions.begin(), range.Positions.end(), positions.begin() + range.FirstPosition);
+            std::copy(range.Normals.begin(), range.Normals.end(), normals.begin() + range.FirstNormal);
+            range.Positions = {};
+            range.Normals = {};
+
+            range.Keys.resize(range.Refs.size());
+            range.Remap.resize(range.Refs.size());
+            for (size_t k = 0; k < range.Refs.size(); ++k)
+            {
+                const VertexRef &ref = range.Refs[k];
+                const uint64_t position = DecodeObjIndex(ref.Position, range.FirstPosition, positionCount, error);
+                const uint64_t normal = ref.Normal < 0 ? 0 : DecodeObjIndex(ref.Normal, range.FirstNormal, normalCount, error) + 1;
+                range.Keys[k] = position << 32 | normal;
+            }
+            range.Refs = {};
+        });
+
+    // Merge the vertices shared by several ranges: each thread owns the keys of one hash shard.
+    const uint32_t shardCount = GetWorkerCount();
+    auto shardOf = [shardCount](uint64_t iKey) { return static_cast<uint32_t>(Mix(iKey) % shardCount); };
+    std::vector<std::vector<uint64_t>> shardKeys(shardCount);
+    ParallelFor(
+        shardCount,
+        [&](uint32_t iShard)
+        {
+            std::unordered_map<uint64_t, uint32_t> ids;
+            for (ObjRange &range : ranges)
+            {
+                for (size_t k = 0; k < range.Keys.size(); ++k)
+                {
+                    if (shardOf(range.Keys[k]) != iShard)
+                        continue;
+                    const auto [it, inserted] = ids.try_emplace(range.Keys[k], static_cast<uint32_t>(shardKeys[iShard].size()));
+                    if (inserted)
+                        shardKeys[iShard].push_back(range.Keys[k]);
+                    range.Remap[k] = it->second;
+                }
+            }
+        });
+
+    std::vector<size_t> shardFirstVertices(shardCount + 1, 0);
+    for (uint32_t s = 0; s < shardCount; ++s)
+        shardFirstVertices[s + 1] = shardFirstVertices[s] + shardKeys[s].size();
+    if (shardFirstVertices.back() > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error(error + "too many vertices");
+
+    Mesh mesh;
+    mesh.Vertices.resize(shardFirstVertices.back());
+    mesh.Indices.resize(indexCount);
+    ParallelFor(
+        shardCount,
+        [&](uint32_t iShard)
+        {
+            MeshVertex *vertices = mesh.Vertices.data() + shardFirstVertices[iShard];
+            for (uint64_t key : shardKeys[iShard])
+            {
+                const uint32_t normal = static_cast<uint32_t>(key);
+                vertices->Pos = positions[key >> 32];
+                vertices->Normal = normal == 0 ? glm::vec3(0.0f) : normals[normal - 1];
+                ++vertices;
+            }
+        });
+    ParallelFor(
+        rangeCount,
+        [&](uint32_t i)
+        {
+            ObjRange &range = ranges[i];
+            for (size_t k = 0; k < range.Keys.size(); ++k)
+                range.Remap[k] += static_cast<uint32_t>(shardFirstVertices[shardOf(range.Keys[k])]);
+            for (size_t j = 0; j < range.Indices.size(); ++j)
+                mesh.Indices[range.FirstIndex + j] = range.Remap[range.Indices[j]];
+        });
+
+    ComputeMissingNormals(mesh);
+    return mesh;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+Mesh ReadPlyMesh(const std::filesystem::path &iFilePath)
+{
+    const MappedFile file(iFilePath);
+    const std::string_view content(reinterpret_cast<const char *>(file.GetData()), file.GetSize());
+    const std::string error = "invalid PLY file " + iFilePath.string() + ": ";
+
+    const PlyHeader header = PlyHeader::Parse(content, iFilePath);
+    if (header.Encoding == PlyHeader::Format::BinaryBigEndian)
+        throw std::runtime_error(error + "binary_big_endian is not supported");
+
+    PlyMeshLayout layout;
+    layout.VertexElement = header.FindElement("vertex");
+    layout.FaceElement = header.FindElement("face");
+    if (layout.VertexElement < 0 || layout.FaceElement < 0)
+        throw std::runtime_error(error + "missing vertex or face element");
+
+    const PlyHeader::Element &vertex = header.Elements[layout.VertexElement];
+    if (vertex.Count > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error(error + "too many vertices");
+    layout.Position[0] = vertex.Find({"x"});
+    layout.Position[1] = vertex.Find({"y"});
+    layout.Position[2] = vertex.Find({"z"});
+    if (layout.Position[0] < 0 || layout.Position[1] < 0 || layout.Position[2] < 0)
+        throw std::runtime_error(error + "missing x, y or z property");
+    layout.Normal[0] = vertex.Find({"nx"});
+    layout.Normal[1] = vertex.Find({"ny"});
+    layout.Normal[2] = vertex.Find({"nz"});
+    if (layout.Normal[0] < 0 || layout.Normal[1] < 0 || layout.Normal[2] < 0)
+        layout.Normal[0] = layout.Normal[1] = layout.Normal[2] = -1;
+
+    const PlyHeader::Element &face = header.Elements[layout.FaceElement];
+    layout.Indices = face.Find({"vertex_indices", "vertex_index"});
+    if (layout.Indices < 0 || !face.Properties[layout.Indices].IsList)
+        throw std::runtime_error(error + "missing vertex_indices list");
+
+    Mesh mesh;
+    mesh.Vertices.resize(vertex.Count);
+    if (header.Encoding == PlyHeader::Format::Ascii)
+        ReadAsciiPly(content, header, layout, mesh, error);
+    else
+        ReadBinaryPly(content, header, layout, mesh, error);
+
+    ComputeMissingNormals(mesh);
+    return mesh;
+}
@@ -0,0 +1,85 @@
+#include "IO/MultiCloudReader.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+//----------------------------------------------------------------------------------------------------------------------
+MultiCloudReader::MultiCloudReader(std::vector<std::unique_ptr<CloudReader>> iReaders, const std::vector<glm::mat4> &iTransforms)
+    : m_Readers(std::move(iReaders))
+{
+    if (m_Readers.empty() || m_Readers.size() > MAX_SOURCE_COUNT)
+        throw std::runtime_error("a scene needs 1 to " + std::to_string(MAX_SOURCE_COUNT) + " clouds");
+    if (iTransforms.size() != m_Readers.size())
+        throw std::runtime_error("a scene needs one transform per cloud");
+
+    // Positions are relative to their own origin: the first one becomes the scene origin.
+    const glm::dvec3 origin = GetOrigin();
+    uint64_t pointCount = 0;
+    for (uint32_t source = 0; source < m_Readers.size(); ++source)
+    {
+        const glm::vec3 offset(m_Readers[source]->GetOrigin() - origin);
+        m_Transforms.push_back(iTransforms[source] * glm::translate(glm::mat4(1.0f), offset));
+        pointCount += m_Readers[source]->GetPointCount();
+    }
+    if (pointCount > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("too many points in the scene: " + std::to_string(pointCount));
+    m_PointCount = static_cast<uint32_t>(pointCount);
+
+    // Blocks are sorted by the relative position of their center in their source, so a prefix of the merged cloud
+    // takes the same fraction of each source.
+    std::vector<std::pair<double, Block>> blocks;
+    blocks.reserve(m_PointCount / BLOCK_SIZE + m_Readers.size());
+    for (uint32_t source = 0; source < m_Readers.size(); ++source)
+    {
+        const uint32_t sourceCount = m_Readers[source]->GetPointCount();
+        for (uint32_t first = 0; first < sourceCount; first += std::min(BLOCK_SIZE, sourceCount - first))
+        {
+            Block block;
+            block.SourceFirst = first;
+            block.Count = std::min(BLOCK_SIZE, sourceCount - first);
+            block.Source = source;
+            blocks.emplace_back((first + 0.5 * block.Count) / sourceCount, block);
+        }
+    }
+    std::stable_sort(
+        blocks.begin(),
+        blocks.end(),
+        [](const std::pair<double, Block> &iLeft, const std::pair<double, Block> &iRight) { return iLeft.first < iRight.first; });
+
+    m_Blocks.reserve(blocks.size());
+    uint32_t first = 0;
+    for (const std::pair<double, Block> &block : blocks)
+    {
+        m_Blocks.push_back(block.second);
+        m_Blocks.back().First = first;
+        first += block.second.Count;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool MultiCloudReader::IsShuffled() const
+{
+    return std::all_of(m_Readers.begin(), m_Readers.end(), [](const std::unique_ptr<CloudReader> &iReader) { return iReader->IsShuffled(); });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void MultiCloudReader::ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const
+{
+    auto block = std::upper_bound(m_Blocks.begin(), m_Blocks.end(), iFirst, [](uint32_t iIndex, const Block &iBlock) { return iIndex < iBlock.First; });
+    --block;
+    while (iCount > 0)
+    {
+        const uint32_t offset = iFirst - block->First;
+        const uint32_t count = std::min(iCount, block->Count - offset);
+        m_Readers[block->Source]->ReadPoints(block->SourceFirst + offset, count, oPoints);
+        for (uint32_t i = 0; i < count; ++i)
+            oPoints[i].Attribute = static_cast<uint8_t>(block->Source);
+
+        oPoints += count;
+        iFirst += count;
+        iCount -= count;
+        ++block;
+    }
+}
@@ -0,0 +1,269 @@
+#include "IO/OpcCodec.h"
+#include <glm/common.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+/// Number of byte streams of a chunk, one per byte of OptiCloudVertex.
+constexpr uint32_t STREAM_COUNT = sizeof(OptiCloudVertex);
+/// Largest quantized coordinate, 24 bits per axis.
+constexpr uint32_t MAX_QUANTIZED = (1u << 24) - 1;
+/// Precision of the symbol frequencies.
+constexpr uint32_t SCALE_BITS = 12;
+constexpr uint32_t SCALE = 1u << SCALE_BITS;
+/// Lower bound of the normalized rANS state.
+constexpr uint32_t RANS_LOW = 1u << 23;
+/// Size of the frequency table at the beginning of a stream.
+constexpr size_t FREQUENCY_TABLE_SIZE = 256 * sizeof(uint16_t);
+/// Size of the delta flags and the stream sizes at the beginning of a chunk.
+constexpr size_t CHUNK_HEADER_SIZE = sizeof(uint32_t) * (1 + STREAM_COUNT);
+
+//----------------------------------------------------------------------------------------------------------------------
+glm::vec3 GetStep(const OpcChunk &iChunk, float iQuantization)
+{
+    return glm::max(glm::vec3(iQuantization), (iChunk.BoundsMax - iChunk.BoundsMin) / static_cast<float>(MAX_QUANTIZED));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t ZigZag(int32_t iValue)
+{
+    return (static_cast<uint32_t>(iValue) << 1) ^ static_cast<uint32_t>(iValue >> 31);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+int32_t UnZigZag(uint32_t iValue)
+{
+    return static_cast<int32_t>(iValue >> 1) ^ -static_cast<int32_t>(iValue & 1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Write32(std::vector<uint8_t> &ioData, size_t iOffset, uint32_t iValue)
+{
+    for (uint32_t i = 0; i < 4; ++i)
+        ioData[iOffset + i] = static_cast<uint8_t>(iValue >> (8 * i));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t Read32(const uint8_t *iData)
+{
+    return iData[0] | iData[1] << 8 | iData[2] << 16 | static_cast<uint32_t>(iData[3]) << 24;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+///  Scales the symbol counts to frequencies summing to SCALE, every present symbol keeping at least 1.
+std::array<uint32_t, 256> NormalizeFrequencies(const std::array<uint32_t, 256> &iCounts, uint32_t iTotal)
+{
+    std::array<uint32_t, 256> frequencies{};
+    uint32_t sum = 0;
+    uint32_t largest = 0;
+    for (uint32_t s = 0; s < 256; ++s)
+    {
+        if (iCounts[s] == 0)
+            continue;
+        frequencies[s] = std::max(1u, static_cast<uint32_t>(static_cast<uint64_t>(iCounts[s]) * SCALE / iTotal));
+        sum += frequencies[s];
+        if (iCounts[s] > iCounts[largest] || iCounts[largest] == 0)
+            largest = s;
+    }
+
+    // The rounding error goes to the most frequent symbols, where it costs the least.
+    while (sum > SCALE)
+    {
+        const auto highest = std::max_element(frequencies.begin(), frequencies.end());
+        --*highest;
+        --sum;
+    }
+    frequencies[largest] += SCALE - sum;
+    return frequencies;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+///  Entropy codes byte iByte of each 16-byte record.
+std::vector<uint8_t> EncodeStream(const std::vector<uint32_t> &iRecords, uint32_t iByte)
+{
+    const uint32_t count = static_cast<uint32_t>(iRecords.size() / 4);
+    const uint32_t word = iByte / 4;
+    const uint32_t shift = 8 * (iByte % 4);
+    auto symbol = [&](uint32_t iIndex) { return static_cast<uint8_t>(iRecords[4 * iIndex + word] >> shift); };
+
+    std::array<uint32_t, 256> counts{};
+    for (uint32_t i = 0; i < count; ++i)
+        ++counts[symbol(i)];
+    const std::array<uint32_t, 256> frequencies = NormalizeFrequencies(counts, count);
+    std::array<uint32_t, 256> cumulated{};
+    for (uint32_t s = 1; s < 256; ++s)
+        cumulated[s] = cumulated[s - 1] + frequencies[s - 1];
+
+    // rANS is written backwards: a symbol costs at most SCALE_BITS bits, plus the final state.
+    std::vector<uint8_t> data(FREQUENCY_TABLE_SIZE + 2 * static_cast<size_t>(count) + 8);
+    size_t cursor = data.size();
+    uint32_t state = RANS_LOW;
+    for (uint32_t i = count; i-- > 0;)
+    {
+        const uint8_t s = symbol(i);
+        const uint32_t frequency = frequencies[s];
+        const uint32_t stateMax = ((RANS_LOW >> SCALE_BITS) << 8) * frequency;
+        while (state >= stateMax)
+        {
+            data[--cursor] = static_cast<uint8_t>(state);
+            state >>= 8;
+        }
+        state = ((state / frequency) << SCALE_BITS) + (state % frequency) + cumulated[s];
+    }
+    cursor -= 4;
+    Write32(data, cursor, state);
+
+    for (uint32_t s = 0; s < 256; ++s)
+    {
+        data[2 * s] = static_cast<uint8_t>(frequencies[s]);
+        data[2 * s + 1] = static_cast<uint8_t>(frequencies[s] >> 8);
+    }
+    data.erase(data.begin() + FREQUENCY_TABLE_SIZE, data.begin() + static_cast<std::ptrdiff_t>(cursor));
+    return data;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+///  Decodes a stream into byte iByte of each 16-byte record, which must be zero.
+void DecodeStream(const uint8_t *iData, size_t iSize, uint32_t iByte, std::vector<uint32_t> &ioRecords)
+{
+    if (iSize < FREQUENCY_TABLE_SIZE + 4)
+        throw std::runtime_error("corrupted OPC chunk: truncated stream");
+
+    std::array<uint32_t, 256> frequencies{};
+    std::array<uint32_t, 256> cumulated{};
+    std::array<uint8_t, SCALE> symbols{};
+    uint32_t sum = 0;
+    for (uint32_t s = 0; s < 256; ++s)
+    {
+        frequencies[s] = iData[2 * s] | iData[2 * s + 1] << 8;
+        cumulated[s] = sum;
+        if (sum + frequencies[s] > SCALE)
+            throw std::runtime_error("corrupted OPC chunk: invalid frequencies");
+        std::fill_n(symbols.begin() + sum, frequencies[s], static_cast<uint8_t>(s));
+        sum += frequencies[s];
+    }
+    if (sum != SCALE)
+        throw std::runtime_error("corrupted OPC chunk: invalid frequencies");
+
+    const uint8_t *cursor = iData + FREQUENCY_TABLE_SIZE;
+    const uint8_t *end = iData + iSize;
+    uint32_t state = Read32(cursor);
+    cursor += 4;
+
+    const uint32_t count = static_cast<uint32_t>(ioRecords.size() / 4);
+    const uint32_t word = iByte / 4;
+    const uint32_t shift = 8 * (iByte % 4);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t slot = state & (SCALE - 1);
+        const uint8_t s = symbols[slot];
+        ioRecords[4 * i + word] |= static_cast<uint32_t>(s) << shift;
+        state = frequencies[s] * (state >> SCALE_BITS) + slot - cumulated[s];
+        while (state < RANS_LOW)
+        {
+            if (cursor == end)
+                throw std::runtime_error("corrupted OPC chunk: truncated stream");
+            state = state << 8 | *cursor++;
+        }
+    }
+}
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<uint8_t> EncodeOpcChunk(const OptiCloudVertex *iPoints, const OpcChunk &iChunk, float iQuantization)
+{
+    const uint32_t count = iChunk.PointCount;
+    const glm::vec3 step = GetStep(iChunk, iQuantization);
+
+    // Quantized records, in the OptiCloudVertex layout, with the positions as is and delta encoded.
+    std::vector<uint32_t> records(4 * static_cast<size_t>(count));
+    std::vector<uint32_t> deltas(4 * static_cast<size_t>(count));
+    glm::uvec3 previous(0);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        for (uint32_t a = 0; a < 3; ++a)
+        {
+            const float position = step[a] > 0.0f ? std::round((iPoints[i].Pos[a] - iChunk.BoundsMin[a]) / step[a]) : 0.0f;
+            const uint32_t quantized = static_cast<uint32_t>(std::clamp(position, 0.0f, static_cast<float>(MAX_QUANTIZED)));
+            records[4 * i + a] = quantized;
+            deltas[4 * i + a] = ZigZag(static_cast<int32_t>(quantized - previous[a]));
+            previous[a] = quantized;
+        }
+        std::memcpy(&records[4 * i + 3], reinterpret_cast<const uint8_t *>(&iPoints[i]) + offsetof(OptiCloudVertex, Color), 4);
+    }
+
+    std::array<std::vector<uint8_t>, STREAM_COUNT> streams;
+    uint32_t deltaFlags = 0;
+    for (uint32_t a = 0; a < 3; ++a)
+    {
+        // Delta encoding only pays off if consecutive points are close, keep the smaller encoding of the axis.
+        size_t plainSize = 0;
+        size_t deltaSize = 0;
+        std::array<std::vector<uint8_t>, 4> deltaStreams;
+        for (uint32_t b = 0; b < 4; ++b)
+        {
+            streams[4 * a + b] = EncodeStream(records, 4 * a + b);
+            deltaStreams[b] = EncodeStream(deltas, 4 * a + b);
+            plainSize += streams[4 * a + b].size();
+            deltaSize += deltaStreams[b].size();
+        }
+        if (deltaSize < plainSize)
+        {
+            deltaFlags |= 1u << a;
+            std::move(deltaStreams.begin(), deltaStreams.end(), streams.begin() + 4 * a);
+        }
+    }
+    for (uint32_t b = 12; b < STREAM_COUNT; ++b)
+        streams[b] = EncodeStream(records, b);
+
+    std::vector<uint8_t> data(CHUNK_HEADER_SIZE);
+    Write32(data, 0, deltaFlags);
+    for (uint32_t b = 0; b < STREAM_COUNT; ++b)
+    {
+        Write32(data, sizeof(uint32_t) * (1 + b), static_cast<uint32_t>(streams[b].size()));
+        data.insert(data.end(), streams[b].begin(), streams[b].end());
+    }
+    return data;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void DecodeOpcChunk(const uint8_t *iData, size_t iSize, const OpcChunk &iChunk, float iQuantization, OptiCloudVertex *oPoints)
+{
+    if (iSize < CHUNK_HEADER_SIZE)
+        throw std::runtime_error("corrupted OPC chunk: truncated header");
+
+    const uint32_t count = iChunk.PointCount;
+    std::vector<uint32_t> records(4 * static_cast<size_t>(count), 0);
+    size_t offset = CHUNK_HEADER_SIZE;
+    for (uint32_t b = 0; b < STREAM_COUNT; ++b)
+    {
+        const size_t size = Read32(iData + sizeof(uint32_t) * (1 + b));
+        if (size > iSize - offset)
+            throw std::runtime_error("corrupted OPC chunk: truncated stream");
+        DecodeStream(iData + offset, size, b, records);
+        offset += size;
+    }
+
+    const uint32_t deltaFlags = Read32(iData);
+    const glm::vec3 step = GetStep(iChunk, iQuantization);
+    glm::uvec3 previous(0);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        for (uint32_t a = 0; a < 3; ++a)
+        {
+            uint32_t quantized = records[4 * i + a];
+            if (deltaFlags & (1u << a))
+            {
+                quantized = previous[a] + static_cast<uint32_t>(UnZigZag(quantized));
+                previous[a] = quantized;
+            }
+            oPoints[i].Pos[a] = iChunk.BoundsMin[a] + static_cast<float>(quantized) * step[a];
+        }
+        std::memcpy(reinterpret_cast<uint8_t *>(&oPoints[i]) + offsetof(OptiCloudVertex, Color), &records[4 * i + 3], 4);
+    }
+}
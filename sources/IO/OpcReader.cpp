@@ -0,0 +1,98 @@
+#include "IO/OpcReader.h"
+#include "IO/OpcCodec.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+OpcReader::OpcReader(const std::filesystem::path &iFilePath)
+    : m_File(iFilePath)
+{
+    const std::string error = "invalid OPC file " + iFilePath.string() + ": ";
+    if (m_File.GetSize() < sizeof(OpcHeader))
+        throw std::runtime_error(error + "file is truncated");
+
+    std::memcpy(&m_Header, m_File.GetData(), sizeof(OpcHeader));
+    if (std::memcmp(m_Header.Magic, Opc::MAGIC, sizeof(Opc::MAGIC)) != 0)
+        throw std::runtime_error(error + "missing magic number");
+    if (m_Header.Version != Opc::VERSION)
+        throw std::runtime_error(error + "unsupported version " + std::to_string(m_Header.Version));
+    if (m_Header.ChunkSize == 0 || m_Header.ChunkCount != (m_Header.PointCount + m_Header.ChunkSize - 1) / m_Header.ChunkSize)
+        throw std::runtime_error(error + "inconsistent chunk table");
+
+    if (m_Header.Encoding != Opc::ENCODING_RAW && m_Header.Encoding != Opc::ENCODING_COMPRESSED)
+        throw std::runtime_error(error + "unsupported encoding " + std::to_string(m_Header.Encoding));
+
+    const uint64_t tableEnd = m_Header.ChunkTableOffset + static_cast<uint64_t>(m_Header.ChunkCount) * sizeof(OpcChunk);
+    if (tableEnd > m_File.GetSize() || m_Header.ChunkTableOffset % alignof(OpcChunk) != 0)
+        throw std::runtime_error(error + "file is truncated");
+
+    if (m_Header.Encoding == Opc::ENCODING_RAW)
+    {
+        const uint64_t payloadEnd = m_Header.PayloadOffset + static_cast<uint64_t>(m_Header.PointCount) * sizeof(OptiCloudVertex);
+        if (payloadEnd > m_File.GetSize())
+            throw std::runtime_error(error + "file is truncated");
+        return;
+    }
+
+    // Compressed chunks are located by the table only.
+    for (uint32_t c = 0; c < m_Header.ChunkCount; ++c)
+    {
+        const OpcChunk &chunk = GetChunks()[c];
+        if (chunk.PointCount != std::min(m_Header.ChunkSize, m_Header.PointCount - c * m_Header.ChunkSize))
+            throw std::runtime_error(error + "inconsistent chunk table");
+        if (chunk.Offset + chunk.ByteSize > m_File.GetSize())
+            throw std::runtime_error(error + "file is truncated");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void OpcReader::ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const
+{
+    if (m_Header.Encoding == Opc::ENCODING_COMPRESSED)
+    {
+        ReadCompressedPoints(iFirst, iCount, oPoints);
+        return;
+    }
+
+    const uint8_t *points = m_File.GetData() + m_Header.PayloadOffset + static_cast<size_t>(iFirst) * sizeof(OptiCloudVertex);
+    std::memcpy(oPoints, points, static_cast<size_t>(iCount) * sizeof(OptiCloudVertex));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void OpcReader::ReadCompressedPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const
+{
+    if (iCount == 0)
+        return;
+
+    // The streamer reads one chunk per call from its own threads, larger reads decode their chunks in parallel.
+    const uint32_t firstChunk = iFirst / m_Header.ChunkSize;
+    const uint32_t chunkCount = (iFirst + iCount - 1) / m_Header.ChunkSize - firstChunk + 1;
+    const uint32_t workerCount = std::min(GetWorkerCount(), chunkCount);
+    ParallelFor(
+        workerCount,
+        [&](uint32_t iWorker)
+        {
+            std::vector<OptiCloudVertex> points;
+            for (uint32_t c = firstChunk + iWorker; c < firstChunk + chunkCount; c += workerCount)
+            {
+                const OpcChunk &chunk = GetChunks()[c];
+                const uint32_t chunkFirst = c * m_Header.ChunkSize;
+                const uint32_t first = std::max(iFirst, chunkFirst);
+                const uint32_t end = std::min(iFirst + iCount, chunkFirst + chunk.PointCount);
+                const uint8_t *data = m_File.GetData() + chunk.Offset;
+
+                // Whole chunks are decoded in place, partial ones through a temporary block.
+                if (first == chunkFirst && end == chunkFirst + chunk.PointCount)
+                {
+                    DecodeOpcChunk(data, chunk.ByteSize, chunk, m_Header.Quantization, oPoints + (first - iFirst));
+                    continue;
+                }
+                points.resize(chunk.PointCount);
+                DecodeOpcChunk(data, chunk.ByteSize, chunk, m_Header.Quantization, points.data());
+                std::copy(points.begin() + (first - chunkFirst), points.begin() + (end - chunkFirst), oPoints + (first - iFirst));
+            }
+        });
+}
@@ -0,0 +1,145 @@
+#include "IO/OpcWriter.h"
+#include "IO/MappedFile.h"
+#include "IO/OpcCodec.h"
+#include "IO/OpcFormat.h"
+#include "Parallel.h"
+#include "Permutation.h"
+#include <glm/common.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+void WriteOpcCloud(
+    const CloudReader &iReader, const std::filesystem::path &iFilePath, float iQuantization, bool iCompress, ProgressiveOrder iOrder)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    const uint32_t pointCount = iReader.GetPointCount();
+    if (pointCount == 0)
+        throw std::runtime_error("cannot write a cloud without points");
+    const uint32_t chunkCount = (pointCount + Opc::CHUNK_SIZE - 1) / Opc::CHUNK_SIZE;
+
+    const uint64_t tableOffset = sizeof(OpcHeader);
+    const uint64_t tableEnd = tableOffset + static_cast<uint64_t>(chunkCount) * sizeof(OpcChunk);
+    const uint64_t payloadOffset = (tableEnd + Opc::PAYLOAD_ALIGNMENT - 1) / Opc::PAYLOAD_ALIGNMENT * Opc::PAYLOAD_ALIGNMENT;
+
+    // The raw payload is shuffled straight into the output file, a compressed one in memory first since the size of
+    // its chunks is only known once they are encoded.
+    std::optional<MappedFile> file;
+    std::vector<OptiCloudVertex> shuffled;
+    OptiCloudVertex *payload = nullptr;
+    if (iCompress)
+    {
+        shuffled.resize(pointCount);
+        payload = shuffled.data();
+    }
+    else
+    {
+        file.emplace(iFilePath, payloadOffset + static_cast<uint64_t>(pointCount) * sizeof(OptiCloudVertex));
+        payload = reinterpret_cast<OptiCloudVertex *>(file->GetMutableData() + payloadOffset);
+    }
+
+    // Decode the source chunk by chunk and scatter each point to its place in the progressive order.
+    const Permutation permutation(pointCount);
+    const std::vector<uint32_t> order = iOrder == ProgressiveOrder::Stratified ? ComputeStratifiedOrder(iReader) : std::vector<uint32_t>();
+    std::atomic<uint32_t> nextChunk{0};
+    ParallelFor(
+        GetWorkerCount(),
+        [&](uint32_t)
+        {
+            std::vector<OptiCloudVertex> points(std::min(Opc::CHUNK_SIZE, pointCount));
+            for (uint32_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+            {
+                const uint32_t first = chunk * Opc::CHUNK_SIZE;
+                const uint32_t count = std::min(Opc::CHUNK_SIZE, pointCount - first);
+                iReader.ReadPoints(first, count, points.data());
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    if (iQuantization > 0.0f)
+                        points[i].Pos = glm::round(points[i].Pos / iQuantization) * iQuantization;
+                    payload[order.empty() ? permutation(first + i) : order[first + i]] = points[i];
+                }
+            }
+        });
+
+    // The chunks of the shuffled payload are read back to fill the table, and compressed.
+    std::vector<OpcChunk> chunks(chunkCount);
+    std::vector<std::vector<uint8_t>> encodedChunks(iCompress ? chunkCount : 0);
+    const uint32_t workerCount = std::min(GetWorkerCount(), chunkCount);
+    ParallelFor(
+        workerCount,
+        [&](uint32_t iWorker)
+        {
+            for (uint32_t c = iWorker; c < chunkCount; c += workerCount)
+            {
+                OpcChunk &chunk = chunks[c];
+                const uint32_t first = c * Opc::CHUNK_SIZE;
+                chunk.Offset = payloadOffset + static_cast<uint64_t>(first) * sizeof(OptiCloudVertex);
+                chunk.PointCount = std::min(Opc::CHUNK_SIZE, pointCount - first);
+                chunk.ByteSize = chunk.PointCount * sizeof(OptiCloudVertex);
+                chunk.BoundsMin = glm::vec3(std::numeric_limits<float>::max());
+                chunk.BoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+                for (uint32_t i = first; i < first + chunk.PointCount; ++i)
+                {
+                    chunk.BoundsMin = glm::min(chunk.BoundsMin, payload[i].Pos);
+                    chunk.BoundsMax = glm::max(chunk.BoundsMax, payload[i].Pos);
+                }
+                if (iCompress)
+                {
+                    encodedChunks[c] = EncodeOpcChunk(payload + first, chunk, std::max(iQuantization, 0.0f));
+                    chunk.ByteSize = static_cast<uint32_t>(encodedChunks[c].size());
+                }
+            }
+        });
+
+    uint64_t payloadSize = static_cast<uint64_t>(pointCount) * sizeof(OptiCloudVertex);
+    if (iCompress)
+    {
+        payloadSize = 0;
+        for (uint32_t c = 0; c < chunkCount; ++c)
+        {
+            chunks[c].Offset = payloadOffset + payloadSize;
+            payloadSize += chunks[c].ByteSize;
+        }
+        file.emplace(iFilePath, payloadOffset + payloadSize);
+        ParallelFor(
+            workerCount,
+            [&](uint32_t iWorker)
+            {
+                for (uint32_t c = iWorker; c < chunkCount; c += workerCount)
+                    std::memcpy(file->GetMutableData() + chunks[c].Offset, encodedChunks[c].data(), encodedChunks[c].size());
+            });
+    }
+
+    OpcHeader header{};
+    std::memcpy(header.Magic, Opc::MAGIC, sizeof(Opc::MAGIC));
+    header.Version = Opc::VERSION;
+    header.PointCount = pointCount;
+    header.ChunkSize = Opc::CHUNK_SIZE;
+    header.ChunkCount = chunkCount;
+    header.Origin = iReader.GetOrigin();
+    header.BoundsMin = glm::vec3(std::numeric_limits<float>::max());
+    header.BoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const OpcChunk &chunk : chunks)
+    {
+        header.BoundsMin = glm::min(header.BoundsMin, chunk.BoundsMin);
+        header.BoundsMax = glm::max(header.BoundsMax, chunk.BoundsMax);
+    }
+    header.Quantization = std::max(iQuantization, 0.0f);
+    header.Encoding = iCompress ? Opc::ENCODING_COMPRESSED : Opc::ENCODING_RAW;
+    header.ChunkTableOffset = tableOffset;
+    header.PayloadOffset = payloadOffset;
+
+    std::memcpy(file->GetMutableData(), &header, sizeof(header));
+    std::memcpy(file->GetMutableData() + tableOffset, chunks.data(), chunks.size() * sizeof(OpcChunk));
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Wrote " << pointCount << " points to " << iFilePath << " in " << elapsed.count() << " s ("
+              << static_cast<double>(payloadSize) / pointCount << " bytes per point)" << std::endl;
+}
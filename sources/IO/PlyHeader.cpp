@@ -0,0 +1,207 @@
+#include "IO/PlyHeader.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T>
+double Load(const uint8_t *iData)
+{
+    T value;
+    std::memcpy(&value, iData, sizeof(T));
+    return static_cast<double>(value);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool ParseType(const std::string &iName, PlyHeader::ScalarType &oType)
+{
+    using ScalarType = PlyHeader::ScalarType;
+    if (iName == "char" || iName == "int8")
+        oType = ScalarType::Int8;
+    else if (iName == "uchar" || iName == "uint8")
+        oType = ScalarType::UInt8;
+    else if (iName == "short" || iName == "int16")
+        oType = ScalarType::Int16;
+    else if (iName == "ushort" || iName == "uint16")
+        oType = ScalarType::UInt16;
+    else if (iName == "int" || iName == "int32")
+        oType = ScalarType::Int32;
+    else if (iName == "uint" || iName == "uint32")
+        oType = ScalarType::UInt32;
+    else if (iName == "float" || iName == "float32")
+        oType = ScalarType::Float32;
+    else if (iName == "double" || iName == "float64")
+        oType = ScalarType::Float64;
+    else
+        return false;
+    return true;
+}
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+int PlyHeader::Element::Find(std::initializer_list<std::string_view> iNames) const
+{
+    for (size_t i = 0; i < Properties.size(); ++i)
+    {
+        if (std::find(iNames.begin(), iNames.end(), Properties[i].Name) != iNames.end())
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t PlyHeader::GetTypeSize(ScalarType iType)
+{
+    switch (iType)
+    {
+    case ScalarType::Int8:
+    case ScalarType::UInt8:
+        return 1;
+    case ScalarType::Int16:
+    case ScalarType::UInt16:
+        return 2;
+    case ScalarType::Int32:
+    case ScalarType::UInt32:
+    case ScalarType::Float32:
+        return 4;
+    case ScalarType::Float64:
+        return 8;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+double PlyHeader::LoadScalar(const uint8_t *iData, ScalarType iType)
+{
+    switch (iType)
+    {
+    case ScalarType::Int8:
+        return Load<int8_t>(iData);
+    case ScalarType::UInt8:
+        return Load<uint8_t>(iData);
+    case ScalarType::Int16:
+        return Load<int16_t>(iData);
+    case ScalarType::UInt16:
+        return Load<uint16_t>(iData);
+    case ScalarType::Int32:
+        return Load<int32_t>(iData);
+    case ScalarType::UInt32:
+        return Load<uint32_t>(iData);
+    case ScalarType::Float32:
+        return Load<float>(iData);
+    case ScalarType::Float64:
+        return Load<double>(iData);
+    }
+    return 0.0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+int PlyHeader::FindElement(std::string_view iName) const
+{
+    for (size_t i = 0; i < Elements.size(); ++i)
+    {
+        if (Elements[i].Name == iName)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t PlyHeader::GetElementOffset(int iElement) const
+{
+    size_t offset = DataOffset;
+    for (int i = 0; i < iElement; ++i)
+    {
+        // An element without properties has no data, only list properties make the size of a record variable.
+        const bool hasList = std::any_of(
+            Elements[i].Properties.begin(), Elements[i].Properties.end(), [](const Property &p) { return p.IsList; });
+        if (hasList && Elements[i].Count > 0)
+            throw std::runtime_error("PLY element " + Elements[iElement].Name + " is preceded by an element with list properties");
+        offset += Elements[i].Count * Elements[i].Stride;
+    }
+    return offset;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+PlyHeader PlyHeader::Parse(std::string_view iContent, const std::filesystem::path &iFilePath)
+{
+    const std::string error = "invalid PLY file " + iFilePath.string() + ": ";
+
+    if (iContent.substr(0, 3) != "ply")
+        throw std::runtime_error(error + "missing magic number");
+
+    const size_t endHeader = iContent.find("end_header");
+    if (endHeader == std::string_view::npos)
+        throw std::runtime_error(error + "missing end_header");
+
+    PlyHeader header;
+    header.DataOffset = iContent.find('\n', endHeader);
+    if (header.DataOffset == std::string_view::npos)
+        throw std::runtime_error(error + "truncated header");
+    ++header.DataOffset;
+
+    std::istringstream lines{std::string(iContent.substr(0, endHeader))};
+    std::string line;
+    bool hasFormat = false;
+    while (std::getline(lines, line))
+    {
+        std::istringstream tokens(line);
+        std::string keyword;
+        tokens >> keyword;
+
+        if (keyword == "format")
+        {
+            std::string format;
+            tokens >> format;
+            if (format == "ascii")
+                header.Encoding = Format::Ascii;
+            else if (format == "binary_little_endian")
+                header.Encoding = Format::BinaryLittleEndian;
+            else if (format == "binary_big_endian")
+                header.Encoding = Format::BinaryBigEndian;
+            else
+                throw std::runtime_error(error + "unknown format " + format);
+            hasFormat = true;
+        }
+        else if (keyword == "element")
+        {
+            Element element;
+            tokens >> element.Name >> element.Count;
+            header.Elements.push_back(std::move(element));
+        }
+        else if (keyword == "property")
+        {
+            if (header.Elements.empty())
+                throw std::runtime_error(error + "property outside of an element");
+            Element &element = header.Elements.back();
+
+            Property property;
+            std::string typeName;
+            tokens >> typeName;
+            if (typeName == "list")
+            {
+                std::string countTypeName;
+                tokens >> countTypeName >> typeName;
+                if (!ParseType(countTypeName, property.CountType))
+                    throw std::runtime_error(error + "unknown property type " + countTypeName);
+                property.IsList = true;
+            }
+            if (!ParseType(typeName, property.Type))
+                throw std::runtime_error(error + "unknown property type " + typeName);
+            tokens >> property.Name;
+
+            // The stride stays 0 once the element has a list: its records have no fixed size.
+            const bool fixedSize = element.Properties.empty() || element.Stride != 0;
+            property.Offset = element.Stride;
+            element.Stride = (fixedSize && !property.IsList) ? element.Stride + GetTypeSize(property.Type) : 0;
+            element.Properties.push_back(std::move(property));
+        }
+    }
+
+    if (!hasFormat)
+        throw std::runtime_error(error + "missing format");
+    return header;
+}
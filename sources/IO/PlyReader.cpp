@@ -0,0 +1,148 @@
+#include "IO/PlyReader.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T>
+T Load(const uint8_t *iData)
+{
+    T value;
+    std::memcpy(&value, iData, sizeof(T));
+    return value;
+}
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+PlyReader::PlyReader(const std::filesystem::path &iFilePath)
+    : m_File(iFilePath)
+{
+    ParseHeader(iFilePath);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PlyReader::ParseHeader(const std::filesystem::path &iFilePath)
+{
+    const std::string_view content(reinterpret_cast<const char *>(m_File.GetData()), m_File.GetSize());
+    const std::string error = "invalid PLY file " + iFilePath.string() + ": ";
+
+    const PlyHeader header = PlyHeader::Parse(content, iFilePath);
+    if (header.Encoding != PlyHeader::Format::BinaryLittleEndian)
+        throw std::runtime_error(error + "only binary_little_endian is supported");
+
+    const int vertexElement = header.FindElement("vertex");
+    if (vertexElement < 0)
+        throw std::runtime_error(error + "no vertex element");
+    const PlyHeader::Element &vertex = header.Elements[vertexElement];
+    if (vertex.Stride == 0 && vertex.Count > 0)
+        throw std::runtime_error(error + "list properties in the vertex element are not supported");
+    if (vertex.Count > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error(error + "too many vertices");
+
+    // Elements stored before the vertices are skipped.
+    m_PointCount = static_cast<uint32_t>(vertex.Count);
+    m_VertexOffset = header.GetElementOffset(vertexElement);
+    m_Stride = vertex.Stride;
+
+    auto findProperty = [&vertex](std::initializer_list<std::string_view> iNames) -> Property
+    {
+        const int index = vertex.Find(iNames);
+        if (index < 0)
+            return {};
+        return {vertex.Properties[index].Type, vertex.Properties[index].Offset, true};
+    };
+    m_Position = {findProperty({"x"}), findProperty({"y"}), findProperty({"z"})};
+    m_Color = {findProperty({"red", "r", "diffuse_red"}), findProperty({"green", "g", "diffuse_green"}), findProperty({"blue", "b", "diffuse_blue"})};
+
+    if (!m_Position[0].Found || !m_Position[1].Found || !m_Position[2].Found)
+        throw std::runtime_error(error + "missing x, y or z property");
+    if (m_VertexOffset + static_cast<size_t>(m_PointCount) * m_Stride > m_File.GetSize())
+        throw std::runtime_error(error + "file is truncated");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PlyReader::ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const
+{
+    const uint8_t *record = m_File.GetData() + m_VertexOffset + static_cast<size_t>(iFirst) * m_Stride;
+
+    // Most scanners export "float x, y, z; uchar red, green, blue" which is decoded with plain copies.
+    const bool packedLayout =
+        m_Position[0].Type == ScalarType::Float32 && m_Position[0].Offset + 4 == m_Position[1].Offset &&
+        m_Position[1].Type == ScalarType::Float32 && m_Position[1].Offset + 4 == m_Position[2].Offset &&
+        m_Position[2].Type == ScalarType::Float32 &&
+        m_Color[0].Found && m_Color[0].Type == ScalarType::UInt8 && m_Color[0].Offset + 1 == m_Color[1].Offset &&
+        m_Color[1].Found && m_Color[1].Type == ScalarType::UInt8 && m_Color[1].Offset + 1 == m_Color[2].Offset &&
+        m_Color[2].Found && m_Color[2].Type == ScalarType::UInt8;
+
+    if (packedLayout)
+    {
+        const uint32_t positionOffset = m_Position[0].Offset;
+        const uint32_t colorOffset = m_Color[0].Offset;
+        for (uint32_t i = 0; i < iCount; ++i, record += m_Stride)
+        {
+            std::memcpy(&oPoints[i].Pos, record + positionOffset, sizeof(glm::vec3));
+            std::memcpy(&oPoints[i].Color, record + colorOffset, sizeof(glm::u8vec3));
+            oPoints[i].Attribute = 0;
+        }
+        return;
+    }
+
+    auto toFloat = [](const uint8_t *iData, ScalarType iType) -> float
+    {
+        switch (iType)
+        {
+        case ScalarType::Int8:
+            return Load<int8_t>(iData);
+        case ScalarType::UInt8:
+            return Load<uint8_t>(iData);
+        case ScalarType::Int16:
+            return Load<int16_t>(iData);
+        case ScalarType::UInt16:
+            return Load<uint16_t>(iData);
+        case ScalarType::Int32:
+            return static_cast<float>(Load<int32_t>(iData));
+        case ScalarType::UInt32:
+            return static_cast<float>(Load<uint32_t>(iData));
+        case ScalarType::Float32:
+            return Load<float>(iData);
+        case ScalarType::Float64:
+            return static_cast<float>(Load<double>(iData));
+        }
+        return 0.0f;
+    };
+
+    // Colors are brought back to 8 bits: 16-bit channels are shifted, floating point ones are expected in [0, 1].
+    auto toColor = [&toFloat](const uint8_t *iData, const Property &iProperty) -> uint8_t
+    {
+        if (!iProperty.Found)
+            return 255;
+        const uint8_t *data = iData + iProperty.Offset;
+        switch (iProperty.Type)
+        {
+        case ScalarType::UInt8:
+            return Load<uint8_t>(data);
+        case ScalarType::UInt16:
+            return static_cast<uint8_t>(Load<uint16_t>(data) >> 8);
+        case ScalarType::Float32:
+        case ScalarType::Float64:
+            return static_cast<uint8_t>(std::clamp(toFloat(data, iProperty.Type), 0.0f, 1.0f) * 255.0f + 0.5f);
+        default:
+            return static_cast<uint8_t>(std::clamp(toFloat(data, iProperty.Type), 0.0f, 255.0f));
+        }
+    };
+
+    for (uint32_t i = 0; i < iCount; ++i, record += m_Stride)
+    {
+        oPoints[i].Pos.x = toFloat(record + m_Position[0].Offset, m_Position[0].Type);
+        oPoints[i].Pos.y = toFloat(record + m_Position[1].Offset, m_Position[1].Type);
+        oPoints[i].Pos.z = toFloat(record + m_Position[2].Offset, m_Position[2].Type);
+        oPoints[i].Color.r = toColor(record, m_Color[0]);
+        oPoints[i].Color.g = toColor(record, m_Color[1]);
+        oPoints[i].Color.b = toColor(record, m_Color[2]);
+        oPoints[i].Attribute = 0;
+    }
+}
@@ -0,0 +1,241 @@
+#include "IO/ProgressiveOrder.h"
+#include "Parallel.h"
+#include "Permutation.h"
+#include <glm/common.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+/// Number of points read at once from the cloud.
+constexpr uint32_t BLOCK_SIZE = 1 << 16;
+
+/// Bounding box of a cloud.
+struct Bounds
+{
+    glm::vec3 Min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 Max = glm::vec3(std::numeric_limits<float>::lowest());
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+///  Reads the cloud block by block on all the workers and runs iTask(worker, first, count, points) on each block.
+template <typename Task>
+void ForEachBlock(const CloudReader &iReader, Task &&iTask)
+{
+    const uint32_t pointCount = iReader.GetPointCount();
+    const uint32_t blockCount = (pointCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const uint32_t workerCount = std::max(std::min(GetWorkerCount(), blockCount), 1u);
+    std::atomic<uint32_t> nextBlock{0};
+    ParallelFor(
+        workerCount,
+        [&](uint32_t iWorker)
+        {
+            std::vector<OptiCloudVertex> points(std::min(BLOCK_SIZE, pointCount));
+            for (uint32_t block = nextBlock++; block < blockCount; block = nextBlock++)
+            {
+                const uint32_t first = block * BLOCK_SIZE;
+                const uint32_t count = std::min(BLOCK_SIZE, pointCount - first);
+                iReader.ReadPoints(first, count, points.data());
+                iTask(iWorker, first, count, points.data());
+            }
+        });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+Bounds ComputeBounds(const CloudReader &iReader)
+{
+    std::vector<Bounds> workerBounds(GetWorkerCount());
+    ForEachBlock(
+        iReader,
+        [&](uint32_t iWorker, uint32_t, uint32_t iCount, const OptiCloudVertex *iPoints)
+        {
+            for (uint32_t i = 0; i < iCount; ++i)
+            {
+                workerBounds[iWorker].Min = glm::min(workerBounds[iWorker].Min, iPoints[i].Pos);
+                workerBounds[iWorker].Max = glm::max(workerBounds[iWorker].Max, iPoints[i].Pos);
+            }
+        });
+
+    Bounds bounds;
+    for (const Bounds &worker : workerBounds)
+    {
+        bounds.Min = glm::min(bounds.Min, worker.Min);
+        bounds.Max = glm::max(bounds.Max, worker.Max);
+    }
+    return bounds;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+///  Inserts two zero bits between the 10 low bits of a value.
+uint32_t SpreadBits(uint32_t iValue)
+{
+    iValue &= 0x3ff;
+    iValue = (iValue | iValue << 16) & 0x030000ff;
+    iValue = (iValue | iValue << 8) & 0x0300f00f;
+    iValue = (iValue | iValue << 4) & 0x030c30c3;
+    iValue = (iValue | iValue << 2) & 0x09249249;
+    return iValue;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+///  Inverts a progressive order: the index of the point at each place.
+std::vector<uint32_t> InvertOrder(const std::vector<uint32_t> &iOrder)
+{
+    std::vector<uint32_t> inverse(iOrder.size());
+    for (uint32_t i = 0; i < iOrder.size(); ++i)
+        inverse[iOrder[i]] = i;
+    return inverse;
+}
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<uint32_t> ComputeStratifiedOrder(const CloudReader &iReader)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const uint32_t pointCount = iReader.GetPointCount();
+    const Bounds bounds = ComputeBounds(iReader);
+    const glm::vec3 size = bounds.Max - bounds.Min;
+    const float extent = std::max({size.x, size.y, size.z, std::numeric_limits<float>::min()});
+    const uint32_t resolution = 1u << STRATIFICATION_LEVEL;
+    const uint32_t cellCount = resolution * resolution * resolution;
+
+    std::vector<uint32_t> cells(pointCount);
+    ForEachBlock(
+        iReader,
+        [&](uint32_t, uint32_t iFirst, uint32_t iCount, const OptiCloudVertex *iPoints)
+        {
+            for (uint32_t i = 0; i < iCount; ++i)
+            {
+                const glm::uvec3 cell = glm::min(glm::uvec3((iPoints[i].Pos - bounds.Min) / extent * static_cast<float>(resolution)), resolution - 1);
+                cells[iFirst + i] = SpreadBits(cell.x) | SpreadBits(cell.y) << 1 | SpreadBits(cell.z) << 2;
+            }
+        });
+
+    // Counting sort of the points by cell. They are visited in random order, so each cell lists its points randomly.
+    std::vector<uint32_t> offsets(cellCount + 1, 0);
+    for (uint32_t cell : cells)
+        ++offsets[cell + 1];
+    for (uint32_t cell = 0; cell < cellCount; ++cell)
+        offsets[cell + 1] += offsets[cell];
+    std::vector<uint32_t> members(pointCount);
+    std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+    const Permutation permutation(pointCount);
+    for (uint32_t j = 0; j < pointCount; ++j)
+    {
+        const uint32_t i = permutation(j);
+        members[cursors[cells[i]]++] = i;
+    }
+
+    // Round robin over the occupied cells, the cells are no longer needed and their memory holds the order.
+    std::vector<uint32_t> activeCells;
+    for (uint32_t cell = 0; cell < cellCount; ++cell)
+    {
+        if (offsets[cell + 1] > offsets[cell])
+            activeCells.push_back(cell);
+    }
+    const size_t occupiedCellCount = activeCells.size();
+    std::vector<uint32_t> &order = cells;
+    uint32_t next = 0;
+    uint32_t round = 0;
+    for (; !activeCells.empty(); ++round)
+    {
+        size_t keptCount = 0;
+        for (uint32_t cell : activeCells)
+        {
+            order[members[offsets[cell] + round]] = next++;
+            if (offsets[cell + 1] - offsets[cell] > round + 1)
+                activeCells[keptCount++] = cell;
+        }
+        activeCells.resize(keptCount);
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Stratified order of " << pointCount << " points over " << occupiedCellCount << " cells (" << round
+              << " rounds) in " << elapsed.count() << " s" << std::endl;
+    return cells;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void BenchmarkProgressiveOrders(const CloudReader &iReader, uint32_t iResolution)
+{
+    const uint32_t pointCount = iReader.GetPointCount();
+    const Bounds bounds = ComputeBounds(iReader);
+
+    // Project along the smallest extent, with square pixels.
+    const glm::vec3 size = bounds.Max - bounds.Min;
+    const int depthAxis = size.x <= size.y && size.x <= size.z ? 0 : (size.y <= size.z ? 1 : 2);
+    const int uAxis = depthAxis == 0 ? 1 : 0;
+    const int vAxis = depthAxis == 2 ? 1 : 2;
+    const float pixelSize = std::max({size[uAxis], size[vAxis], std::numeric_limits<float>::min()}) / static_cast<float>(iResolution);
+    const uint32_t width = std::max(static_cast<uint32_t>(std::ceil(size[uAxis] / pixelSize)), 1u);
+    const uint32_t height = std::max(static_cast<uint32_t>(std::ceil(size[vAxis] / pixelSize)), 1u);
+
+    std::vector<uint32_t> pixels(pointCount);
+    ForEachBlock(
+        iReader,
+        [&](uint32_t, uint32_t iFirst, uint32_t iCount, const OptiCloudVertex *iPoints)
+        {
+            for (uint32_t i = 0; i < iCount; ++i)
+            {
+                const uint32_t u = std::min(static_cast<uint32_t>((iPoints[i].Pos[uAxis] - bounds.Min[uAxis]) / pixelSize), width - 1);
+                const uint32_t v = std::min(static_cast<uint32_t>((iPoints[i].Pos[vAxis] - bounds.Min[vAxis]) / pixelSize), height - 1);
+                pixels[iFirst + i] = v * width + u;
+            }
+        });
+
+    // Number of pixels covered after each power of two of millions of points, and by the whole cloud.
+    std::vector<uint32_t> marks;
+    for (uint64_t mark = 1'000'000; mark < pointCount; mark *= 2)
+        marks.push_back(static_cast<uint32_t>(mark));
+    marks.push_back(pointCount);
+
+    auto measure = [&](const std::vector<uint32_t> &iPointAtPlace)
+    {
+        std::vector<bool> covered(static_cast<size_t>(width) * height, false);
+        std::vector<uint32_t> coverage;
+        uint32_t coveredCount = 0;
+        uint32_t place = 0;
+        for (uint32_t mark : marks)
+        {
+            for (; place < mark; ++place)
+            {
+                const uint32_t pixel = pixels[iPointAtPlace[place]];
+                coveredCount += covered[pixel] ? 0 : 1;
+                covered[pixel] = true;
+            }
+            coverage.push_back(coveredCount);
+        }
+        return coverage;
+    };
+
+    std::vector<uint32_t> randomOrder(pointCount);
+    const Permutation permutation(pointCount);
+    for (uint32_t i = 0; i < pointCount; ++i)
+        randomOrder[i] = permutation(i);
+    const std::vector<uint32_t> randomCoverage = measure(InvertOrder(randomOrder));
+    std::vector<uint32_t>().swap(randomOrder);
+    const std::vector<uint32_t> stratifiedCoverage = measure(InvertOrder(ComputeStratifiedOrder(iReader)));
+
+    const double total = std::max(randomCoverage.back(), 1u);
+    std::cout << "Pixels covered on a " << width << "x" << height << " projection (" << randomCoverage.back()
+              << " for the whole cloud)" << std::endl;
+    std::cout << std::setw(12) << "points" << std::setw(12) << "random" << std::setw(12) << "stratified"
+              << std::setw(16) << "px/M random" << std::setw(20) << "px/M stratified" << std::endl;
+    const std::ios_base::fmtflags flags = std::cout.flags();
+    const std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t m = 0; m < marks.size(); ++m)
+    {
+        const double millions = marks[m] / 1e6;
+        std::cout << std::setw(12) << marks[m] << std::setw(11) << 100.0 * randomCoverage[m] / total << "%"
+                  << std::setw(11) << 100.0 * stratifiedCoverage[m] / total << "%" << std::setw(16)
+                  << randomCoverage[m] / millions << std::setw(20) << stratifiedCoverage[m] / millions << std::endl;
+    }
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
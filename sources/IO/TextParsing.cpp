@@ -0,0 +1,34 @@
+#include "IO/TextParsing.h"
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<std::string_view> SplitLines(std::string_view iText, uint32_t iRangeCount)
+{
+    std::vector<std::string_view> ranges;
+    const size_t targetSize = iText.size() / std::max(iRangeCount, 1u) + 1;
+
+    size_t begin = 0;
+    while (begin < iText.size())
+    {
+        size_t end = begin + targetSize;
+        if (end >= iText.size())
+        {
+            end = iText.size();
+        }
+        else
+        {
+            end = iText.find('\n', end);
+            end = end == std::string_view::npos ? iText.size() : end + 1;
+        }
+        ranges.push_back(iText.substr(begin, end - begin));
+        begin = end;
+    }
+    return ranges;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t CountLines(std::string_view iText)
+{
+    const uint64_t newlines = static_cast<uint64_t>(std::count(iText.begin(), iText.end(), '\n'));
+    return (!iText.empty() && iText.back() != '\n') ? newlines + 1 : newlines;
+}
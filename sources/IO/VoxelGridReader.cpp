@@ -0,0 +1,153 @@
+#include "IO/VoxelGridReader.h"
+#include "Parallel.h"
+#include <glm/common.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+/// Number of points read at once from the source.
+constexpr uint32_t BLOCK_SIZE = 1 << 16;
+
+/// A point and its cell.
+struct CellEntry
+{
+    glm::ivec3 Cell;
+    uint32_t Index;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t Mix(uint64_t iValue)
+{
+    iValue ^= iValue >> 33;
+    iValue *= 0xff51afd7ed558ccdull;
+    iValue ^= iValue >> 33;
+    iValue *= 0xc4ceb9fe1a85ec53ull;
+    iValue ^= iValue >> 33;
+    return iValue;
+}
+
+/// Hash of a cell of the grid.
+struct CellHash
+{
+    size_t operator()(const glm::ivec3 &iCell) const
+    {
+        const uint64_t xy = static_cast<uint64_t>(static_cast<uint32_t>(iCell.x)) << 32 | static_cast<uint32_t>(iCell.y);
+        return static_cast<size_t>(Mix(xy ^ Mix(static_cast<uint32_t>(iCell.z))));
+    }
+};
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+VoxelGridReader::VoxelGridReader(
+    std::unique_ptr<CloudReader> iReader, float iCellSize, uint32_t iPointsPerCell, const std::vector<glm::mat4> &iTransforms)
+    : m_Reader(std::move(iReader))
+{
+    if (iCellSize <= 0.0f || iPointsPerCell == 0)
+        throw std::runtime_error("the voxel grid needs a positive cell size and point count");
+    if (iTransforms.size() > 256)
+        throw std::runtime_error("the point attribute indexes at most 256 transforms");
+
+    const auto start = std::chrono::steady_clock::now();
+    const uint32_t pointCount = m_Reader->GetPointCount();
+    const uint32_t blockCount = (pointCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const uint32_t workerCount = std::max(std::min(GetWorkerCount(), blockCount), 1u);
+    const uint32_t shardCount = workerCount;
+
+    // Each worker distributes the cells of its blocks by shard, so the shards can be reduced without locks.
+    std::vector<std::vector<std::vector<CellEntry>>> buckets(workerCount, std::vector<std::vector<CellEntry>>(shardCount));
+    std::atomic<uint32_t> nextBlock{0};
+    ParallelFor(
+        workerCount,
+        [&](uint32_t iWorker)
+        {
+            std::vector<OptiCloudVertex> points(std::min(BLOCK_SIZE, pointCount));
+            for (uint32_t block = nextBlock++; block < blockCount; block = nextBlock++)
+            {
+                const uint32_t first = block * BLOCK_SIZE;
+                const uint32_t count = std::min(BLOCK_SIZE, pointCount - first);
+                m_Reader->ReadPoints(first, count, points.data());
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    glm::vec3 position = points[i].Pos;
+                    if (points[i].Attribute < iTransforms.size())
+                        position = glm::vec3(iTransforms[points[i].Attribute] * glm::vec4(position, 1.0f));
+                    const glm::ivec3 cell(glm::floor(position / iCellSize));
+                    buckets[iWorker][CellHash()(cell) % shardCount].push_back({cell, first + i});
+                }
+            }
+        });
+
+    std::vector<uint8_t> kept(pointCount, 0);
+    std::vector<uint64_t> cellCounts(shardCount, 0);
+    std::vector<uint32_t> maxCellPointCounts(shardCount, 0);
+    ParallelFor(
+        shardCount,
+        [&](uint32_t iShard)
+        {
+            std::vector<CellEntry> entries;
+            for (std::vector<std::vector<CellEntry>> &workerBuckets : buckets)
+            {
+                entries.insert(entries.end(), workerBuckets[iShard].begin(), workerBuckets[iShard].end());
+                std::vector<CellEntry>().swap(workerBuckets[iShard]);
+            }
+
+            // The blocks were taken in any order: sort back to keep the first points of the progressive order.
+            std::sort(entries.begin(), entries.end(), [](const CellEntry &iLeft, const CellEntry &iRight) { return iLeft.Index < iRight.Index; });
+            std::unordered_map<glm::ivec3, uint32_t, CellHash> cells;
+            for (const CellEntry &entry : entries)
+            {
+                const uint32_t cellPointCount = ++cells[entry.Cell];
+                if (cellPointCount <= iPointsPerCell)
+                    kept[entry.Index] = 1;
+                maxCellPointCounts[iShard] = std::max(maxCellPointCounts[iShard], cellPointCount);
+            }
+            cellCounts[iShard] = cells.size();
+        });
+
+    m_Kept.reserve(std::count(kept.begin(), kept.end(), 1));
+    for (uint32_t i = 0; i < pointCount; ++i)
+    {
+        if (kept[i])
+            m_Kept.push_back(i);
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    m_Statistics.InputCount = pointCount;
+    m_Statistics.OutputCount = static_cast<uint32_t>(m_Kept.size());
+    for (uint32_t shard = 0; shard < shardCount; ++shard)
+    {
+        m_Statistics.CellCount += cellCounts[shard];
+        m_Statistics.MaxCellPointCount = std::max(m_Statistics.MaxCellPointCount, maxCellPointCounts[shard]);
+    }
+    m_Statistics.Seconds = elapsed.count();
+
+    std::cout << "Voxel grid " << iCellSize << " (" << iPointsPerCell << " per cell): kept " << m_Statistics.OutputCount
+              << " of " << m_Statistics.InputCount << " points ("
+              << (pointCount > 0 ? 100.0 * m_Statistics.OutputCount / pointCount : 0.0) << "%), "
+              << m_Statistics.CellCount << " cells, up to " << m_Statistics.MaxCellPointCount << " points per cell, in "
+              << m_Statistics.Seconds << " s" << std::endl;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void VoxelGridReader::ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const
+{
+    std::vector<OptiCloudVertex> points;
+    for (uint32_t i = 0; i < iCount;)
+    {
+        // Kept points close in the source are read with one call, the dropped ones in between are discarded.
+        const uint32_t sourceFirst = m_Kept[iFirst + i];
+        uint32_t end = i + 1;
+        while (end < iCount && m_Kept[iFirst + end] - sourceFirst < BLOCK_SIZE)
+            ++end;
+
+        points.resize(m_Kept[iFirst + end - 1] - sourceFirst + 1);
+        m_Reader->ReadPoints(sourceFirst, static_cast<uint32_t>(points.size()), points.data());
+        for (; i < end; ++i)
+            oPoints[i] = points[m_Kept[iFirst + i] - sourceFirst];
+    }
+}
@@ -0,0 +1,146 @@
+#include "IO/XyzReader.h"
+#include "IO/MappedFile.h"
+#include "IO/TextParsing.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+/// Largest number of columns read on a line: x y z intensity r g b.
+constexpr uint32_t MAX_COLUMNS = 7;
+
+/// Columns of a point.
+struct Layout
+{
+    /// Column of the red channel, the others follow. 0 if the points have no color.
+    uint32_t ColorColumn = 0;
+    /// Factor bringing the colors to [0, 255].
+    double ColorScale = 1.0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+///  Parses the numbers of a line, separated by blanks or commas, and moves to the next line.
+/// @return Number of values read, the line is not a point if it is less than 3.
+uint32_t ParseLine(const char *&ioCursor, const char *iEnd, std::array<double, MAX_COLUMNS> &oValues)
+{
+    const char *cursor = ioCursor;
+    uint32_t count = 0;
+    while (count < MAX_COLUMNS && ParseNumber(cursor, iEnd, oValues[count]))
+    {
+        ++count;
+        cursor = SkipBlanks(cursor, iEnd);
+        if (cursor != iEnd && *cursor == ',')
+            ++cursor;
+    }
+    ioCursor = SkipLine(cursor, iEnd);
+    return count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+OptiCloudVertex ToVertex(const std::array<double, MAX_COLUMNS> &iValues, uint32_t iCount, const Layout &iLayout, const glm::dvec3 &iOrigin)
+{
+    OptiCloudVertex vertex;
+    vertex.Pos = glm::vec3(glm::dvec3(iValues[0], iValues[1], iValues[2]) - iOrigin);
+    vertex.Color = {255, 255, 255};
+    if (iLayout.ColorColumn != 0 && iCount >= iLayout.ColorColumn + 3)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+            vertex.Color[c] = static_cast<uint8_t>(std::clamp(iValues[iLayout.ColorColumn + c] * iLayout.ColorScale, 0.0, 255.0));
+    }
+    return vertex;
+}
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+XyzReader::XyzReader(const std::filesystem::path &iFilePath)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const MappedFile file(iFilePath);
+    const char *text = reinterpret_cast<const char *>(file.GetData());
+    const char *end = text + file.GetSize();
+
+    // The first point gives the origin and the columns, the lines before it (PTS point count, comments) are skipped.
+    std::array<double, MAX_COLUMNS> values{};
+    const char *dataBegin = text;
+    uint32_t columnCount = 0;
+    while (dataBegin != end && columnCount < 3)
+    {
+        const char *line = dataBegin;
+        columnCount = ParseLine(dataBegin, end, values);
+        if (columnCount >= 3)
+            dataBegin = line;
+    }
+    if (columnCount < 3)
+        throw std::runtime_error("invalid XYZ file " + iFilePath.string() + ": no point found");
+
+    // x y z r g b, or x y z intensity r g b. Colors in [0, 1] are written with a fractional part.
+    Layout layout;
+    if (columnCount == 6 || columnCount == 7)
+    {
+        layout.ColorColumn = columnCount - 3;
+        const bool unitColors = std::all_of(&values[layout.ColorColumn], &values[layout.ColorColumn] + 3, [](double iValue) { return iValue <= 1.0; }) &&
+                                std::any_of(&values[layout.ColorColumn], &values[layout.ColorColumn] + 3, [](double iValue) { return iValue != std::floor(iValue); });
+        layout.ColorScale = unitColors ? 255.0 : 1.0;
+    }
+    m_Origin = glm::dvec3(values[0], values[1], values[2]);
+
+    const std::vector<std::string_view> ranges = SplitLines(std::string_view(dataBegin, end - dataBegin), GetWorkerCount());
+    m_Blocks.resize(ranges.size());
+    ParallelFor(
+        static_cast<uint32_t>(ranges.size()),
+        [&](uint32_t iRange)
+        {
+            // Reserved from the line count so the block is never reallocated while parsing.
+            std::vector<OptiCloudVertex> &points = m_Blocks[iRange].Points;
+            points.reserve(CountLines(ranges[iRange]));
+
+            std::array<double, MAX_COLUMNS> lineValues{};
+            const char *cursor = ranges[iRange].data();
+            const char *rangeEnd = cursor + ranges[iRange].size();
+            while (cursor != rangeEnd)
+            {
+                const uint32_t count = ParseLine(cursor, rangeEnd, lineValues);
+                if (count >= 3)
+                    points.push_back(ToVertex(lineValues, count, layout, m_Origin));
+            }
+        });
+
+    uint64_t pointCount = 0;
+    for (Block &block : m_Blocks)
+    {
+        block.First = static_cast<uint32_t>(pointCount);
+        pointCount += block.Points.size();
+        if (pointCount > std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error("invalid XYZ file " + iFilePath.string() + ": too many points");
+    }
+    m_PointCount = static_cast<uint32_t>(pointCount);
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double megabytes = static_cast<double>(file.GetSize()) / 1e6;
+    std::cout << "Parsed " << m_PointCount << " points from " << iFilePath << " in " << elapsed.count() << " s ("
+              << megabytes / elapsed.count() << " MB/s, " << ranges.size() << " threads)" << std::endl;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void XyzReader::ReadPoints(uint32_t iFirst, uint32_t iCount, OptiCloudVertex *oPoints) const
+{
+    auto block = std::upper_bound(m_Blocks.begin(), m_Blocks.end(), iFirst, [](uint32_t iIndex, const Block &iBlock) { return iIndex < iBlock.First; });
+    --block;
+    while (iCount > 0)
+    {
+        const uint32_t offset = iFirst - block->First;
+        const uint32_t count = std::min<uint32_t>(iCount, static_cast<uint32_t>(block->Points.size()) - offset);
+        std::memcpy(oPoints, block->Points.data() + offset, static_cast<size_t>(count) * sizeof(OptiCloudVertex));
+        oPoints += count;
+        iFirst += count;
+        iCount -= count;
+        ++block;
+    }
+}
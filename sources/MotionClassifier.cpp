@@ -0,0 +1,62 @@
+#include "MotionClassifier.h"
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace
+{
+/// Normalized coordinates of the probe grid, on each axis.
+constexpr float PROBE_COORDINATES[] = {-0.75f, 0.0f, 0.75f};
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+CameraMotion MotionClassifier::Update(const glm::mat4 &iView, const glm::mat4 &iProj, uint32_t iWidth, uint32_t iHeight)
+{
+    const bool hadPrevious = std::exchange(m_HasPrevious, true);
+    const glm::mat4 previousView = std::exchange(m_PreviousView, iView);
+    const glm::mat4 previousProj = std::exchange(m_PreviousProj, iProj);
+    if (!hadPrevious)
+    {
+        m_Displacement = std::numeric_limits<float>::infinity();
+        return CameraMotion::Large;
+    }
+    if (iView == previousView && iProj == previousProj)
+    {
+        m_Displacement = 0.0f;
+        return CameraMotion::Still;
+    }
+
+    // Depth of the scene origin in the previous view.
+    const float distance = std::max(glm::length(glm::vec3(previousView[3])), 1e-3f);
+    const glm::vec4 probeClip = previousProj * glm::vec4(0.0f, 0.0f, -distance, 1.0f);
+    const float probeDepth = probeClip.z / probeClip.w;
+
+    const glm::mat4 previousInvViewProj = glm::inverse(previousProj * previousView);
+    const glm::mat4 viewProj = iProj * iView;
+    const glm::vec2 halfSize(0.5f * static_cast<float>(iWidth), 0.5f * static_cast<float>(iHeight));
+    m_Displacement = 0.0f;
+    for (float y : PROBE_COORDINATES)
+    {
+        for (float x : PROBE_COORDINATES)
+        {
+            const glm::vec4 world = previousInvViewProj * glm::vec4(x, y, probeDepth, 1.0f);
+            const glm::vec4 clip = viewProj * (world / world.w);
+            // A probe passing behind the camera is a large motion.
+            if (clip.w <= std::numeric_limits<float>::epsilon())
+            {
+                m_Displacement = std::numeric_limits<float>::infinity();
+                return CameraMotion::Large;
+            }
+            const glm::vec2 offset = (glm::vec2(clip) / clip.w - glm::vec2(x, y)) * halfSize;
+            m_Displacement = std::max(m_Displacement, glm::length(offset));
+        }
+    }
+
+    if (m_Displacement <= SMALL_MOTION_PIXELS)
+        return CameraMotion::Small;
+    if (m_Displacement < LARGE_MOTION_PIXELS)
+        return CameraMotion::Medium;
+    return CameraMotion::Large;
+}
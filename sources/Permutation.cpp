@@ -0,0 +1,20 @@
+#include "Permutation.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+Permutation::Permutation(uint32_t iCount, uint64_t iSeed)
+    : m_Count(iCount)
+{
+    // Smallest even number of bits covering the count, so both halves have the same size.
+    while (m_HalfBits < 16 && (uint64_t{1} << (2 * m_HalfBits)) < iCount)
+        ++m_HalfBits;
+
+    // SplitMix64 expands the seed into the round keys.
+    for (uint32_t &key : m_Keys)
+    {
+        iSeed += 0x9e3779b97f4a7c15ull;
+        uint64_t value = iSeed;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+        key = static_cast<uint32_t>(value ^ (value >> 31));
+    }
+}
@@ -1,16 +1,23 @@
 #include "Renderer.h"
 #include "Camera.h"
+#include "IO/CloudReader.h"
+#include "IO/VoxelGridReader.h"
 #include "Olympus/Debug.h"
+#include "Parallel.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <vulkan/vulkan.h>
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <iostream>
 #include <stdexcept>
+#include <string>
+#include <utility>
 
 //----------------------------------------------------------------------------------------------------------------------
 Renderer::Renderer(const olp::Instance &iInstance, VkSurfaceKHR iSurface, uint32_t iWidth, uint32_t iHeight)
     : m_Device(iInstance, iSurface),
       m_Swapchain(m_Device, iWidth, iHeight),
-      m_MainPassDescriptor(m_Device),
       m_GradientPassDescriptor(m_Device),
       m_PipelineLayout(m_Device),
       m_GradientPipelineLayout(m_Device),
@@ -19,6 +26,7 @@ Renderer::Renderer(const olp::Instance &iInstance, VkSurfaceKHR iSurface, uint32
       m_ReprojectedPipeline(m_Device),
       m_CloudPipeline(m_Device),
       m_MeshPipeline(m_Device),
+      m_ResolvePipeline(m_Device),
       m_PreparePass(m_Device),
       m_DepthBuffer(m_Device),
       m_VertexIndexImage(m_Device)
@@ -32,8 +40,8 @@ void Renderer::InitResources()
     std::cout << "Create ressources" << std::endl;
 
     InitGeometry();
-    CreateSwapchainRessources();
     CreateSyncObjects();
+    CreateSwapchainRessources();
     CreateCommandBuffers();
     UpdatePointSize(2);
 }
@@ -42,12 +50,9 @@ void Renderer::InitResources()
 void Renderer::ReleaseResources()
 {
     std::cout << "Release ressources" << std::endl;
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
-    {
-        vkDestroySemaphore(m_Device.GetDevice(), m_RenderFinishedSemaphores[i], nullptr);
-        vkDestroySemaphore(m_Device.GetDevice(), m_ImageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(m_Device.GetDevice(), m_InFlightFences[i], nullptr);
-    }
+    m_FrameScheduler->WaitIdle();
+    m_FrameScheduler.reset();
+    vkDestroySemaphore(m_Device.GetDevice(), m_CloudUploadSemaphore, nullptr);
 
     for (VkMesh &m : m_Meshes)
         m.Destroy();
@@ -55,8 +60,14 @@ void Renderer::ReleaseResources()
     for (VkCloud &c : m_Clouds)
         c.Destroy();
 
+    if (m_CloudReader.valid())
+        m_CloudReader.wait();
+    m_LoadingCloud.reset();
     m_OptiCloud->Destroy();
     m_Quad->Destroy();
+    m_Timestamps.reset();
+    m_FinalSubpassCommandBuffers.reset();
+    m_PointRasterizer.reset();
     m_Device.Destroy();
 }
 
@@ -69,8 +80,8 @@ void Renderer::CreateSwapchainRessources()
     CreateRenderPass();
 
     m_Swapchain.CreateFrameBuffers(m_RenderPass, {m_VertexIndexImage.GetImageView(), m_DepthBuffer.GetImageView()});
+    m_ImageFrames.assign(m_Swapchain.GetImageCount(), 0);
     CreatePipelineLayout();
-    CreatePipelines();
     CreateUniformBuffers();
     CreateDescriptorPool();
     CreateDescriptorSets();
@@ -80,12 +91,30 @@ void Renderer::CreateSwapchainRessources()
         *m_OptiCloud,
         m_VertexIndexImage.GetImageView(),
         m_UniformBuffers.ScreenSize,
+        m_UniformBuffers.PrepareCloudTransforms,
         m_VertexIndexImage.GetWidth(),
-        m_VertexIndexImage.GetHeight());
+        m_VertexIndexImage.GetHeight(),
+        m_FrameScheduler->GetFrameCount());
+    if (m_PointRasterization == PointRasterization::Compute)
+    {
+        m_PointRasterizer = std::make_unique<PointRasterizer>(
+            m_Device,
+            *m_OptiCloud,
+            m_UniformBuffers.Model,
+            m_UniformBuffers.CloudTransforms,
+            m_UniformBuffers.ScreenSize,
+            m_UniformBuffers.Camera,
+            m_Swapchain.GetImageSize().width,
+            m_Swapchain.GetImageSize().height,
+            m_HoleFilling);
+    }
+    // After the point rasterizer, which owns the layout of the resolve pipeline.
+    CreatePipelines();
 
     ScreenSize sz{m_Swapchain.GetImageSize().width, m_Swapchain.GetImageSize().height};
     m_UniformBuffers.ScreenSize.SendData(&sz, sizeof(sz));
     m_OptiCloud->ResetDraw();
+    m_Convergence.Reset();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -108,8 +137,18 @@ void Renderer::ReleaseSwapchainResources()
     for (olp::CommandBuffer &commandBuffer : m_CommandBuffers)
         commandBuffer.Free();
 
-    m_UniformBuffers.Model.Destroy();
-    m_UniformBuffers.Camera.Destroy();
+    for (uint32_t i = 0; i < m_UniformBuffers.Model.size(); ++i)
+    {
+        m_UniformBuffers.Model[i].Destroy();
+        m_UniformBuffers.Camera[i].Destroy();
+        m_UniformBuffers.CloudTransforms[i].Destroy();
+    }
+    for (olp::UniformBuffer &buffer : m_UniformBuffers.PrepareCloudTransforms)
+        buffer.Destroy();
+    m_UniformBuffers.Model.clear();
+    m_UniformBuffers.Camera.clear();
+    m_UniformBuffers.CloudTransforms.clear();
+    m_UniformBuffers.PrepareCloudTransforms.clear();
     m_UniformBuffers.ScreenSize.Destroy();
     m_UniformBuffers.Lighting.Destroy();
     m_UniformBuffers.PointSize.Destroy();
@@ -117,6 +156,9 @@ void Renderer::ReleaseSwapchainResources()
     vkDestroyDescriptorPool(m_Device.GetDevice(), m_DescriptorPool, nullptr);
 
     m_MeshPipeline.Destroy();
+    if (m_PointRasterizer)
+        m_ResolvePipeline.Destroy();
+    m_PointRasterizer.reset();
     m_CloudPipeline.Destroy();
     m_GradientPipeline.Destroy();
     m_OptiCloudPipeline.Destroy();
@@ -153,69 +195,205 @@ void Renderer::InitGeometry()
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-void Renderer::CreateUniformBuffers()
+void Renderer::AddCloud(const std::filesystem::path &iFilePath)
 {
-    m_UniformBuffers.Model.Init(sizeof(ModelInfo), m_Device);
-    m_UniformBuffers.Camera.Init(sizeof(CameraInfo), m_Device);
-    m_UniformBuffers.ScreenSize.Init(sizeof(ScreenSize), m_Device);
-    m_UniformBuffers.Lighting.Init(sizeof(Lighting), m_Device);
-    m_UniformBuffers.PointSize.Init(sizeof(PointSize), m_Device);
+    AddClouds({CloudSource{iFilePath}});
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-void Renderer::UpdateUniformBuffers(const glm::mat4 &, const glm::mat4 &)
+void Renderer::AddClouds(const std::vector<CloudSource> &iSources, float iVoxelSize, uint32_t iPointsPerVoxel)
 {
-    // TODO
-    // CameraInfo cameraUbo{};
+    for (const CloudSource &source : iSources)
+        std::cout << "Load cloud " << source.FilePath << std::endl;
+
+    // A newer cloud cancels the one being loaded.
+    m_LoadingCloud.reset();
+    m_CloudReader = std::async(
+        std::launch::async,
+        [iSources, iVoxelSize, iPointsPerVoxel]()
+        {
+            std::vector<std::unique_ptr<CloudReader>> readers;
+            std::vector<glm::mat4> transforms;
+            for (const CloudSource &source : iSources)
+            {
+                readers.push_back(CloudReader::Open(source.FilePath));
+                transforms.push_back(source.Transform);
+            }
+            auto scene = std::make_unique<MultiCloudReader>(std::move(readers), transforms);
+
+            // The duplicates come from overlapping stations, so the whole scene goes through the grid.
+            OpenedCloud cloud;
+            cloud.Transforms = scene->GetTransforms();
+            cloud.Reader = std::move(scene);
+            if (iVoxelSize > 0.0f)
+                cloud.Reader = std::make_unique<VoxelGridReader>(std::move(cloud.Reader), iVoxelSize, iPointsPerVoxel, cloud.Transforms);
+            return cloud;
+        });
+}
 
-    // if (ioCamera.HasUpdated())
-    // {
-    //     switch (ioCamera.GetCameraType())
-    //     {
-    //     case CameraType::FreeFly:
-    //         cameraUbo.ViewMat = ioCamera.ComputeViewMatrix();
-    //         break;
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::UpdateCloudLoading()
+{
+    if (m_CloudReader.valid() && m_CloudReader.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        try
+        {
+            OpenedCloud cloud = m_CloudReader.get();
+            m_LoadingCloud = std::make_unique<VkOptiCloud>(m_Device);
+            m_LoadingCloud->SetTransforms(cloud.Transforms);
+            m_LoadingCloud->Stream(std::move(cloud.Reader), true);
+        }
+        catch (const std::exception &e)
+        {
+            // The current cloud stays drawn.
+            std::cerr << "Failed to load cloud: " << e.what() << std::endl;
+            m_LoadingCloud.reset();
+        }
+    }
 
-    //     case CameraType::LookAt:
-    //         cameraUbo.ViewMat = ioCamera.ComputeLookAt();
-    //         break;
+    if (!m_LoadingCloud)
+        return;
 
-    //     case CameraType::Orbit:
-    //         cameraUbo.ViewMat = ioCamera.ComputeOrbit();
-    //         break;
-    //     }
+    try
+    {
+        m_LoadingCloud->UpdateStreaming();
+    }
+    catch (const std::exception &e)
+    {
+        // The load is aborted, the current cloud stays drawn.
+        std::cerr << "Failed to load cloud: " << e.what() << std::endl;
+        m_LoadingCloud.reset();
+        return;
+    }
+    if (m_LoadingCloud->IsReadyToJoin())
+        JoinLoadedCloud();
+}
 
-    //     cameraUbo.InvViewMat = ioCamera.ComputeInverseViewMatrix();
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::JoinLoadedCloud()
+{
+    ReplaceCloud(std::move(m_LoadingCloud));
+    m_CloudUploadSemaphore = m_OptiCloud->TakeUploadSemaphore();
+    m_OptiCloud->ResetDraw();
+}
 
-    //     ioCamera.SetUpdated(false);
-    //     m_OptiCloud->ResetDraw();
-    // }
-    // else
-    // {
-    //     cameraUbo.ViewMat = ioCamera.GetViewMatrix();
-    //     cameraUbo.InvViewMat = ioCamera.GetInverseViewMatrix();
-    // }
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::ReplaceCloud(std::unique_ptr<VkOptiCloud> iCloud)
+{
+    // Only the frames drawing the old cloud are waited, not the upload of the new one.
+    m_FrameScheduler->WaitIdle();
 
-    // cameraUbo.ProjMat = ioCamera.GetProjectionMatrix();
-    // cameraUbo.ProjMat[1][1] *= -1;
+    const VkExtent2D imageSize = m_Swapchain.GetImageSize();
+    iCloud->SetPointsByStep(m_OptiCloud->GetPointsByStep());
+    iCloud->CreateReprojectedBuffer(imageSize.width, imageSize.height);
+    m_OptiCloud->Destroy();
+    m_OptiCloud = std::move(iCloud);
+    m_PreparePass.UpdateCloud(*m_OptiCloud, m_VertexIndexImage.GetWidth(), m_VertexIndexImage.GetHeight());
+    if (m_PointRasterizer)
+        m_PointRasterizer->UpdateCloud(*m_OptiCloud);
+    InvalidateCommandBuffers();
+}
 
-    // cameraUbo.InvProjMat = ioCamera.GetInverseProjectionMatrix();
-    // cameraUbo.InvProjMat[1][1] *= -1;
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::UpdateCloudStreaming(VkSemaphore &ioPrepareSemaphore)
+{
+    try
+    {
+        m_OptiCloud->UpdateStreaming(ioPrepareSemaphore);
+    }
+    catch (const std::exception &e)
+    {
+        // The points already streamed may reference chunks which will never be read: the whole cloud is dropped.
+        std::cerr << "Failed to load cloud: " << e.what() << std::endl;
+        auto placeholder = std::make_unique<VkOptiCloud>(m_Device);
+        placeholder->Init();
+        ReplaceCloud(std::move(placeholder));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::AddMesh(const std::filesystem::path &iFilePath)
+{
+    std::cout << "Load mesh " << iFilePath << std::endl;
+    VkMesh mesh(m_Device);
+    mesh.Load(iFilePath);
+
+    m_Meshes.push_back(std::move(mesh));
+    InvalidateCommandBuffers();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::CreateUniformBuffers()
+{
+    // The frames in flight read the matrices of their image, and the prepare passes those of their slot, while the
+    // host writes the next ones.
+    const uint32_t imageCount = m_Swapchain.GetImageCount();
+    m_UniformBuffers.Model.resize(imageCount);
+    m_UniformBuffers.Camera.resize(imageCount);
+    m_UniformBuffers.CloudTransforms.resize(imageCount);
+    for (uint32_t i = 0; i < imageCount; ++i)
+    {
+        m_UniformBuffers.Model[i].Init(sizeof(ModelInfo), m_Device);
+        m_UniformBuffers.Camera[i].Init(sizeof(CameraInfo), m_Device);
+        m_UniformBuffers.CloudTransforms[i].Init(sizeof(CloudTransforms), m_Device);
+    }
+    m_UniformBuffers.PrepareCloudTransforms.resize(m_FrameScheduler->GetFrameCount());
+    for (olp::UniformBuffer &buffer : m_UniformBuffers.PrepareCloudTransforms)
+        buffer.Init(sizeof(CloudTransforms), m_Device);
+    m_UniformBuffers.ScreenSize.Init(sizeof(ScreenSize), m_Device);
+    m_UniformBuffers.Lighting.Init(sizeof(Lighting), m_Device);
+    m_UniformBuffers.PointSize.Init(sizeof(PointSize), m_Device);
+}
 
-    // cameraUbo.CamPos = ioCamera.GetPosition();
+//----------------------------------------------------------------------------------------------------------------------
+CameraMotion Renderer::UpdateUniformBuffers(const glm::mat4 &iView, const glm::mat4 &iProj, uint32_t iIndex, uint32_t iFrame)
+{
+    // Only the matrices of the clouds actually merged are sent.
+    const std::vector<glm::mat4> &transforms = m_OptiCloud->GetTransforms();
+    const VkDeviceSize transformsSize = transforms.size() * sizeof(glm::mat4);
+    m_UniformBuffers.CloudTransforms[iIndex].SendData(transforms.data(), transformsSize);
+    m_UniformBuffers.PrepareCloudTransforms[iFrame].SendData(transforms.data(), transformsSize);
+
+    CameraInfo cameraUbo{};
+    cameraUbo.ViewMat = iView;
+    cameraUbo.InvViewMat = glm::inverse(iView);
+    // Vulkan clip space has Y pointing down.
+    cameraUbo.ProjMat = iProj;
+    cameraUbo.ProjMat[1][1] *= -1;
+    cameraUbo.InvProjMat = glm::inverse(cameraUbo.ProjMat);
+    cameraUbo.CamPos = glm::vec3(cameraUbo.InvViewMat[3]);
+
+    ModelInfo modelUbo{};
+    modelUbo.ModelMat = glm::mat4(1.f);
+    modelUbo.MVPMat = cameraUbo.ProjMat * cameraUbo.ViewMat * modelUbo.ModelMat;
+
+    m_UniformBuffers.Model[iIndex].SendData(&modelUbo, sizeof(modelUbo));
+    m_UniformBuffers.Camera[iIndex].SendData(&cameraUbo, sizeof(cameraUbo));
+
+    // The reprojected points carry the image through small motions: only larger ones draw the cloud again.
+    const VkExtent2D imageSize = m_Swapchain.GetImageSize();
+    const CameraMotion motion = m_MotionClassifier.Update(cameraUbo.ViewMat, cameraUbo.ProjMat, imageSize.width, imageSize.height);
+    switch (motion)
+    {
+    case CameraMotion::Still:
+    case CameraMotion::Small:
+        break;
 
-    // ModelInfo modelUbo{};
-    // modelUbo.ModelMat = glm::mat4(1.f);
-    // modelUbo.MVPMat = cameraUbo.ProjMat * cameraUbo.ViewMat * modelUbo.ModelMat;
+    case CameraMotion::Medium:
+        m_OptiCloud->RewindDraw(m_MotionClassifier.GetDisplacement() / MotionClassifier::LARGE_MOTION_PIXELS);
+        break;
 
-    // m_UniformBuffers.Model.SendData(modelUbo, sizeof(modelUbo));
-    // m_UniformBuffers.Camera.SendData(cameraUbo, sizeof(cameraUbo));
+    case CameraMotion::Large:
+        m_OptiCloud->ResetDraw();
+        break;
+    }
+    return motion;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::CreatePipelineLayout()
 {
-    std::vector<VkDescriptorSetLayoutBinding> descriptorBinding(4);
+    std::vector<VkDescriptorSetLayoutBinding> descriptorBinding(5);
 
     // Model UBO
     descriptorBinding[0].binding = 0;
@@ -245,6 +423,13 @@ void Renderer::CreatePipelineLayout()
     descriptorBinding[3].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     descriptorBinding[3].pImmutableSamplers = nullptr;
 
+    // Cloud transforms UBO
+    descriptorBinding[4].binding = 4;
+    descriptorBinding[4].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    descriptorBinding[4].descriptorCount = 1;
+    descriptorBinding[4].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    descriptorBinding[4].pImmutableSamplers = nullptr;
+
     m_PipelineLayout.Create(descriptorBinding);
 
     std::vector<VkDescriptorSetLayoutBinding> descriptorBindingGradient(1);
@@ -261,17 +446,25 @@ void Renderer::CreatePipelineLayout()
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::CreateDescriptorPool()
 {
+    // One main pass descriptor per swapchain image, one prepare pass descriptor per frame in flight.
+    const uint32_t imageCount = m_Swapchain.GetImageCount();
+    const uint32_t frameCount = m_FrameScheduler->GetFrameCount();
+
     VkDescriptorPoolSize uniformPoolSize{};
     uniformPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uniformPoolSize.descriptorCount = 6; // ModelInfo + CameraInfo + ScreenSize*2 + Lighting + PointSize
+    // (ModelInfo + CameraInfo + Lighting + PointSize + CloudTransforms) * images + ScreenSize
+    // + (ScreenSize + CloudTransforms) * frames
+    uniformPoolSize.descriptorCount = 5 * imageCount + 1 + 2 * frameCount;
 
     VkDescriptorPoolSize imagePoolSize{};
     imagePoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-    imagePoolSize.descriptorCount = 1; // Vertex Index Image
+    imagePoolSize.descriptorCount = frameCount; // Vertex Index Image
 
     VkDescriptorPoolSize storageBufferPoolSize{};
     storageBufferPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    storageBufferPoolSize.descriptorCount = 2; // Shuffled buffer + Reproject buffer
+    // (Shuffled buffer + Reproject buffer + Reproject draw command + Previous indices + Changed pixel count
+    // + Resident slots) * frames
+    storageBufferPoolSize.descriptorCount = 6 * frameCount;
 
     std::array<VkDescriptorPoolSize, 3> poolSizes{uniformPoolSize, imagePoolSize, storageBufferPoolSize};
 
@@ -279,7 +472,7 @@ void Renderer::CreateDescriptorPool()
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = 3;
+    poolInfo.maxSets = imageCount + 1 + frameCount;
 
     VK_CHECK_RESULT(vkCreateDescriptorPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_DescriptorPool))
 }
@@ -287,12 +480,20 @@ void Renderer::CreateDescriptorPool()
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::CreateDescriptorSets()
 {
-    m_MainPassDescriptor.AllocateDescriptorSets(m_PipelineLayout.GetDescriptorLayout(), m_DescriptorPool);
-    m_MainPassDescriptor.AddWriteDescriptor(0, m_UniformBuffers.Model);
-    m_MainPassDescriptor.AddWriteDescriptor(1, m_UniformBuffers.Camera);
-    m_MainPassDescriptor.AddWriteDescriptor(2, m_UniformBuffers.Lighting);
-    m_MainPassDescriptor.AddWriteDescriptor(3, m_UniformBuffers.PointSize);
-    m_MainPassDescriptor.UpdateDescriptorSets();
+    // The command buffer of each image binds the matrices of its image.
+    m_MainPassDescriptors.clear();
+    m_MainPassDescriptors.reserve(m_Swapchain.GetImageCount());
+    for (uint32_t i = 0; i < m_Swapchain.GetImageCount(); ++i)
+    {
+        olp::DescriptorSet &descriptor = m_MainPassDescriptors.emplace_back(m_Device);
+        descriptor.AllocateDescriptorSets(m_PipelineLayout.GetDescriptorLayout(), m_DescriptorPool);
+        descriptor.AddWriteDescriptor(0, m_UniformBuffers.Model[i]);
+        descriptor.AddWriteDescriptor(1, m_UniformBuffers.Camera[i]);
+        descriptor.AddWriteDescriptor(2, m_UniformBuffers.Lighting);
+        descriptor.AddWriteDescriptor(3, m_UniformBuffers.PointSize);
+        descriptor.AddWriteDescriptor(4, m_UniformBuffers.CloudTransforms[i]);
+        descriptor.UpdateDescriptorSets();
+    }
 
     m_GradientPassDescriptor.AllocateDescriptorSets(m_GradientPipelineLayout.GetDescriptorLayout(), m_DescriptorPool);
     m_GradientPassDescriptor.AddWriteDescriptor(0, m_UniformBuffers.ScreenSize);
@@ -347,6 +548,18 @@ void Renderer::CreatePipelines()
         m_Swapchain.GetImageSize().width,
         m_Swapchain.GetImageSize().height,
         1);
+
+    if (m_PointRasterizer)
+    {
+        m_ResolvePipeline.Create(
+            m_PointRasterizer->GetResolvePipelineLayout(),
+            m_RenderPass,
+            1,
+            folder / "resolve",
+            m_Swapchain.GetImageSize().width,
+            m_Swapchain.GetImageSize().height,
+            2);
+    }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -404,7 +617,8 @@ void Renderer::CreateRenderPass()
     // VertexIndex image
     attachments[1].format = m_VertexIndexImage.GetFormat();
     attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
-    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    // Cleared to -1, so the prepare pass only appends the pixels holding a point.
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -486,20 +700,67 @@ void Renderer::CreateRenderPass()
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::CreateCommandBuffers()
 {
+    // The recorded command buffers write the timestamps and the step size of their image.
+    const uint32_t imageCount = m_Swapchain.GetImageCount();
+    if (imageCount > StepCounter::SLOT_COUNT)
+        throw std::runtime_error("too many swapchain images: " + std::to_string(imageCount));
+
     m_CommandBuffers.clear();
-    m_CommandBuffers.reserve(m_Swapchain.GetImageCount());
+    m_CommandBuffers.reserve(imageCount);
 
     for (size_t i = 0; i < m_CommandBuffers.capacity(); ++i)
     {
         m_CommandBuffers.emplace_back(m_Device);
     }
+    m_RecordedCommandBuffers.assign(imageCount, false);
+    m_FinalSubpassCommandBuffers = std::make_unique<SecondaryCommandBuffers>(m_Device, imageCount, GetWorkerCount());
+
+    m_Timestamps = std::make_unique<TimestampQueries>(
+        m_Device, m_Device.GetQueueIndices().graphicsFamily.value(), imageCount * TIMESTAMPS_PER_FRAME);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::InvalidateCommandBuffers()
+{
+    m_Convergence.Reset();
+    std::fill(m_RecordedCommandBuffers.begin(), m_RecordedCommandBuffers.end(), false);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::BuildCommandBuffer(uint32_t iIndex)
 {
+    // The acquisition of a cloud is recorded once, and the out-of-core steps depend on the resident chunks.
+    const bool reusable = m_CommandBufferReuse && !m_OptiCloud->IsOutOfCore() && !m_OptiCloud->IsAcquirePending();
+
     olp::CommandBuffer &commandBuffer = m_CommandBuffers[iIndex];
-    commandBuffer.Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    commandBuffer.Begin(reusable ? 0 : VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    m_OptiCloud->RecordPendingAcquire(commandBuffer.GetBuffer());
+    const uint32_t firstTimestamp = iIndex * TIMESTAMPS_PER_FRAME;
+    m_Timestamps->Reset(commandBuffer.GetBuffer(), firstTimestamp, TIMESTAMPS_PER_FRAME);
+    m_Timestamps->Write(commandBuffer.GetBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, firstTimestamp);
+    // The step sizes are read back from the slot of the image.
+    const uint32_t slot = iIndex;
+    m_OptiCloud->RecordAdvance(commandBuffer.GetBuffer(), slot);
+
+    // The compute rasterization runs before the render pass, its resolve replaces the point draws of the subpass.
+    if (m_PointRasterizer)
+    {
+        m_PointRasterizer->RecordBegin(commandBuffer.GetBuffer(), iIndex);
+        m_Timestamps->Write(commandBuffer.GetBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, firstTimestamp + 1);
+        if (m_OptiCloud->IsOutOfCore())
+        {
+            m_OptiCloud->RecordStep(
+                [this, &commandBuffer](uint32_t iFirst, uint32_t iCount)
+                { m_PointRasterizer->RecordPoints(commandBuffer.GetBuffer(), iFirst, iCount); },
+                slot);
+        }
+        else
+        {
+            m_PointRasterizer->RecordStep(commandBuffer.GetBuffer());
+        }
+        m_Timestamps->Write(commandBuffer.GetBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, firstTimestamp + 2);
+        m_PointRasterizer->RecordEnd(commandBuffer.GetBuffer(), iIndex);
+    }
 
     const VkExtent2D imageSize = m_Swapchain.GetImageSize();
     std::array<VkClearValue, 3> clearValues{};
@@ -532,134 +793,300 @@ void Renderer::BuildCommandBuffer(uint32_t iIndex)
 
     m_Quad->Draw(commandBuffer.GetBuffer());
     vkCmdNextSubpass(commandBuffer.GetBuffer(), VK_SUBPASS_CONTENTS_INLINE);
-    vkCmdBindPipeline(
-        commandBuffer.GetBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_ReprojectedPipeline.GetPipeline());
-
-    vkCmdBindDescriptorSets(
-        commandBuffer.GetBuffer(),
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_PipelineLayout.GetLayout(),
-        0,
-        1,
-        &m_MainPassDescriptor.GetDescriptorSet(),
-        0,
-        nullptr);
-
-    m_OptiCloud->DrawReprojectedBuffer(commandBuffer.GetBuffer());
-
-    vkCmdBindPipeline(
-        commandBuffer.GetBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_OptiCloudPipeline.GetPipeline());
-
-    vkCmdBindDescriptorSets(
-        commandBuffer.GetBuffer(),
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_PipelineLayout.GetLayout(),
-        0,
-        1,
-        &m_MainPassDescriptor.GetDescriptorSet(),
-        0,
-        nullptr);
-
-    m_OptiCloud->DrawVertexBuffer(commandBuffer.GetBuffer());
-
-    vkCmdNextSubpass(commandBuffer.GetBuffer(), VK_SUBPASS_CONTENTS_INLINE);
-
-    vkCmdBindPipeline(commandBuffer.GetBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_MeshPipeline.GetPipeline());
-
-    vkCmdBindDescriptorSets(
-        commandBuffer.GetBuffer(),
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_PipelineLayout.GetLayout(),
-        0,
-        1,
-        &m_MainPassDescriptor.GetDescriptorSet(),
-        0,
-        nullptr);
-
-    for (VkMesh &mesh : m_Meshes)
-        mesh.Draw(commandBuffer.GetBuffer());
-
-    vkCmdBindPipeline(
-        commandBuffer.GetBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_CloudPipeline.GetPipeline());
-
-    vkCmdBindDescriptorSets(
-        commandBuffer.GetBuffer(),
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_PipelineLayout.GetLayout(),
-        0,
-        1,
-        &m_MainPassDescriptor.GetDescriptorSet(),
-        0,
-        nullptr);
+    if (m_PointRasterizer)
+    {
+        vkCmdBindPipeline(commandBuffer.GetBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_ResolvePipeline.GetPipeline());
+        m_PointRasterizer->BindResolveDescriptor(commandBuffer.GetBuffer());
+        m_Quad->Draw(commandBuffer.GetBuffer());
+    }
+    else
+    {
+        vkCmdBindPipeline(
+            commandBuffer.GetBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_ReprojectedPipeline.GetPipeline());
+
+        vkCmdBindDescriptorSets(
+            commandBuffer.GetBuffer(),
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            m_PipelineLayout.GetLayout(),
+            0,
+            1,
+            &m_MainPassDescriptors[iIndex].GetDescriptorSet(),
+            0,
+            nullptr);
+
+        m_OptiCloud->DrawReprojectedBuffer(commandBuffer.GetBuffer());
+
+        vkCmdBindPipeline(
+            commandBuffer.GetBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_OptiCloudPipeline.GetPipeline());
+
+        vkCmdBindDescriptorSets(
+            commandBuffer.GetBuffer(),
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            m_PipelineLayout.GetLayout(),
+            0,
+            1,
+            &m_MainPassDescriptors[iIndex].GetDescriptorSet(),
+            0,
+            nullptr);
+
+        m_Timestamps->Write(commandBuffer.GetBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, firstTimestamp + 1);
+        m_OptiCloud->DrawVertexBuffer(commandBuffer.GetBuffer(), slot);
+        m_Timestamps->Write(commandBuffer.GetBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, firstTimestamp + 2);
+    }
 
-    for (VkCloud &cloud : m_Clouds)
-        cloud.Draw(commandBuffer.GetBuffer());
+    // The meshes and the clouds are recorded in parallel, into secondary command buffers.
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = m_RenderPass;
+    inheritanceInfo.subpass = 2;
+    inheritanceInfo.framebuffer = m_Swapchain.GetFramebuffer(iIndex);
+    const std::vector<VkCommandBuffer> finalCommandBuffers = m_FinalSubpassCommandBuffers->Record(
+        iIndex,
+        inheritanceInfo,
+        static_cast<uint32_t>(m_Meshes.size() + m_Clouds.size()),
+        [this, iIndex](VkCommandBuffer iCommandBuffer, uint32_t iFirst, uint32_t iCount)
+        { RecordFinalSubpassDraws(iCommandBuffer, iIndex, iFirst, iCount); });
+
+    if (finalCommandBuffers.empty())
+    {
+        vkCmdNextSubpass(commandBuffer.GetBuffer(), VK_SUBPASS_CONTENTS_INLINE);
+    }
+    else
+    {
+        vkCmdNextSubpass(commandBuffer.GetBuffer(), VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        vkCmdExecuteCommands(
+            commandBuffer.GetBuffer(), static_cast<uint32_t>(finalCommandBuffers.size()), finalCommandBuffers.data());
+    }
 
     vkCmdEndRenderPass(commandBuffer.GetBuffer());
+    m_Timestamps->Write(commandBuffer.GetBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, firstTimestamp + 3);
 
     commandBuffer.End();
+    m_RecordedCommandBuffers[iIndex] = reusable;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-void Renderer::CreateSyncObjects()
+void Renderer::RecordFinalSubpassDraws(VkCommandBuffer iCommandBuffer, uint32_t iIndex, uint32_t iFirst, uint32_t iCount)
 {
-    m_ImagesInFlight.resize(m_Swapchain.GetImageCount(), VK_NULL_HANDLE);
-
-    VkSemaphoreCreateInfo semaphoreInfo{};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    // The draws are numbered meshes first, then clouds.
+    const uint32_t meshCount = static_cast<uint32_t>(m_Meshes.size());
+    const uint32_t end = iFirst + iCount;
+    if (iFirst < meshCount)
+    {
+        vkCmdBindPipeline(iCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_MeshPipeline.GetPipeline());
+
+        vkCmdBindDescriptorSets(
+            iCommandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            m_PipelineLayout.GetLayout(),
+            0,
+            1,
+            &m_MainPassDescriptors[iIndex].GetDescriptorSet(),
+            0,
+            nullptr);
+
+        for (uint32_t i = iFirst; i < std::min(end, meshCount); ++i)
+            m_Meshes[i].Draw(iCommandBuffer);
+    }
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+    if (end > meshCount)
     {
-        VK_CHECK_RESULT(
-            vkCreateSemaphore(m_Device.GetDevice(), &semaphoreInfo, nullptr, &m_ImageAvailableSemaphores[i]))
-        VK_CHECK_RESULT(
-            vkCreateSemaphore(m_Device.GetDevice(), &semaphoreInfo, nullptr, &m_RenderFinishedSemaphores[i]))
-        VK_CHECK_RESULT(vkCreateFence(m_Device.GetDevice(), &fenceInfo, nullptr, &m_InFlightFences[i]))
+        vkCmdBindPipeline(iCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_CloudPipeline.GetPipeline());
+
+        vkCmdBindDescriptorSets(
+            iCommandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            m_PipelineLayout.GetLayout(),
+            0,
+            1,
+            &m_MainPassDescriptors[iIndex].GetDescriptorSet(),
+            0,
+            nullptr);
+
+        for (uint32_t i = std::max(iFirst, meshCount); i < end; ++i)
+            m_Clouds[i - meshCount].Draw(iCommandBuffer);
     }
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::CreateSyncObjects()
+{
+    m_FrameScheduler = std::make_unique<FrameScheduler>(m_Device, m_FramesInFlight);
+    m_FrameImages.assign(m_FramesInFlight, 0);
+    // The changed pixel count is read as many frames late as there are frames in flight.
+    m_Convergence.SetFramesInFlight(m_FramesInFlight);
+    m_OverlapStats = OverlapStats{};
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::Enable3PointLighting(bool iEnabled)
 {
     m_UniformBuffers.Lighting.SendData(&iEnabled, sizeof(bool), offsetof(Lighting, ThreePointEnabled));
+    m_Convergence.Reset();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::SetLightColor(const glm::vec3 &iLightColor)
 {
     m_UniformBuffers.Lighting.SendData(&iLightColor, sizeof(glm::vec3), offsetof(Lighting, Color));
+    m_Convergence.Reset();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::SetLightIntensity(float iIntensity)
 {
     m_UniformBuffers.Lighting.SendData(&iIntensity, sizeof(float), offsetof(Lighting, Intensity));
+    m_Convergence.Reset();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::UpdatePointSize(uint32_t iPointSize)
 {
     m_UniformBuffers.PointSize.SendData(&iPointSize, sizeof(iPointSize));
+    m_Convergence.Reset();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::UpdatePointsByStep(uint32_t iPointCount)
 {
+    m_StepController.SetTarget(0.0);
     m_OptiCloud->SetPointsByStep(iPointCount);
+    m_Convergence.Reset();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::SetFrameTimeTarget(float iMilliseconds)
+{
+    m_StepController.SetTarget(iMilliseconds);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::SetPointRasterization(PointRasterization iRasterization)
+{
+    if (iRasterization == PointRasterization::Compute && !PointRasterizer::IsSupported(m_Device))
+    {
+        std::cerr << "The compute rasterizer is not built or the device has no 64-bit buffer atomics, the points stay "
+                     "drawn by the graphics pipeline"
+                  << std::endl;
+        return;
+    }
+    if (iRasterization == m_PointRasterization)
+        return;
+
+    m_PointRasterization = iRasterization;
+    RecreateSwapchainResources(m_Swapchain.GetImageSize().width, m_Swapchain.GetImageSize().height);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::EnableHoleFilling(bool iEnabled)
+{
+    if (iEnabled == m_HoleFilling)
+        return;
+
+    m_HoleFilling = iEnabled;
+    // The pass belongs to the point rasterizer, only created with the compute rasterization.
+    if (m_PointRasterization == PointRasterization::Compute)
+        RecreateSwapchainResources(m_Swapchain.GetImageSize().width, m_Swapchain.GetImageSize().height);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::SetFramesInFlight(uint32_t iFrameCount)
+{
+    iFrameCount = std::max(iFrameCount, 1u);
+    if (iFrameCount == m_FramesInFlight)
+        return;
+
+    // The frames of the old scheduler must be finished before it is destroyed, and the prepare pass has resources per
+    // frame in flight: it is created again with the swapchain resources.
+    vkDeviceWaitIdle(m_Device.GetDevice());
+    m_FramesInFlight = iFrameCount;
+    CreateSyncObjects();
+    RecreateSwapchainResources(m_Swapchain.GetImageSize().width, m_Swapchain.GetImageSize().height);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::EnableCommandBufferReuse(bool iEnabled)
+{
+    m_CommandBufferReuse = iEnabled;
+    InvalidateCommandBuffers();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::UpdateStepSize(uint32_t iIndex)
+{
+    // The last frame drawn to this image is finished, and so is the last frame of the current slot.
+    const uint32_t drawnPointCount = m_OptiCloud->TakeStepPointCount(iIndex);
+    const uint32_t firstTimestamp = iIndex * TIMESTAMPS_PER_FRAME;
+    double frameMilliseconds = 0.0;
+    double drawMilliseconds = 0.0;
+    double prepareMilliseconds = 0.0;
+    if (drawnPointCount == 0 || !m_Timestamps->GetMilliseconds(firstTimestamp, firstTimestamp + 3, frameMilliseconds)
+        || !m_Timestamps->GetMilliseconds(firstTimestamp + 1, firstTimestamp + 2, drawMilliseconds))
+        return;
+    m_PreparePass.GetDuration(m_FrameScheduler->GetSlot(), prepareMilliseconds);
+
+    m_OptiCloud->SetPointsByStep(m_StepController.Update(
+        m_OptiCloud->GetPointsByStep(), drawnPointCount, frameMilliseconds + prepareMilliseconds, drawMilliseconds));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::EnableOverlapReport(bool iEnabled)
+{
+    m_OverlapReport = iEnabled;
+    m_OverlapStats = OverlapStats{};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Renderer::UpdatePrepareOverlap()
+{
+    if (!m_OverlapReport)
+        return;
+
+    // The last graphics frame of this slot is finished, and so is the prepare pass it waited for, whose times were
+    // read by the previous call. The prepare pass of this slot is paired with the next graphics frame.
+    const uint32_t frame = m_FrameScheduler->GetSlot();
+    const uint32_t firstTimestamp = m_FrameImages[frame] * TIMESTAMPS_PER_FRAME;
+    double frameBegin = 0.0;
+    double frameEnd = 0.0;
+    if (m_FrameImages[frame] < m_Swapchain.GetImageCount() && m_OverlapStats.HasPrepareTimes
+        && m_Timestamps->GetTime(firstTimestamp, frameBegin) && m_Timestamps->GetTime(firstTimestamp + 3, frameEnd))
+    {
+        const double overlap = std::min(m_OverlapStats.PrepareEnd, frameEnd) - std::max(m_OverlapStats.PrepareBegin, frameBegin);
+        m_OverlapStats.Prepare += m_OverlapStats.PrepareEnd - m_OverlapStats.PrepareBegin;
+        m_OverlapStats.Overlap += std::max(overlap, 0.0);
+        m_OverlapStats.HostWait += m_FrameScheduler->GetLastWaitMilliseconds();
+        m_OverlapStats.FrameCount++;
+    }
+    m_OverlapStats.HasPrepareTimes = m_PreparePass.GetTimes(frame, m_OverlapStats.PrepareBegin, m_OverlapStats.PrepareEnd);
+
+    if (m_OverlapStats.FrameCount < OVERLAP_REPORT_FRAMES)
+        return;
+    const double frameCount = m_OverlapStats.FrameCount;
+    std::cout << "Prepare pass: " << m_OverlapStats.Prepare / frameCount << " ms, overlapped by the next frame for "
+              << m_OverlapStats.Overlap / frameCount << " ms, host blocked for " << m_OverlapStats.HostWait / frameCount
+              << " ms" << std::endl;
+    m_OverlapStats = OverlapStats{};
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void Renderer::DrawNextFrame(const glm::mat4 &iView, const glm::mat4 &iProj)
 {
-    m_PreparePass.WaitFence();
-    vkWaitForFences(m_Device.GetDevice(), 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+    // A converged image stays presented: nothing is submitted until the view changes or a cloud is loaded.
+    if (m_Convergence.IsConverged())
+    {
+        if (iView == m_ConvergedView && iProj == m_ConvergedProj && !m_CloudReader.valid() && !m_LoadingCloud)
+            return;
+        m_Convergence.Reset();
+    }
+
+    // Only the frame that last used this slot is waited: the prepare pass of the previous frame may still run, the
+    // graphics submission waits for it on the device.
+    m_FrameScheduler->BeginFrame();
+    const uint32_t frame = m_FrameScheduler->GetSlot();
+    UpdatePrepareOverlap();
 
     uint32_t imageIndex;
-    VkResult result = m_Swapchain.GetNextImage(m_ImageAvailableSemaphores[m_CurrentFrame], imageIndex);
+    VkResult result = m_Swapchain.GetNextImage(m_FrameScheduler->GetImageAvailableSemaphore(), imageIndex);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
@@ -671,20 +1098,48 @@ void Renderer::DrawNextFrame(const glm::mat4 &iView, const glm::mat4 &iProj)
         throw std::runtime_error("failed to acquire swap chain image!");
     }
 
-    // Check if a previous frame is using this image (i.e. there is its fence to wait on)
-    if (m_ImagesInFlight[imageIndex] != VK_NULL_HANDLE)
+    // Wait for the last frame drawn to this image, if it is still in flight, and mark the image as used by this frame.
+    m_FrameScheduler->WaitFrame(m_ImageFrames[imageIndex]);
+    m_ImageFrames[imageIndex] = m_FrameScheduler->GetFrame();
+    m_FrameImages[frame] = imageIndex;
+    UpdateStepSize(imageIndex);
+
+    UpdateCloudLoading();
+    // The copies refilling the slots of an out-of-core cloud wait for the previous prepare pass, which may still read
+    // them: the frame then waits for the copies in its place.
+    VkSemaphore prepareSemaphore = m_PreparePass.TakeFinishedSemaphore();
+    UpdateCloudStreaming(prepareSemaphore);
+    // The camera motion decides which points the step draws.
+    const CameraMotion motion = UpdateUniformBuffers(iView, iProj, imageIndex, frame);
+
+    // The pixel count comes from the prepare pass of the previous frame, finished above.
+    const VkExtent2D imageSize = m_Swapchain.GetImageSize();
+    const bool drawComplete = m_OptiCloud->IsDrawComplete() && !m_CloudReader.valid() && !m_LoadingCloud;
+    m_Convergence.Update(
+        m_PreparePass.GetChangedPixelCount(frame), imageSize.width * imageSize.height, motion == CameraMotion::Still, drawComplete);
+    m_ConvergedView = iView;
+    m_ConvergedProj = iProj;
+    if (!m_RecordedCommandBuffers[imageIndex])
+        BuildCommandBuffer(imageIndex);
+
+    std::vector<VkPipelineStageFlags> waitStages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    std::vector<VkSemaphore> waitSemaphores = {m_FrameScheduler->GetImageAvailableSemaphore()};
+    // The first frame drawing a cloud uploaded in the background also waits for its last copy.
+    if (m_CloudUploadSemaphore != VK_NULL_HANDLE)
     {
-        vkWaitForFences(m_Device.GetDevice(), 1, &m_ImagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+        waitStages.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        waitSemaphores.push_back(m_CloudUploadSemaphore);
     }
-    // Mark the image as now being in use by this frame
-    m_ImagesInFlight[imageIndex] = m_InFlightFences[m_CurrentFrame];
-
-    BuildCommandBuffer(imageIndex);
-    UpdateUniformBuffers(iView, iProj);
-
-    std::array<VkPipelineStageFlags, 1> waitStages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    std::array<VkSemaphore, 1> waitSemaphores = {m_ImageAvailableSemaphores[m_CurrentFrame]};
-    std::array<VkSemaphore, 1> signalSemaphores = {m_PreparePass.GetSemaphore()};
+    // The previous prepare pass fills the reprojected buffer and its draw command, and reads the vertex index image.
+    // Everything from the indirect commands on waits for it, the commands before overlap it.
+    if (prepareSemaphore != VK_NULL_HANDLE)
+    {
+        waitStages.push_back(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+        waitSemaphores.push_back(prepareSemaphore);
+    }
+    std::array<VkSemaphore, 1> signalSemaphores = {m_PreparePass.GetSemaphore(frame)};
+    // The previous frame of the image is finished: the advance of its slot reads the requests of this frame.
+    m_OptiCloud->CommitStep(imageIndex);
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -696,13 +1151,14 @@ void Renderer::DrawNextFrame(const glm::mat4 &iView, const glm::mat4 &iProj)
     submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
     submitInfo.pSignalSemaphores = signalSemaphores.data();
 
-    vkResetFences(m_Device.GetDevice(), 1, &m_InFlightFences[m_CurrentFrame]);
-    VK_CHECK_RESULT(
-        vkQueueSubmit(m_Device.GetGraphicsQueue(), 1, &submitInfo, m_InFlightFences[m_CurrentFrame]))
+    VK_CHECK_RESULT(vkQueueSubmit(
+        m_Device.GetGraphicsQueue(), 1, &submitInfo, m_FrameScheduler->Submit(FrameScheduler::Queue::Graphics)))
+    m_FrameScheduler->RetireSemaphore(std::exchange(m_CloudUploadSemaphore, VK_NULL_HANDLE));
 
-    m_PreparePass.Process(m_PreparePass.GetSemaphore(), m_RenderFinishedSemaphores[m_CurrentFrame]);
+    VkSemaphore renderFinishedSemaphore = m_FrameScheduler->GetRenderFinishedSemaphore();
+    m_PreparePass.Process(frame, renderFinishedSemaphore, m_FrameScheduler->Submit(FrameScheduler::Queue::Compute));
 
-    result = m_Swapchain.PresentNextImage(&m_RenderFinishedSemaphores[m_CurrentFrame], imageIndex);
+    result = m_Swapchain.PresentNextImage(&renderFinishedSemaphore, imageIndex);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
     {
@@ -713,8 +1169,6 @@ void Renderer::DrawNextFrame(const glm::mat4 &iView, const glm::mat4 &iProj)
         throw std::runtime_error("failed to present swap chain image!");
     }
 
-    m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
-
     //	m_VulkanWindow->frameReady();
     //	m_VulkanWindow->requestUpdate();
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "StepController.h"
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t StepController::Update(uint32_t iStepPointCount, uint32_t iDrawnPointCount, double iFrameMilliseconds, double iDrawMilliseconds)
+{
+    if (!IsEnabled() || iDrawnPointCount == 0)
+        return iStepPointCount;
+
+    const double pointCost = iDrawMilliseconds / iDrawnPointCount;
+    const double fixedCost = std::max(iFrameMilliseconds - iDrawMilliseconds, 0.0);
+    if (m_PointCost < 0.0)
+    {
+        m_PointCost = pointCost;
+        m_FixedCost = fixedCost;
+    }
+    else
+    {
+        m_PointCost += SMOOTHING * (pointCost - m_PointCost);
+        m_FixedCost += SMOOTHING * (fixedCost - m_FixedCost);
+    }
+
+    const double predicted = m_FixedCost + m_PointCost * iStepPointCount;
+    if (std::abs(predicted - m_Target) <= HYSTERESIS * m_Target)
+        return iStepPointCount;
+
+    // Aim inside the band rather than at its edge, so the next frame does not leave it again.
+    const double budget = std::max(m_Target * (1.0 - 0.5 * HYSTERESIS) - m_FixedCost, 0.0);
+    double pointCount = m_PointCost > 0.0 ? budget / m_PointCost : 2.0 * iStepPointCount;
+    pointCount = std::clamp(pointCount, 0.5 * iStepPointCount, 2.0 * iStepPointCount);
+    pointCount = std::clamp(pointCount, static_cast<double>(MIN_POINT_COUNT), static_cast<double>(MAX_POINT_COUNT));
+    return static_cast<uint32_t>(pointCount);
+}
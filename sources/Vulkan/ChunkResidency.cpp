@@ -0,0 +1,122 @@
+#include "Vulkan/ChunkResidency.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+ChunkResidency::ChunkResidency(
+    const olp::Device &iDevice,
+    std::unique_ptr<CloudReader> iReader,
+    VkBuffer iDstBuffer,
+    uint32_t iSlotCount,
+    uint32_t *iResidentSlots)
+    : m_Streamer(iDevice, std::move(iReader), iDstBuffer),
+      m_Chunks(m_Streamer.GetChunkCount()),
+      m_SlotChunks(iSlotCount, -1),
+      m_ResidentSlots(iResidentSlots)
+{
+    RequestChunks();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ChunkResidency::Update(VkSemaphore &ioPrepareSemaphore)
+{
+    // The copies submitted here were requested by an earlier frame: they wait for the prepare pass which dropped the
+    // points of their slot.
+    for (uint32_t chunk : m_Streamer.Update(ioPrepareSemaphore))
+    {
+        m_Chunks[chunk].Loading = false;
+        m_ResidentSlots[m_Chunks[chunk].Slot] = 1;
+    }
+
+    RequestChunks();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ChunkResidency::RequestChunks()
+{
+    // Request the missing chunks in order, keeping the decoder threads busy without queuing more than they can take.
+    for (uint32_t chunk = 0; chunk < m_Chunks.size() && m_Streamer.GetPendingCount() < m_Streamer.GetSlotCount(); ++chunk)
+    {
+        if (m_Chunks[chunk].Slot >= 0 || m_Chunks[chunk].Drawn)
+            continue;
+
+        const int32_t slot = AcquireSlot();
+        if (slot < 0)
+            break;
+
+        m_SlotChunks[slot] = static_cast<int32_t>(chunk);
+        m_Chunks[chunk].Slot = slot;
+        m_Chunks[chunk].Loading = true;
+        m_Streamer.Request(chunk, static_cast<VkDeviceSize>(slot) * ChunkStreamer::CHUNK_SIZE * sizeof(OptiCloudVertex));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+int32_t ChunkResidency::AcquireSlot()
+{
+    int32_t victim = -1;
+    for (size_t slot = 0; slot < m_SlotChunks.size(); ++slot)
+    {
+        const int32_t chunk = m_SlotChunks[slot];
+        if (chunk < 0)
+            return static_cast<int32_t>(slot);
+
+        // Chunks not drawn yet in this pass (the current one included) are kept.
+        if (!m_Chunks[chunk].Drawn || m_Chunks[chunk].Loading)
+            continue;
+        if (victim < 0 || m_Chunks[chunk].LastDrawn < m_Chunks[m_SlotChunks[victim]].LastDrawn)
+            victim = static_cast<int32_t>(slot);
+    }
+
+    // The next prepare pass drops the points of the slot, a pass still running may already do it.
+    if (victim >= 0)
+    {
+        m_Chunks[m_SlotChunks[victim]].Slot = -1;
+        m_ResidentSlots[victim] = 0;
+    }
+    return victim;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ChunkResidency::ResetPass()
+{
+    for (Chunk &chunk : m_Chunks)
+        chunk.Drawn = false;
+    m_DrawnChunkCount = 0;
+    m_CurrentChunk = -1;
+    m_CurrentOffset = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t ChunkResidency::DrawNext(const std::function<void(uint32_t, uint32_t)> &iRecordRange, uint32_t iPointCount)
+{
+    uint32_t drawnCount = 0;
+    while (drawnCount < iPointCount)
+    {
+        if (m_CurrentChunk < 0)
+        {
+            for (size_t chunk = 0; chunk < m_Chunks.size() && m_CurrentChunk < 0; ++chunk)
+            {
+                if (m_Chunks[chunk].Slot >= 0 && !m_Chunks[chunk].Loading && !m_Chunks[chunk].Drawn)
+                    m_CurrentChunk = static_cast<int32_t>(chunk);
+            }
+            if (m_CurrentChunk < 0)
+                break;
+            m_CurrentOffset = 0;
+        }
+
+        Chunk &chunk = m_Chunks[m_CurrentChunk];
+        const uint32_t chunkPointCount = m_Streamer.GetChunkPointCount(m_CurrentChunk);
+        const uint32_t count = std::min(iPointCount - drawnCount, chunkPointCount - m_CurrentOffset);
+        iRecordRange(chunk.Slot * ChunkStreamer::CHUNK_SIZE + m_CurrentOffset, count);
+
+        drawnCount += count;
+        m_CurrentOffset += count;
+        chunk.LastDrawn = ++m_Clock;
+        if (m_CurrentOffset == chunkPointCount)
+        {
+            chunk.Drawn = true;
+            ++m_DrawnChunkCount;
+            m_CurrentChunk = -1;
+        }
+    }
+    return drawnCount;
+}
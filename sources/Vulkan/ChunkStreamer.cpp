@@ -0,0 +1,347 @@
+#include "Vulkan/ChunkStreamer.h"
+#include "Olympus/Debug.h"
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+ChunkStreamer::ChunkStreamer(const olp::Device &iDevice, std::unique_ptr<CloudReader> iReader, VkBuffer iDstBuffer, bool iAsyncQueue)
+    : m_Device(iDevice),
+      m_Reader(std::move(iReader)),
+      m_DstBuffer(iDstBuffer)
+{
+    m_ChunkCount = (m_Reader->GetPointCount() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    // Keep one chunk ahead of each decoder thread so they never wait on the copies.
+    const uint32_t threadCount = std::clamp(std::thread::hardware_concurrency(), 2u, 9u) - 1;
+    m_Slots.resize(std::min(2 * threadCount, std::max(m_ChunkCount, 1u)));
+
+    const VkDeviceSize stagingSize = static_cast<VkDeviceSize>(m_Slots.size()) * CHUNK_SIZE * sizeof(OptiCloudVertex);
+    m_StagingBuffer = m_Device.CreateMemoryBuffer(
+        stagingSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    void *data = nullptr;
+    VK_CHECK_RESULT(vkMapMemory(m_Device.GetDevice(), m_StagingBuffer.Memory, 0, stagingSize, 0, &data))
+    m_StagingData = static_cast<OptiCloudVertex *>(data);
+
+    // The device has no transfer-only queue: the compute queue, asynchronous on most GPUs, is used instead.
+    const olp::Device::QueueFamilyIndices queueIndices = m_Device.GetQueueIndices();
+    m_GraphicsFamily = queueIndices.graphicsFamily.value();
+    m_QueueFamily = iAsyncQueue ? queueIndices.computeFamily.value() : m_GraphicsFamily;
+    m_Queue = iAsyncQueue ? m_Device.GetComputeQueue() : m_Device.GetGraphicsQueue();
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VK_CHECK_RESULT(vkCreateSemaphore(
+        m_Device.GetDevice(), &semaphoreInfo, nullptr, iAsyncQueue ? &m_Semaphore : &m_PrepareSemaphore))
+
+    VkCommandPoolCreateInfo cmdPoolInfo{};
+    cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    cmdPoolInfo.queueFamilyIndex = m_QueueFamily;
+    cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    VK_CHECK_RESULT(vkCreateCommandPool(m_Device.GetDevice(), &cmdPoolInfo, nullptr, &m_CommandPool))
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+        m_Threads.emplace_back(&ChunkStreamer::DecodeLoop, this);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+ChunkStreamer::~ChunkStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WorkAvailable.notify_all();
+    for (std::thread &thread : m_Threads)
+        thread.join();
+
+    for (Submission &submission : m_Submissions)
+    {
+        vkWaitForFences(m_Device.GetDevice(), 1, &submission.Fence, VK_TRUE, UINT64_MAX);
+        vkDestroyFence(m_Device.GetDevice(), submission.Fence, nullptr);
+    }
+    vkDestroyCommandPool(m_Device.GetDevice(), m_CommandPool, nullptr);
+    vkDestroySemaphore(m_Device.GetDevice(), m_Semaphore, nullptr);
+    vkDestroySemaphore(m_Device.GetDevice(), m_PrepareSemaphore, nullptr);
+
+    vkUnmapMemory(m_Device.GetDevice(), m_StagingBuffer.Memory);
+    m_StagingBuffer.Destroy();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t ChunkStreamer::GetChunkPointCount(uint32_t iChunk) const
+{
+    return std::min(CHUNK_SIZE, m_Reader->GetPointCount() - iChunk * CHUNK_SIZE);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ChunkStreamer::Request(uint32_t iChunk, VkDeviceSize iDstOffset)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Requests.emplace_back(iChunk, iDstOffset);
+    }
+    ++m_PendingCount;
+    ++m_RequestedCount;
+    m_WorkAvailable.notify_one();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ChunkStreamer::DecodeLoop()
+{
+    while (true)
+    {
+        uint32_t slot = 0;
+        uint32_t chunk = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            auto freeSlot = m_Slots.end();
+            m_WorkAvailable.wait(lock, [&]()
+                                 {
+                                     freeSlot = std::find_if(m_Slots.begin(), m_Slots.end(), [](const Slot &s) { return s.State == SlotState::Free; });
+                                     return m_Stop || (!m_Requests.empty() && freeSlot != m_Slots.end());
+                                 });
+            if (m_Stop)
+                return;
+
+            chunk = m_Requests.front().first;
+            slot = static_cast<uint32_t>(freeSlot - m_Slots.begin());
+            *freeSlot = {chunk, m_Requests.front().second, SlotState::Decoding};
+            m_Requests.pop_front();
+        }
+
+        std::exception_ptr error;
+        try
+        {
+            m_Reader->ReadPoints(chunk * CHUNK_SIZE, GetChunkPointCount(chunk), m_StagingData + static_cast<size_t>(slot) * CHUNK_SIZE);
+        }
+        catch (...)
+        {
+            // A corrupted or truncated file: the exception is rethrown on the main thread by Update().
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (error && !m_Error)
+            m_Error = error;
+        m_Slots[slot].State = error ? SlotState::Free : SlotState::Decoded;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<uint32_t> ChunkStreamer::Update()
+{
+    VkSemaphore prepareSemaphore = VK_NULL_HANDLE;
+    return Update(prepareSemaphore);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<uint32_t> ChunkStreamer::Update(VkSemaphore &ioPrepareSemaphore)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Error)
+            std::rethrow_exception(m_Error);
+    }
+
+    // Retire the finished copies, they complete in submission order.
+    std::vector<uint32_t> copiedChunks;
+    while (!m_Submissions.empty() && vkGetFenceStatus(m_Device.GetDevice(), m_Submissions.front().Fence) == VK_SUCCESS)
+    {
+        Submission &submission = m_Submissions.front();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (uint32_t slot : submission.Slots)
+            {
+                copiedChunks.push_back(m_Slots[slot].Chunk);
+                m_Slots[slot].State = SlotState::Free;
+            }
+        }
+
+        vkFreeCommandBuffers(m_Device.GetDevice(), m_CommandPool, 1, &submission.CommandBuffer);
+        vkDestroyFence(m_Device.GetDevice(), submission.Fence, nullptr);
+        m_Submissions.pop_front();
+    }
+    if (!copiedChunks.empty())
+    {
+        m_PendingCount -= static_cast<uint32_t>(copiedChunks.size());
+        m_WorkAvailable.notify_all();
+    }
+
+    std::vector<uint32_t> slots;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (uint32_t slot = 0; slot < m_Slots.size(); ++slot)
+        {
+            if (m_Slots[slot].State == SlotState::Decoded)
+            {
+                m_Slots[slot].State = SlotState::Uploading;
+                slots.push_back(slot);
+            }
+        }
+    }
+    if (!slots.empty())
+        Submit(std::move(slots), ioPrepareSemaphore);
+
+    return copiedChunks;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ChunkStreamer::Submit(std::vector<uint32_t> iSlots, VkSemaphore &ioPrepareSemaphore)
+{
+    std::vector<VkBufferCopy> regions;
+    regions.reserve(iSlots.size());
+    for (uint32_t slot : iSlots)
+    {
+        VkBufferCopy region{};
+        region.srcOffset = static_cast<VkDeviceSize>(slot) * CHUNK_SIZE * sizeof(OptiCloudVertex);
+        region.dstOffset = m_Slots[slot].DstOffset;
+        region.size = static_cast<VkDeviceSize>(GetChunkPointCount(m_Slots[slot].Chunk)) * sizeof(OptiCloudVertex);
+        regions.push_back(region);
+    }
+
+    Submission submission;
+    submission.Slots = std::move(iSlots);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_CommandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    VK_CHECK_RESULT(vkAllocateCommandBuffers(m_Device.GetDevice(), &allocInfo, &submission.CommandBuffer))
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(submission.CommandBuffer, &beginInfo))
+
+    m_SubmittedCount += static_cast<uint32_t>(submission.Slots.size());
+    const bool asyncQueue = m_Queue != m_Device.GetGraphicsQueue();
+    const bool lastAsyncCopy = asyncQueue && IsSubmitted();
+
+    // The destination may be a reused slot: wait for the draws and the compute rasterization submitted before on this
+    // queue to stop reading it.
+    if (!asyncQueue)
+    {
+        vkCmdPipelineBarrier(
+            submission.CommandBuffer,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            0,
+            nullptr);
+    }
+
+    vkCmdCopyBuffer(
+        submission.CommandBuffer, m_StagingBuffer.Buffer, m_DstBuffer, static_cast<uint32_t>(regions.size()), regions.data());
+
+    if (!asyncQueue)
+    {
+        // Make the copies visible to the draws and to the prepare pass submitted after the fence is seen.
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(
+            submission.CommandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+    }
+    else if (lastAsyncCopy && m_QueueFamily != m_GraphicsFamily)
+    {
+        // Release the whole buffer to the graphics family, the barrier also covers the copies submitted before.
+        VkBufferMemoryBarrier release{};
+        release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        release.dstAccessMask = 0;
+        release.srcQueueFamilyIndex = m_QueueFamily;
+        release.dstQueueFamilyIndex = m_GraphicsFamily;
+        release.buffer = m_DstBuffer;
+        release.offset = 0;
+        release.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(
+            submission.CommandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0,
+            nullptr,
+            1,
+            &release,
+            0,
+            nullptr);
+    }
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(submission.CommandBuffer))
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VK_CHECK_RESULT(vkCreateFence(m_Device.GetDevice(), &fenceInfo, nullptr, &submission.Fence))
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &submission.CommandBuffer;
+    if (lastAsyncCopy)
+    {
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &m_Semaphore;
+    }
+
+    // The prepare pass reads the points of the reprojected pixels on the compute queue: the copies wait for the last
+    // one, and the next graphics submission waits for the copies instead.
+    const VkPipelineStageFlags prepareWaitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    const VkSemaphore prepareSemaphore = ioPrepareSemaphore;
+    if (!asyncQueue && prepareSemaphore != VK_NULL_HANDLE)
+    {
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &prepareSemaphore;
+        submitInfo.pWaitDstStageMask = &prepareWaitStage;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &m_PrepareSemaphore;
+        ioPrepareSemaphore = m_PrepareSemaphore;
+    }
+    VK_CHECK_RESULT(vkQueueSubmit(m_Queue, 1, &submitInfo, submission.Fence))
+
+    m_Submissions.push_back(std::move(submission));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ChunkStreamer::RecordAcquire(VkCommandBuffer iCommandBuffer) const
+{
+    if (m_QueueFamily == m_GraphicsFamily)
+        return;
+
+    // The frame waits on the semaphore at the stages reading the points, which are the source stages of the acquisition.
+    VkBufferMemoryBarrier acquire{};
+    acquire.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    acquire.srcAccessMask = 0;
+    acquire.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    acquire.srcQueueFamilyIndex = m_QueueFamily;
+    acquire.dstQueueFamilyIndex = m_GraphicsFamily;
+    acquire.buffer = m_DstBuffer;
+    acquire.offset = 0;
+    acquire.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(
+        iCommandBuffer,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0,
+        nullptr,
+        1,
+        &acquire,
+        0,
+        nullptr);
+}
@@ -1,12 +1,23 @@
 #include "Vulkan/ComputePass.h"
 #include "Olympus/Debug.h"
-#include "Olympus/Shader.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace
+{
+/// Workgroup size of the prepare pass until it is tuned.
+const WorkgroupSize DEFAULT_WORKGROUP_SIZE{16, 16, 1};
+/// Sizes measured by the tuner, from 32 to 1024 invocations.
+const std::vector<WorkgroupSize> WORKGROUP_CANDIDATES = {
+    {8, 4, 1}, {8, 8, 1}, {16, 8, 1}, {32, 8, 1}, {32, 16, 1}, {32, 32, 1}, {64, 4, 1}};
+} // namespace
 
 //----------------------------------------------------------------------------------------------------------------------
 ComputePass::ComputePass(const olp::Device &iDevice)
     : m_Device(iDevice),
-      m_PipelineLayout(iDevice),
-      m_DescriptorSet(iDevice)
+      m_PipelineLayout(iDevice)
 {
 }
 
@@ -15,9 +26,26 @@ void ComputePass::Destroy()
 {
     m_PipelineLayout.Destroy();
     vkDestroyPipeline(m_Device.GetDevice(), m_Pipeline, nullptr);
-    vkDestroySemaphore(m_Device.GetDevice(), m_Semaphore, nullptr);
+    for (VkPipeline pipeline : m_RetiredPipelines)
+        vkDestroyPipeline(m_Device.GetDevice(), pipeline, nullptr);
+    m_RetiredPipelines.clear();
+    for (Frame &frame : m_Frames)
+    {
+        vkDestroySemaphore(m_Device.GetDevice(), frame.Semaphore, nullptr);
+        vkDestroySemaphore(m_Device.GetDevice(), frame.FinishedSemaphore, nullptr);
+    }
+    m_Frames.clear();
+    // Freed with the descriptor pool.
+    m_DescriptorSets.clear();
+    m_PendingSemaphore = VK_NULL_HANDLE;
     vkDestroyCommandPool(m_Device.GetDevice(), m_CommandPool, nullptr);
-    vkDestroyFence(m_Device.GetDevice(), m_Fence, nullptr);
+    m_Timestamps.reset();
+    if (m_ChangedPixelCounts)
+        vkUnmapMemory(m_Device.GetDevice(), m_ReadbackBuffer.Memory);
+    m_ChangedPixelCounts = nullptr;
+    m_ReadbackBuffer.Destroy();
+    m_ConvergenceBuffer.Destroy();
+    m_PreviousIndexBuffer.Destroy();
 }
 //----------------------------------------------------------------------------------------------------------------------
 void ComputePass::Create(
@@ -25,21 +53,73 @@ void ComputePass::Create(
     VkOptiCloud &iOptiCloud,
     VkImageView iVertexIndexImageView,
     olp::UniformBuffer &iScreenSize,
+    std::vector<olp::UniformBuffer> &iCloudTransforms,
     uint32_t iWidth,
-    uint32_t iHeight)
+    uint32_t iHeight,
+    uint32_t iFrameCount)
 {
+    m_Frames.resize(iFrameCount);
+    if (!m_WorkgroupTuner)
+        m_WorkgroupTuner =
+            std::make_unique<WorkgroupTuner>(m_Device, "prepare", DEFAULT_WORKGROUP_SIZE, WORKGROUP_CANDIDATES);
     CreatePipelineLayout();
-    CreateDescriptor(iDescriptorPool, iOptiCloud, iVertexIndexImageView, iScreenSize);
+    CreateConvergenceBuffers(iWidth, iHeight);
+    CreateDescriptor(iDescriptorPool, iOptiCloud, iVertexIndexImageView, iScreenSize, iCloudTransforms);
     CreatePipeline();
     CreateCommandPoolAndBuffer();
+    // Without timestamps, the sizes can not be compared.
+    if (!m_Timestamps->IsSupported())
+        m_WorkgroupTuner->Cancel();
     CreateSemaphore();
     BuildCommandBuffer(iWidth, iHeight);
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+void ComputePass::UpdateCloud(VkOptiCloud &iOptiCloud, uint32_t iWidth, uint32_t iHeight)
+{
+    VkDescriptorBufferInfo vertexBufferInfo{};
+    vertexBufferInfo.buffer = iOptiCloud.GetVertexBuffer().Buffer;
+    vertexBufferInfo.offset = 0;
+    vertexBufferInfo.range = iOptiCloud.GetVertexBufferSize();
+    VkDescriptorBufferInfo reprojectBufferInfo{};
+    reprojectBufferInfo.buffer = iOptiCloud.GetReprojectedBuffer().Buffer;
+    reprojectBufferInfo.offset = 0;
+    reprojectBufferInfo.range = iOptiCloud.GetReprojectedBufferSize();
+    m_ReprojectedDrawBuffer = iOptiCloud.GetReprojectedDrawBuffer().Buffer;
+    VkDescriptorBufferInfo reprojectedDrawBufferInfo{};
+    reprojectedDrawBufferInfo.buffer = m_ReprojectedDrawBuffer;
+    reprojectedDrawBufferInfo.offset = 0;
+    reprojectedDrawBufferInfo.range = sizeof(VkDrawIndirectCommand);
+    VkDescriptorBufferInfo residentSlotBufferInfo{iOptiCloud.GetResidentSlotBuffer().Buffer, 0, VK_WHOLE_SIZE};
+
+    for (const olp::DescriptorSet &descriptorSet : m_DescriptorSets)
+    {
+        std::array<VkWriteDescriptorSet, 4> writes{};
+        for (uint32_t i = 0; i < writes.size(); ++i)
+        {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = descriptorSet.GetDescriptorSet();
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        }
+        writes[0].pBufferInfo = &vertexBufferInfo;
+        writes[1].pBufferInfo = &reprojectBufferInfo;
+        writes[2].dstBinding = 5;
+        writes[2].pBufferInfo = &reprojectedDrawBufferInfo;
+        writes[3].dstBinding = 8;
+        writes[3].pBufferInfo = &residentSlotBufferInfo;
+        vkUpdateDescriptorSets(m_Device.GetDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    // The command buffers are only recorded once, the descriptor sets they bind were just rewritten.
+    BuildCommandBuffer(iWidth, iHeight);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void ComputePass::CreatePipelineLayout()
 {
-    std::vector<VkDescriptorSetLayoutBinding> descriptorBinding(4);
+    std::vector<VkDescriptorSetLayoutBinding> descriptorBinding(9);
 
     // Shuffled buffer.
     descriptorBinding[0].binding = 0;
@@ -69,14 +149,77 @@ void ComputePass::CreatePipelineLayout()
     descriptorBinding[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
     descriptorBinding[3].pImmutableSamplers = nullptr;
 
+    // Cloud transforms
+    descriptorBinding[4].binding = 4;
+    descriptorBinding[4].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    descriptorBinding[4].descriptorCount = 1;
+    descriptorBinding[4].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorBinding[4].pImmutableSamplers = nullptr;
+
+    // Indirect draw of the reprojected buffer
+    descriptorBinding[5].binding = 5;
+    descriptorBinding[5].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorBinding[5].descriptorCount = 1;
+    descriptorBinding[5].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorBinding[5].pImmutableSamplers = nullptr;
+
+    // Vertex indices of the previous pass
+    descriptorBinding[6].binding = 6;
+    descriptorBinding[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorBinding[6].descriptorCount = 1;
+    descriptorBinding[6].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorBinding[6].pImmutableSamplers = nullptr;
+
+    // Changed pixel count
+    descriptorBinding[7].binding = 7;
+    descriptorBinding[7].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorBinding[7].descriptorCount = 1;
+    descriptorBinding[7].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorBinding[7].pImmutableSamplers = nullptr;
+
+    // Resident slots of the vertex buffer
+    descriptorBinding[8].binding = 8;
+    descriptorBinding[8].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorBinding[8].descriptorCount = 1;
+    descriptorBinding[8].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorBinding[8].pImmutableSamplers = nullptr;
+
     m_PipelineLayout.Create(descriptorBinding);
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+void ComputePass::CreateConvergenceBuffers(uint32_t iWidth, uint32_t iHeight)
+{
+    m_PreviousIndexBuffer = m_Device.CreateMemoryBuffer(
+        static_cast<VkDeviceSize>(iWidth) * iHeight * sizeof(int32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    m_ConvergenceBuffer = m_Device.CreateMemoryBuffer(
+        sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    const VkDeviceSize readbackSize = m_Frames.size() * sizeof(uint32_t);
+    m_ReadbackBuffer = m_Device.CreateMemoryBuffer(
+        readbackSize,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    void *data = nullptr;
+    VK_CHECK_RESULT(vkMapMemory(m_Device.GetDevice(), m_ReadbackBuffer.Memory, 0, readbackSize, 0, &data))
+    m_ChangedPixelCounts = static_cast<uint32_t *>(data);
+    // Changed until a pass says otherwise.
+    std::fill(m_ChangedPixelCounts, m_ChangedPixelCounts + m_Frames.size(), iWidth * iHeight);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void ComputePass::CreateDescriptor(
-    VkDescriptorPool &iDescriptorPool, VkOptiCloud &iOptiCloud, VkImageView iVertexIndexImageView, olp::UniformBuffer &iScreenSize)
+    VkDescriptorPool &iDescriptorPool,
+    VkOptiCloud &iOptiCloud,
+    VkImageView iVertexIndexImageView,
+    olp::UniformBuffer &iScreenSize,
+    std::vector<olp::UniformBuffer> &iCloudTransforms)
 {
-    m_DescriptorSet.AllocateDescriptorSets(m_PipelineLayout.GetDescriptorLayout(), iDescriptorPool);
     //Vertex Buffer (Shuffled buffer of the cloud)
     VkDescriptorBufferInfo vertexBufferInfo{};
     vertexBufferInfo.buffer = iOptiCloud.GetVertexBuffer().Buffer;
@@ -87,41 +230,53 @@ void ComputePass::CreateDescriptor(
     reprojectBufferInfo.buffer = iOptiCloud.GetReprojectedBuffer().Buffer;
     reprojectBufferInfo.offset = 0;
     reprojectBufferInfo.range = iOptiCloud.GetReprojectedBufferSize();
+    // Indirect draw of the reprojected buffer (vertex count appended by the compute shader).
+    m_ReprojectedDrawBuffer = iOptiCloud.GetReprojectedDrawBuffer().Buffer;
+    VkDescriptorBufferInfo reprojectedDrawBufferInfo{};
+    reprojectedDrawBufferInfo.buffer = m_ReprojectedDrawBuffer;
+    reprojectedDrawBufferInfo.offset = 0;
+    reprojectedDrawBufferInfo.range = sizeof(VkDrawIndirectCommand);
+
+    // Vertex indices of the previous pass and changed pixel count.
+    VkDescriptorBufferInfo previousIndexBufferInfo{m_PreviousIndexBuffer.Buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo convergenceBufferInfo{m_ConvergenceBuffer.Buffer, 0, sizeof(uint32_t)};
+    // Slots of the vertex buffer whose points can be reprojected.
+    VkDescriptorBufferInfo residentSlotBufferInfo{iOptiCloud.GetResidentSlotBuffer().Buffer, 0, VK_WHOLE_SIZE};
 
     // Association Pixel / Vertex with  the indices.
     VkDescriptorImageInfo vertexIndexImageInfo{};
     vertexIndexImageInfo.imageView = iVertexIndexImageView;
     vertexIndexImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-    m_DescriptorSet.AddWriteDescriptor(0, vertexBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
-    m_DescriptorSet.AddWriteDescriptor(1, reprojectBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
-    m_DescriptorSet.AddWriteDescriptor(2, vertexIndexImageInfo, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
-    m_DescriptorSet.AddWriteDescriptor(3, iScreenSize);
-    m_DescriptorSet.UpdateDescriptorSets();
+    // The frames only differ by their copy of the cloud transforms, written while the other frames are in flight.
+    m_DescriptorSets.clear();
+    m_DescriptorSets.reserve(m_Frames.size());
+    for (uint32_t i = 0; i < m_Frames.size(); ++i)
+    {
+        olp::DescriptorSet &descriptorSet = m_DescriptorSets.emplace_back(m_Device);
+        descriptorSet.AllocateDescriptorSets(m_PipelineLayout.GetDescriptorLayout(), iDescriptorPool);
+        descriptorSet.AddWriteDescriptor(0, vertexBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(1, reprojectBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(2, vertexIndexImageInfo, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+        descriptorSet.AddWriteDescriptor(3, iScreenSize);
+        descriptorSet.AddWriteDescriptor(4, iCloudTransforms[i]);
+        descriptorSet.AddWriteDescriptor(5, reprojectedDrawBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(6, previousIndexBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(7, convergenceBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(8, residentSlotBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.UpdateDescriptorSets();
+    }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void ComputePass::CreatePipeline()
 {
-    olp::Shader shader(m_Device);
     std::filesystem::path shaderPath = CLOUD_RENDERING_SHADERS;
     shaderPath /= "prepare_comp.spv";
-    shader.Load(shaderPath);
-
-    VkPipelineShaderStageCreateInfo shaderStageInfo{};
-    shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-    shaderStageInfo.module = shader.GetShaderModule();
-    shaderStageInfo.pName = "main";
-
-    VkComputePipelineCreateInfo pipelineCreateInfo;
-    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-    pipelineCreateInfo.layout = m_PipelineLayout.GetLayout();
-    pipelineCreateInfo.flags = 0;
-    pipelineCreateInfo.stage = shaderStageInfo;
-    pipelineCreateInfo.pNext = nullptr;
-    VK_CHECK_RESULT(vkCreateComputePipelines(
-        m_Device.GetDevice(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &m_Pipeline))
+    m_PipelineSize = m_WorkgroupTuner->GetSize();
+    // The prepare pass finds the resident slot of a vertex from the size of the chunks.
+    m_Pipeline = WorkgroupTuner::CreatePipeline(
+        m_Device, m_PipelineLayout.GetLayout(), shaderPath, m_PipelineSize, {ChunkStreamer::CHUNK_SIZE});
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -135,80 +290,192 @@ void ComputePass::CreateCommandPoolAndBuffer()
     VK_CHECK_RESULT(
         vkCreateCommandPool(m_Device.GetDevice(), &cmdPoolInfo, nullptr, &m_CommandPool))
 
-    // Create a command buffer for compute operations
+    // Create a command buffer for compute operations, for each frame
     VkCommandBufferAllocateInfo cmdBufAllocateInfo{};
     cmdBufAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     cmdBufAllocateInfo.commandPool = m_CommandPool;
     cmdBufAllocateInfo.commandBufferCount = 1;
     cmdBufAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-    VK_CHECK_RESULT(vkAllocateCommandBuffers(
-        m_Device.GetDevice(), &cmdBufAllocateInfo, &m_CommandBuffer))
+    for (Frame &frame : m_Frames)
+        VK_CHECK_RESULT(vkAllocateCommandBuffers(m_Device.GetDevice(), &cmdBufAllocateInfo, &frame.CommandBuffer))
+
+    m_Timestamps = std::make_unique<TimestampQueries>(
+        m_Device, queueFamilyIndices.computeFamily.value(), 2 * static_cast<uint32_t>(m_Frames.size()));
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void ComputePass::CreateSemaphore()
 {
-    // Semaphore for compute & graphics sync
+    // Semaphores for compute & graphics sync
     VkSemaphoreCreateInfo semaphoreCreateInfo{};
     semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VK_CHECK_RESULT(vkCreateSemaphore(
-        m_Device.GetDevice(), &semaphoreCreateInfo, nullptr, &m_Semaphore))
-
-    VkFenceCreateInfo fenceCreateInfo{};
-    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    VK_CHECK_RESULT(vkCreateFence(m_Device.GetDevice(), &fenceCreateInfo, nullptr, &m_Fence))
+    for (Frame &frame : m_Frames)
+    {
+        VK_CHECK_RESULT(vkCreateSemaphore(m_Device.GetDevice(), &semaphoreCreateInfo, nullptr, &frame.Semaphore))
+        VK_CHECK_RESULT(vkCreateSemaphore(m_Device.GetDevice(), &semaphoreCreateInfo, nullptr, &frame.FinishedSemaphore))
+    }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void ComputePass::BuildCommandBuffer(uint32_t iWidth, uint32_t iHeight)
 {
+    m_Width = iWidth;
+    m_Height = iHeight;
+    for (uint32_t i = 0; i < m_Frames.size(); ++i)
+        RecordCommandBuffer(i);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ComputePass::RecordCommandBuffer(uint32_t iFrame)
+{
+    Frame &frame = m_Frames[iFrame];
+    VkCommandBuffer commandBuffer = frame.CommandBuffer;
     VkCommandBufferBeginInfo cmdBufInfo{};
     cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    VK_CHECK_RESULT(vkBeginCommandBuffer(m_CommandBuffer, &cmdBufInfo))
-    vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &cmdBufInfo))
+    m_Timestamps->Reset(commandBuffer, 2 * iFrame, 2);
+
+    // The shader appends the visible points and counts the changed pixels from zero.
+    vkCmdFillBuffer(commandBuffer, m_ReprojectedDrawBuffer, offsetof(VkDrawIndirectCommand, vertexCount), sizeof(uint32_t), 0);
+    vkCmdFillBuffer(commandBuffer, m_ConvergenceBuffer.Buffer, 0, sizeof(uint32_t), 0);
+    VkMemoryBarrier resetBarrier{};
+    resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &resetBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+    // Written once the semaphore wait is over, so the duration is the cost of the pass, not the wait for the frame.
+    m_Timestamps->Write(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 2 * iFrame);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
     // Bind descriptor here.
     vkCmdBindDescriptorSets(
-        m_CommandBuffer,
+        commandBuffer,
         VK_PIPELINE_BIND_POINT_COMPUTE,
         m_PipelineLayout.GetLayout(),
         0,
         1,
-        &m_DescriptorSet.GetDescriptorSet(),
+        &m_DescriptorSets[iFrame].GetDescriptorSet(),
         0,
         nullptr);
 
-    uint32_t x = static_cast<uint32_t>(std::ceil(static_cast<double>(iWidth) / 16.0));
-    uint32_t y = static_cast<uint32_t>(std::ceil(static_cast<double>(iHeight) / 16.0));
+    vkCmdDispatch(
+        commandBuffer,
+        WorkgroupSize::GetGroupCount(m_Width, m_PipelineSize.X),
+        WorkgroupSize::GetGroupCount(m_Height, m_PipelineSize.Y),
+        1);
 
-    vkCmdDispatch(m_CommandBuffer, x, y, 1);
+    // The count of the frame is kept for the host, which reads it once the fence is signaled.
+    VkMemoryBarrier countBarrier{};
+    countBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    countBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    countBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1,
+        &countBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+    VkBufferCopy countCopy{0, iFrame * sizeof(uint32_t), sizeof(uint32_t)};
+    vkCmdCopyBuffer(commandBuffer, m_ConvergenceBuffer.Buffer, m_ReadbackBuffer.Buffer, 1, &countCopy);
 
-    vkEndCommandBuffer(m_CommandBuffer);
+    VkMemoryBarrier hostBarrier{};
+    hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        1,
+        &hostBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+    m_Timestamps->Write(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 2 * iFrame + 1);
+
+    vkEndCommandBuffer(commandBuffer);
+    frame.Size = m_PipelineSize;
+    frame.Executed = false;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-void ComputePass::Process(VkSemaphore iWaitSemaphore, VkSemaphore iSignalSemaphore)
+void ComputePass::UpdateWorkgroupSize(uint32_t iFrame)
 {
-    // Wait for rendering finished
-    VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    Frame &frame = m_Frames[iFrame];
+    double milliseconds = 0.0;
+    if (frame.Executed && !m_WorkgroupTuner->IsTuned() && GetDuration(iFrame, milliseconds))
+        m_WorkgroupTuner->AddSample(frame.Size, milliseconds);
+
+    const WorkgroupSize &size = m_WorkgroupTuner->GetSize();
+    if (frame.Size == size)
+        return;
+    // The other frames in flight may still execute the previous pipeline.
+    if (m_PipelineSize != size)
+    {
+        m_RetiredPipelines.push_back(m_Pipeline);
+        CreatePipeline();
+    }
+    RecordCommandBuffer(iFrame);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ComputePass::Process(uint32_t iFrame, VkSemaphore iSignalSemaphore, VkFence iFence)
+{
+    UpdateWorkgroupSize(iFrame);
+
+    Frame &frame = m_Frames[iFrame];
+    // Wait for rendering finished. The command buffer starts by resetting the vertex count of the reprojected draw,
+    // which the frame reads in its indirect draw or in the compute rasterizer: the transfers wait too.
+    VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    std::array<VkSemaphore, 2> signalSemaphores = {frame.FinishedSemaphore, iSignalSemaphore};
     // Submit compute commands
     VkSubmitInfo computeSubmitInfo{};
     computeSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     computeSubmitInfo.commandBufferCount = 1;
-    computeSubmitInfo.pCommandBuffers = &m_CommandBuffer;
+    computeSubmitInfo.pCommandBuffers = &frame.CommandBuffer;
     computeSubmitInfo.waitSemaphoreCount = 1;
-    computeSubmitInfo.pWaitSemaphores = &iWaitSemaphore;
+    computeSubmitInfo.pWaitSemaphores = &frame.Semaphore;
     computeSubmitInfo.pWaitDstStageMask = &waitStageMask;
-    computeSubmitInfo.signalSemaphoreCount = 1;
-    computeSubmitInfo.pSignalSemaphores = &iSignalSemaphore;
-    vkResetFences(m_Device.GetDevice(), 1, &m_Fence);
-    VK_CHECK_RESULT(vkQueueSubmit(m_Device.GetComputeQueue(), 1, &computeSubmitInfo, m_Fence))
+    computeSubmitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+    computeSubmitInfo.pSignalSemaphores = signalSemaphores.data();
+    VK_CHECK_RESULT(vkQueueSubmit(m_Device.GetComputeQueue(), 1, &computeSubmitInfo, iFence))
+    frame.Executed = true;
+    m_PendingSemaphore = frame.FinishedSemaphore;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+VkSemaphore ComputePass::TakeFinishedSemaphore()
+{
+    return std::exchange(m_PendingSemaphore, VK_NULL_HANDLE);
 }
 
-void ComputePass::WaitFence()
+//----------------------------------------------------------------------------------------------------------------------
+bool ComputePass::GetDuration(uint32_t iFrame, double &oMilliseconds) const
 {
-    // Wait for fence to ensure that compute buffer writes have finished
-    vkWaitForFences(m_Device.GetDevice(), 1, &m_Fence, VK_TRUE, UINT64_MAX);
-}
\ No newline at end of file
+    return m_Timestamps && m_Timestamps->GetMilliseconds(2 * iFrame, 2 * iFrame + 1, oMilliseconds);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool ComputePass::GetTimes(uint32_t iFrame, double &oBegin, double &oEnd) const
+{
+    return m_Timestamps && m_Timestamps->GetTime(2 * iFrame, oBegin) && m_Timestamps->GetTime(2 * iFrame + 1, oEnd);
+}
@@ -0,0 +1,99 @@
+#include "Vulkan/FrameScheduler.h"
+#include "Olympus/Debug.h"
+#include <algorithm>
+#include <chrono>
+
+//----------------------------------------------------------------------------------------------------------------------
+FrameScheduler::FrameScheduler(const olp::Device &iDevice, uint32_t iFrameCount)
+    : m_Device(iDevice),
+      m_Slots(std::max(iFrameCount, 1u))
+{
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (Slot &slot : m_Slots)
+    {
+        VK_CHECK_RESULT(vkCreateSemaphore(m_Device.GetDevice(), &semaphoreInfo, nullptr, &slot.ImageAvailable))
+        VK_CHECK_RESULT(vkCreateSemaphore(m_Device.GetDevice(), &semaphoreInfo, nullptr, &slot.RenderFinished))
+        for (VkFence &fence : slot.Fences)
+            VK_CHECK_RESULT(vkCreateFence(m_Device.GetDevice(), &fenceInfo, nullptr, &fence))
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+FrameScheduler::~FrameScheduler()
+{
+    for (Slot &slot : m_Slots)
+    {
+        vkDestroySemaphore(m_Device.GetDevice(), slot.ImageAvailable, nullptr);
+        vkDestroySemaphore(m_Device.GetDevice(), slot.RenderFinished, nullptr);
+        for (VkFence fence : slot.Fences)
+            vkDestroyFence(m_Device.GetDevice(), fence, nullptr);
+        for (VkSemaphore semaphore : slot.RetiredSemaphores)
+            vkDestroySemaphore(m_Device.GetDevice(), semaphore, nullptr);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t FrameScheduler::BeginFrame()
+{
+    ++m_Frame;
+    Slot &slot = m_Slots[GetSlot()];
+
+    const auto begin = std::chrono::steady_clock::now();
+    WaitFrame(slot.Frame);
+    m_LastWaitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    for (VkSemaphore semaphore : slot.RetiredSemaphores)
+        vkDestroySemaphore(m_Device.GetDevice(), semaphore, nullptr);
+    slot.RetiredSemaphores.clear();
+    return m_Frame;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void FrameScheduler::WaitFrame(uint64_t iFrame)
+{
+    if (iFrame <= m_FinishedFrame)
+        return;
+
+    // A slot reused by a later frame was waited before, a frame never submitted has nothing to wait for.
+    Slot &slot = m_Slots[iFrame % m_Slots.size()];
+    if (slot.Frame != iFrame)
+        return;
+
+    vkWaitForFences(
+        m_Device.GetDevice(), static_cast<uint32_t>(slot.Fences.size()), slot.Fences.data(), VK_TRUE, UINT64_MAX);
+    m_FinishedFrame = iFrame;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void FrameScheduler::WaitIdle()
+{
+    for (const Slot &slot : m_Slots)
+    {
+        vkWaitForFences(
+            m_Device.GetDevice(), static_cast<uint32_t>(slot.Fences.size()), slot.Fences.data(), VK_TRUE, UINT64_MAX);
+        m_FinishedFrame = std::max(m_FinishedFrame, slot.Frame);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+VkFence FrameScheduler::Submit(Queue iQueue)
+{
+    Slot &slot = m_Slots[GetSlot()];
+    slot.Frame = m_Frame;
+    VkFence fence = slot.Fences[static_cast<size_t>(iQueue)];
+    vkResetFences(m_Device.GetDevice(), 1, &fence);
+    return fence;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void FrameScheduler::RetireSemaphore(VkSemaphore iSemaphore)
+{
+    if (iSemaphore != VK_NULL_HANDLE)
+        m_Slots[GetSlot()].RetiredSemaphores.push_back(iSemaphore);
+}
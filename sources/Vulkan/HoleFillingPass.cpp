@@ -0,0 +1,245 @@
+#include "Vulkan/HoleFillingPass.h"
+#include "Olympus/Debug.h"
+#include "Olympus/Shader.h"
+#include <array>
+
+namespace
+{
+/// Steps of pushpull.comp.
+enum PushPullMode : uint32_t
+{
+    MODE_INIT = 0,
+    MODE_PULL = 1,
+    MODE_PUSH = 2,
+    MODE_WRITE = 3
+};
+
+/// Push constants of pushpull.comp.
+struct PushPullParameters
+{
+    uint32_t Mode;
+    uint32_t SrcOffset;
+    uint32_t SrcWidth;
+    uint32_t SrcHeight;
+    uint32_t DstOffset;
+    uint32_t DstWidth;
+    uint32_t DstHeight;
+};
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+HoleFillingPass::HoleFillingPass(
+    const olp::Device &iDevice,
+    VkBuffer iDepthIndexBuffer,
+    VkBuffer iVertexBuffer,
+    VkDeviceSize iVertexBufferSize,
+    std::vector<olp::UniformBuffer> &iCamera,
+    uint32_t iWidth,
+    uint32_t iHeight)
+    : m_Device(iDevice),
+      m_DepthIndexBuffer(iDepthIndexBuffer),
+      m_VertexBuffer(iVertexBuffer),
+      m_VertexBufferSize(iVertexBufferSize)
+{
+    // Each level halves the previous one, rounded up, until a single texel is left.
+    uint32_t texelCount = 0;
+    Level level{0, iWidth, iHeight};
+    while (m_Levels.size() < LEVEL_COUNT)
+    {
+        level.Offset = texelCount;
+        m_Levels.push_back(level);
+        texelCount += level.Width * level.Height;
+        if (level.Width == 1 && level.Height == 1)
+            break;
+        level.Width = (level.Width + 1) / 2;
+        level.Height = (level.Height + 1) / 2;
+    }
+
+    m_PyramidBuffer = m_Device.CreateMemoryBuffer(
+        static_cast<VkDeviceSize>(texelCount) * 2 * sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    CreatePipeline();
+    CreateDescriptors(iCamera);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+HoleFillingPass::~HoleFillingPass()
+{
+    vkDestroyDescriptorPool(m_Device.GetDevice(), m_DescriptorPool, nullptr);
+    vkDestroyPipeline(m_Device.GetDevice(), m_Pipeline, nullptr);
+    vkDestroyPipelineLayout(m_Device.GetDevice(), m_PipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_Device.GetDevice(), m_DescriptorSetLayout, nullptr);
+    m_PyramidBuffer.Destroy();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void HoleFillingPass::CreatePipeline()
+{
+    // Binding 0: depth and index buffer, 1: vertex buffer, 2: pyramid, 3: camera UBO.
+    const std::array<VkDescriptorType, 4> types{
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER};
+    std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = types[i];
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(m_Device.GetDevice(), &layoutInfo, nullptr, &m_DescriptorSetLayout))
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PushPullParameters);
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    VK_CHECK_RESULT(vkCreatePipelineLayout(m_Device.GetDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout))
+
+    olp::Shader shader(m_Device);
+    std::filesystem::path shaderPath = CLOUD_RENDERING_SHADERS;
+    shaderPath /= "pushpull_comp.spv";
+    shader.Load(shaderPath);
+
+    VkPipelineShaderStageCreateInfo shaderStageInfo{};
+    shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStageInfo.module = shader.GetShaderModule();
+    shaderStageInfo.pName = "main";
+
+    VkComputePipelineCreateInfo pipelineCreateInfo{};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.layout = m_PipelineLayout;
+    pipelineCreateInfo.stage = shaderStageInfo;
+    VK_CHECK_RESULT(vkCreateComputePipelines(
+        m_Device.GetDevice(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &m_Pipeline))
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void HoleFillingPass::CreateDescriptors(std::vector<olp::UniformBuffer> &iCamera)
+{
+    const uint32_t imageCount = static_cast<uint32_t>(iCamera.size());
+    VkDescriptorPoolSize uniformPoolSize{};
+    uniformPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uniformPoolSize.descriptorCount = imageCount;
+    VkDescriptorPoolSize storageBufferPoolSize{};
+    storageBufferPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    storageBufferPoolSize.descriptorCount = 3 * imageCount;
+    std::array<VkDescriptorPoolSize, 2> poolSizes{uniformPoolSize, storageBufferPoolSize};
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = imageCount;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    VK_CHECK_RESULT(vkCreateDescriptorPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_DescriptorPool))
+
+    VkDescriptorBufferInfo depthIndexBufferInfo{m_DepthIndexBuffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo vertexBufferInfo{m_VertexBuffer, 0, m_VertexBufferSize};
+    VkDescriptorBufferInfo pyramidBufferInfo{m_PyramidBuffer.Buffer, 0, VK_WHOLE_SIZE};
+
+    m_DescriptorSets.reserve(imageCount);
+    for (uint32_t i = 0; i < imageCount; ++i)
+    {
+        olp::DescriptorSet &descriptorSet = m_DescriptorSets.emplace_back(m_Device);
+        descriptorSet.AllocateDescriptorSets(m_DescriptorSetLayout, m_DescriptorPool);
+        descriptorSet.AddWriteDescriptor(0, depthIndexBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(1, vertexBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(2, pyramidBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(3, iCamera[i]);
+        descriptorSet.UpdateDescriptorSets();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void HoleFillingPass::UpdateVertexBuffer(VkBuffer iVertexBuffer, VkDeviceSize iVertexBufferSize)
+{
+    m_VertexBuffer = iVertexBuffer;
+    m_VertexBufferSize = iVertexBufferSize;
+
+    VkDescriptorBufferInfo vertexBufferInfo{m_VertexBuffer, 0, m_VertexBufferSize};
+    for (const olp::DescriptorSet &descriptorSet : m_DescriptorSets)
+    {
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = descriptorSet.GetDescriptorSet();
+        write.dstBinding = 1;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = &vertexBufferInfo;
+        vkUpdateDescriptorSets(m_Device.GetDevice(), 1, &write, 0, nullptr);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void HoleFillingPass::Record(VkCommandBuffer iCommandBuffer, uint32_t iImage)
+{
+    vkCmdBindPipeline(iCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    vkCmdBindDescriptorSets(
+        iCommandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_PipelineLayout,
+        0,
+        1,
+        &m_DescriptorSets[iImage].GetDescriptorSet(),
+        0,
+        nullptr);
+
+    const Level &image = m_Levels.front();
+    RecordStep(iCommandBuffer, MODE_INIT, image, image);
+    for (size_t i = 1; i < m_Levels.size(); ++i)
+        RecordStep(iCommandBuffer, MODE_PULL, m_Levels[i - 1], m_Levels[i]);
+    for (size_t i = m_Levels.size() - 1; i > 0; --i)
+        RecordStep(iCommandBuffer, MODE_PUSH, m_Levels[i], m_Levels[i - 1]);
+    RecordStep(iCommandBuffer, MODE_WRITE, image, image);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void HoleFillingPass::RecordStep(VkCommandBuffer iCommandBuffer, uint32_t iMode, const Level &iSource, const Level &iDestination)
+{
+    // Each step reads what the previous one wrote, the first one the rasterized points.
+    VkMemoryBarrier stepBarrier{};
+    stepBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    stepBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    stepBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        iCommandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &stepBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+
+    PushPullParameters parameters{};
+    parameters.Mode = iMode;
+    parameters.SrcOffset = iSource.Offset;
+    parameters.SrcWidth = iSource.Width;
+    parameters.SrcHeight = iSource.Height;
+    parameters.DstOffset = iDestination.Offset;
+    parameters.DstWidth = iDestination.Width;
+    parameters.DstHeight = iDestination.Height;
+    vkCmdPushConstants(
+        iCommandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushPullParameters), &parameters);
+    vkCmdDispatch(
+        iCommandBuffer,
+        (iDestination.Width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+        (iDestination.Height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+        1);
+}
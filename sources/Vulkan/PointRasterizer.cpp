@@ -0,0 +1,447 @@
+#include "Vulkan/PointRasterizer.h"
+#include "Olympus/Debug.h"
+#include "Olympus/Shader.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace
+{
+/// Push constants of rasterize.comp.
+struct RasterizeParameters
+{
+    uint32_t First;
+    uint32_t Count;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+/// Specialization constants of rasterize.comp.
+struct RasterizeSpecialization
+{
+    VkBool32 Reprojected;
+    VkBool32 StepCounter;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// Creates a descriptor set layout.
+/// @param[in] iDevice Device.
+/// @param[in] iTypes Type of each binding.
+/// @param[in] iStages Stages using the bindings.
+/// @return Descriptor set layout.
+template <size_t Count>
+VkDescriptorSetLayout CreateDescriptorSetLayout(
+    const olp::Device &iDevice, const std::array<VkDescriptorType, Count> &iTypes, VkShaderStageFlags iStages)
+{
+    std::array<VkDescriptorSetLayoutBinding, Count> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = iTypes[i];
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = iStages;
+    }
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(iDevice.GetDevice(), &layoutInfo, nullptr, &layout))
+    return layout;
+}
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+bool PointRasterizer::IsSupported(const olp::Device &iDevice)
+{
+#ifdef CLOUD_RENDERING_COMPUTE_RASTER
+    // vkGetPhysicalDeviceFeatures2 is only core from Vulkan 1.1, on the instance and on the device.
+    const auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+        vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion"));
+    uint32_t instanceVersion = VK_API_VERSION_1_0;
+    if (enumerateInstanceVersion)
+        enumerateInstanceVersion(&instanceVersion);
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(iDevice.GetPhysicalDevice(), &properties);
+    if (instanceVersion < VK_API_VERSION_1_1 || properties.apiVersion < VK_API_VERSION_1_1)
+        return false;
+
+    VkPhysicalDeviceShaderAtomicInt64Features atomicFeatures{};
+    atomicFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_ATOMIC_INT64_FEATURES;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &atomicFeatures;
+    vkGetPhysicalDeviceFeatures2(iDevice.GetPhysicalDevice(), &features);
+    return features.features.shaderInt64 && atomicFeatures.shaderBufferInt64Atomics;
+#else
+    // The device is created without the 64-bit atomics, the pipelines of the pass would be invalid.
+    (void)iDevice;
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+PointRasterizer::PointRasterizer(
+    const olp::Device &iDevice,
+    VkOptiCloud &iOptiCloud,
+    std::vector<olp::UniformBuffer> &iModel,
+    std::vector<olp::UniformBuffer> &iCloudTransforms,
+    olp::UniformBuffer &iScreenSize,
+    std::vector<olp::UniformBuffer> &iCamera,
+    uint32_t iWidth,
+    uint32_t iHeight,
+    bool iHoleFilling)
+    : m_Device(iDevice),
+      m_Width(iWidth),
+      m_Height(iHeight),
+      m_ResolveDescriptorSet(iDevice)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_Device.GetPhysicalDevice(), &properties);
+    m_MaxGroupCount = properties.limits.maxComputeWorkGroupCount[0];
+
+    m_VertexBuffer = iOptiCloud.GetVertexBuffer().Buffer;
+    m_VertexBufferSize = iOptiCloud.GetVertexBufferSize();
+    m_ReprojectedBuffer = iOptiCloud.GetReprojectedBuffer().Buffer;
+    m_ReprojectedBufferSize = iOptiCloud.GetReprojectedBufferSize();
+    m_ReprojectedDrawBuffer = iOptiCloud.GetReprojectedDrawBuffer().Buffer;
+    m_StepBuffer = iOptiCloud.GetStepCounter().GetBuffer();
+    m_DepthIndexBuffer = m_Device.CreateMemoryBuffer(
+        static_cast<VkDeviceSize>(m_Width) * m_Height * sizeof(uint64_t),
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    CreatePipelines();
+    CreateDescriptors(iModel, iCloudTransforms, iScreenSize);
+    if (iHoleFilling)
+    {
+        m_HoleFilling = std::make_unique<HoleFillingPass>(
+            m_Device, m_DepthIndexBuffer.Buffer, m_VertexBuffer, m_VertexBufferSize, iCamera, m_Width, m_Height);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+PointRasterizer::~PointRasterizer()
+{
+    m_HoleFilling.reset();
+    vkDestroyDescriptorPool(m_Device.GetDevice(), m_DescriptorPool, nullptr);
+    vkDestroyPipeline(m_Device.GetDevice(), m_PointPipeline, nullptr);
+    vkDestroyPipeline(m_Device.GetDevice(), m_ReprojectedPipeline, nullptr);
+    vkDestroyPipeline(m_Device.GetDevice(), m_StepPipeline, nullptr);
+    vkDestroyPipelineLayout(m_Device.GetDevice(), m_RasterizePipelineLayout, nullptr);
+    vkDestroyPipelineLayout(m_Device.GetDevice(), m_ResolvePipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_Device.GetDevice(), m_RasterizeDescriptorSetLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_Device.GetDevice(), m_ResolveDescriptorSetLayout, nullptr);
+    m_DepthIndexBuffer.Destroy();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PointRasterizer::CreatePipelines()
+{
+    // Binding 0: vertex buffer, 1: reprojected buffer, 2: depth and index buffer, 3: model UBO, 4: cloud transforms,
+    // 5: draw command of the reprojected buffer, 6: step counter.
+    m_RasterizeDescriptorSetLayout = CreateDescriptorSetLayout<7>(
+        m_Device,
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+         VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+         VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+         VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+         VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+         VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+         VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        VK_SHADER_STAGE_COMPUTE_BIT);
+    // Binding 0: screen size, 1: depth and index buffer, 2: vertex buffer.
+    m_ResolveDescriptorSetLayout = CreateDescriptorSetLayout<3>(
+        m_Device,
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(RasterizeParameters);
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_RasterizeDescriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    VK_CHECK_RESULT(vkCreatePipelineLayout(m_Device.GetDevice(), &pipelineLayoutInfo, nullptr, &m_RasterizePipelineLayout))
+
+    pipelineLayoutInfo.pSetLayouts = &m_ResolveDescriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+    pipelineLayoutInfo.pPushConstantRanges = nullptr;
+    VK_CHECK_RESULT(vkCreatePipelineLayout(m_Device.GetDevice(), &pipelineLayoutInfo, nullptr, &m_ResolvePipelineLayout))
+
+    olp::Shader shader(m_Device);
+    std::filesystem::path shaderPath = CLOUD_RENDERING_SHADERS;
+    shaderPath /= "rasterize_comp.spv";
+    shader.Load(shaderPath);
+
+    // The same shader reads either buffer, and takes the range of the vertex buffer from the push constants or from
+    // the step counter, selected by the REPROJECTED and STEP_COUNTER specialization constants.
+    std::array<VkSpecializationMapEntry, 2> specializationEntries{};
+    specializationEntries[0].constantID = 0;
+    specializationEntries[0].offset = offsetof(RasterizeSpecialization, Reprojected);
+    specializationEntries[0].size = sizeof(VkBool32);
+    specializationEntries[1].constantID = 1;
+    specializationEntries[1].offset = offsetof(RasterizeSpecialization, StepCounter);
+    specializationEntries[1].size = sizeof(VkBool32);
+
+    const std::array<std::pair<RasterizeSpecialization, VkPipeline *>, 3> pipelines{{
+        {{VK_FALSE, VK_FALSE}, &m_PointPipeline},
+        {{VK_TRUE, VK_FALSE}, &m_ReprojectedPipeline},
+        {{VK_FALSE, VK_TRUE}, &m_StepPipeline},
+    }};
+    for (const std::pair<RasterizeSpecialization, VkPipeline *> &pipeline : pipelines)
+    {
+        VkSpecializationInfo specializationInfo{};
+        specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+        specializationInfo.pMapEntries = specializationEntries.data();
+        specializationInfo.dataSize = sizeof(RasterizeSpecialization);
+        specializationInfo.pData = &pipeline.first;
+
+        VkPipelineShaderStageCreateInfo shaderStageInfo{};
+        shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        shaderStageInfo.module = shader.GetShaderModule();
+        shaderStageInfo.pName = "main";
+        shaderStageInfo.pSpecializationInfo = &specializationInfo;
+
+        VkComputePipelineCreateInfo pipelineCreateInfo{};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.layout = m_RasterizePipelineLayout;
+        pipelineCreateInfo.stage = shaderStageInfo;
+        VK_CHECK_RESULT(vkCreateComputePipelines(
+            m_Device.GetDevice(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, pipeline.second))
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PointRasterizer::CreateDescriptors(
+    std::vector<olp::UniformBuffer> &iModel,
+    std::vector<olp::UniformBuffer> &iCloudTransforms,
+    olp::UniformBuffer &iScreenSize)
+{
+    const uint32_t imageCount = static_cast<uint32_t>(iModel.size());
+    VkDescriptorPoolSize uniformPoolSize{};
+    uniformPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uniformPoolSize.descriptorCount = 2 * imageCount + 1;
+    VkDescriptorPoolSize storageBufferPoolSize{};
+    storageBufferPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    storageBufferPoolSize.descriptorCount = 5 * imageCount + 2;
+    std::array<VkDescriptorPoolSize, 2> poolSizes{uniformPoolSize, storageBufferPoolSize};
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = imageCount + 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    VK_CHECK_RESULT(vkCreateDescriptorPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_DescriptorPool))
+
+    VkDescriptorBufferInfo vertexBufferInfo{m_VertexBuffer, 0, m_VertexBufferSize};
+    VkDescriptorBufferInfo reprojectedBufferInfo{m_ReprojectedBuffer, 0, m_ReprojectedBufferSize};
+    VkDescriptorBufferInfo reprojectedDrawBufferInfo{m_ReprojectedDrawBuffer, 0, sizeof(VkDrawIndirectCommand)};
+    VkDescriptorBufferInfo stepBufferInfo{m_StepBuffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo depthIndexBufferInfo{m_DepthIndexBuffer.Buffer, 0, VK_WHOLE_SIZE};
+
+    m_RasterizeDescriptorSets.reserve(imageCount);
+    for (uint32_t i = 0; i < imageCount; ++i)
+    {
+        olp::DescriptorSet &descriptorSet = m_RasterizeDescriptorSets.emplace_back(m_Device);
+        descriptorSet.AllocateDescriptorSets(m_RasterizeDescriptorSetLayout, m_DescriptorPool);
+        descriptorSet.AddWriteDescriptor(0, vertexBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(1, reprojectedBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(2, depthIndexBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(3, iModel[i]);
+        descriptorSet.AddWriteDescriptor(4, iCloudTransforms[i]);
+        descriptorSet.AddWriteDescriptor(5, reprojectedDrawBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.AddWriteDescriptor(6, stepBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        descriptorSet.UpdateDescriptorSets();
+    }
+
+    m_ResolveDescriptorSet.AllocateDescriptorSets(m_ResolveDescriptorSetLayout, m_DescriptorPool);
+    m_ResolveDescriptorSet.AddWriteDescriptor(0, iScreenSize);
+    m_ResolveDescriptorSet.AddWriteDescriptor(1, depthIndexBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    m_ResolveDescriptorSet.AddWriteDescriptor(2, vertexBufferInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    m_ResolveDescriptorSet.UpdateDescriptorSets();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PointRasterizer::UpdateCloud(VkOptiCloud &iOptiCloud)
+{
+    m_VertexBuffer = iOptiCloud.GetVertexBuffer().Buffer;
+    m_VertexBufferSize = iOptiCloud.GetVertexBufferSize();
+    m_ReprojectedBuffer = iOptiCloud.GetReprojectedBuffer().Buffer;
+    m_ReprojectedBufferSize = iOptiCloud.GetReprojectedBufferSize();
+    m_ReprojectedDrawBuffer = iOptiCloud.GetReprojectedDrawBuffer().Buffer;
+    m_StepBuffer = iOptiCloud.GetStepCounter().GetBuffer();
+
+    VkDescriptorBufferInfo vertexBufferInfo{m_VertexBuffer, 0, m_VertexBufferSize};
+    VkDescriptorBufferInfo reprojectedBufferInfo{m_ReprojectedBuffer, 0, m_ReprojectedBufferSize};
+    VkDescriptorBufferInfo reprojectedDrawBufferInfo{m_ReprojectedDrawBuffer, 0, sizeof(VkDrawIndirectCommand)};
+    VkDescriptorBufferInfo stepBufferInfo{m_StepBuffer, 0, VK_WHOLE_SIZE};
+
+    std::vector<VkWriteDescriptorSet> writes;
+    for (const olp::DescriptorSet &descriptorSet : m_RasterizeDescriptorSets)
+    {
+        const std::array<std::pair<uint32_t, const VkDescriptorBufferInfo *>, 4> bindings{{
+            {0, &vertexBufferInfo},
+            {1, &reprojectedBufferInfo},
+            {5, &reprojectedDrawBufferInfo},
+            {6, &stepBufferInfo},
+        }};
+        for (const std::pair<uint32_t, const VkDescriptorBufferInfo *> &binding : bindings)
+        {
+            VkWriteDescriptorSet &write = writes.emplace_back();
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = descriptorSet.GetDescriptorSet();
+            write.dstBinding = binding.first;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write.pBufferInfo = binding.second;
+        }
+    }
+    VkWriteDescriptorSet &resolveWrite = writes.emplace_back();
+    resolveWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    resolveWrite.dstSet = m_ResolveDescriptorSet.GetDescriptorSet();
+    resolveWrite.dstBinding = 2;
+    resolveWrite.descriptorCount = 1;
+    resolveWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    resolveWrite.pBufferInfo = &vertexBufferInfo;
+    vkUpdateDescriptorSets(m_Device.GetDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    if (m_HoleFilling)
+        m_HoleFilling->UpdateVertexBuffer(m_VertexBuffer, m_VertexBufferSize);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PointRasterizer::RecordBegin(VkCommandBuffer iCommandBuffer, uint32_t iImage)
+{
+    // The resolve of the previous frame read the buffer.
+    VkMemoryBarrier resolveBarrier{};
+    resolveBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    resolveBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    resolveBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        iCommandBuffer,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1,
+        &resolveBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+
+    // All ones: the farthest depth and no point.
+    vkCmdFillBuffer(iCommandBuffer, m_DepthIndexBuffer.Buffer, 0, VK_WHOLE_SIZE, 0xFFFFFFFF);
+
+    VkMemoryBarrier clearBarrier{};
+    clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        iCommandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &clearBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+
+    vkCmdBindDescriptorSets(
+        iCommandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_RasterizePipelineLayout,
+        0,
+        1,
+        &m_RasterizeDescriptorSets[iImage].GetDescriptorSet(),
+        0,
+        nullptr);
+    // The shader reads the number of reprojected points from their draw command, the dispatch covers the capacity.
+    RecordDispatch(iCommandBuffer, m_ReprojectedPipeline, 0, m_Width * m_Height);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PointRasterizer::RecordPoints(VkCommandBuffer iCommandBuffer, uint32_t iFirst, uint32_t iCount)
+{
+    // The dispatches only combine their results with atomicMin, they need no barrier between them.
+    RecordDispatch(iCommandBuffer, m_PointPipeline, iFirst, iCount);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PointRasterizer::RecordStep(VkCommandBuffer iCommandBuffer)
+{
+    RasterizeParameters parameters{};
+    parameters.Width = m_Width;
+    parameters.Height = m_Height;
+
+    vkCmdBindPipeline(iCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_StepPipeline);
+    vkCmdPushConstants(
+        iCommandBuffer, m_RasterizePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RasterizeParameters), &parameters);
+    vkCmdDispatchIndirect(iCommandBuffer, m_StepBuffer, StepCounter::DISPATCH_OFFSET);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PointRasterizer::RecordEnd(VkCommandBuffer iCommandBuffer, uint32_t iImage)
+{
+    if (m_HoleFilling)
+        m_HoleFilling->Record(iCommandBuffer, iImage);
+
+    VkMemoryBarrier rasterizeBarrier{};
+    rasterizeBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    rasterizeBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    rasterizeBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(
+        iCommandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0,
+        1,
+        &rasterizeBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PointRasterizer::BindResolveDescriptor(VkCommandBuffer iCommandBuffer)
+{
+    vkCmdBindDescriptorSets(
+        iCommandBuffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        m_ResolvePipelineLayout,
+        0,
+        1,
+        &m_ResolveDescriptorSet.GetDescriptorSet(),
+        0,
+        nullptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void PointRasterizer::RecordDispatch(VkCommandBuffer iCommandBuffer, VkPipeline iPipeline, uint32_t iFirst, uint32_t iCount)
+{
+    if (iCount == 0)
+        return;
+
+    RasterizeParameters parameters{};
+    parameters.First = iFirst;
+    parameters.Count = iCount;
+    parameters.Width = m_Width;
+    parameters.Height = m_Height;
+
+    vkCmdBindPipeline(iCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, iPipeline);
+    vkCmdPushConstants(
+        iCommandBuffer, m_RasterizePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RasterizeParameters), &parameters);
+
+    // The shader loops over the points, so the group count stays within the device limit for any step.
+    const uint32_t groupCount = std::clamp((iCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1u, m_MaxGroupCount);
+    vkCmdDispatch(iCommandBuffer, groupCount, 1, 1);
+}
@@ -0,0 +1,72 @@
+#include "Vulkan/SecondaryCommandBuffers.h"
+#include "Olympus/Debug.h"
+#include "Parallel.h"
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+SecondaryCommandBuffers::SecondaryCommandBuffers(const olp::Device &iDevice, uint32_t iImageCount, uint32_t iThreadCount)
+    : m_Device(iDevice),
+      m_ThreadCount(std::max(iThreadCount, 1u))
+{
+    m_CommandPools.resize(iImageCount * m_ThreadCount, VK_NULL_HANDLE);
+    m_CommandBuffers.resize(m_CommandPools.size(), VK_NULL_HANDLE);
+    for (size_t i = 0; i < m_CommandPools.size(); ++i)
+    {
+        // The pool is reset as a whole before each recording.
+        VkCommandPoolCreateInfo cmdPoolInfo{};
+        cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        cmdPoolInfo.queueFamilyIndex = m_Device.GetQueueIndices().graphicsFamily.value();
+        VK_CHECK_RESULT(vkCreateCommandPool(m_Device.GetDevice(), &cmdPoolInfo, nullptr, &m_CommandPools[i]))
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = m_CommandPools[i];
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+        VK_CHECK_RESULT(vkAllocateCommandBuffers(m_Device.GetDevice(), &allocInfo, &m_CommandBuffers[i]))
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+SecondaryCommandBuffers::~SecondaryCommandBuffers()
+{
+    for (VkCommandPool commandPool : m_CommandPools)
+        vkDestroyCommandPool(m_Device.GetDevice(), commandPool, nullptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<VkCommandBuffer> SecondaryCommandBuffers::Record(
+    uint32_t iImage,
+    const VkCommandBufferInheritanceInfo &iInheritance,
+    uint32_t iDrawCount,
+    const std::function<void(VkCommandBuffer, uint32_t, uint32_t)> &iRecordDraws)
+{
+    if (iDrawCount == 0)
+        return {};
+
+    // Contiguous chunks of the same size, so the buffers keep the order of the draws.
+    const uint32_t threadCount = std::clamp(iDrawCount / MIN_DRAWS_PER_THREAD, 1u, m_ThreadCount);
+    const uint32_t chunkSize = (iDrawCount + threadCount - 1) / threadCount;
+    const size_t firstBuffer = static_cast<size_t>(iImage) * m_ThreadCount;
+    ParallelFor(
+        threadCount,
+        [&](uint32_t iThread)
+        {
+            VK_CHECK_RESULT(vkResetCommandPool(m_Device.GetDevice(), m_CommandPools[firstBuffer + iThread], 0))
+
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            beginInfo.pInheritanceInfo = &iInheritance;
+            VkCommandBuffer commandBuffer = m_CommandBuffers[firstBuffer + iThread];
+            VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo))
+
+            const uint32_t first = std::min(iThread * chunkSize, iDrawCount);
+            iRecordDraws(commandBuffer, first, std::min(chunkSize, iDrawCount - first));
+
+            VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer))
+        });
+
+    return std::vector<VkCommandBuffer>(
+        m_CommandBuffers.begin() + firstBuffer, m_CommandBuffers.begin() + firstBuffer + threadCount);
+}
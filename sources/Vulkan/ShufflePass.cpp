@@ -0,0 +1,226 @@
+#include "Vulkan/ShufflePass.h"
+#include "Olympus/Debug.h"
+#include "Olympus/Shader.h"
+#include <algorithm>
+#include <array>
+
+namespace
+{
+/// Push constants of shuffle.comp.
+struct ShuffleParameters
+{
+    uint32_t Keys[Permutation::ROUND_COUNT];
+    uint32_t Count;
+    uint32_t HalfBits;
+};
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+ShufflePass::ShufflePass(const olp::Device &iDevice, VkBuffer iSrcBuffer, VkBuffer iDstBuffer, uint32_t iPointCount)
+    : m_Device(iDevice),
+      m_SrcBuffer(iSrcBuffer),
+      m_DstBuffer(iDstBuffer),
+      m_Permutation(iPointCount)
+{
+    CreatePipeline();
+    CreateDescriptor();
+
+    VkCommandPoolCreateInfo cmdPoolInfo{};
+    cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    cmdPoolInfo.queueFamilyIndex = m_Device.GetQueueIndices().graphicsFamily.value();
+    cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    VK_CHECK_RESULT(vkCreateCommandPool(m_Device.GetDevice(), &cmdPoolInfo, nullptr, &m_CommandPool))
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_CommandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    VK_CHECK_RESULT(vkAllocateCommandBuffers(m_Device.GetDevice(), &allocInfo, &m_CommandBuffer))
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VK_CHECK_RESULT(vkCreateFence(m_Device.GetDevice(), &fenceInfo, nullptr, &m_Fence))
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+ShufflePass::~ShufflePass()
+{
+    Wait();
+    vkDestroyFence(m_Device.GetDevice(), m_Fence, nullptr);
+    vkDestroyCommandPool(m_Device.GetDevice(), m_CommandPool, nullptr);
+    vkDestroyDescriptorPool(m_Device.GetDevice(), m_DescriptorPool, nullptr);
+    vkDestroyPipeline(m_Device.GetDevice(), m_Pipeline, nullptr);
+    vkDestroyPipelineLayout(m_Device.GetDevice(), m_PipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_Device.GetDevice(), m_DescriptorSetLayout, nullptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ShufflePass::CreatePipeline()
+{
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        // Binding 0: points in file order, binding 1: shuffled points.
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(m_Device.GetDevice(), &layoutInfo, nullptr, &m_DescriptorSetLayout))
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(ShuffleParameters);
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    VK_CHECK_RESULT(vkCreatePipelineLayout(m_Device.GetDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout))
+
+    olp::Shader shader(m_Device);
+    std::filesystem::path shaderPath = CLOUD_RENDERING_SHADERS;
+    shaderPath /= "shuffle_comp.spv";
+    shader.Load(shaderPath);
+
+    VkPipelineShaderStageCreateInfo shaderStageInfo{};
+    shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStageInfo.module = shader.GetShaderModule();
+    shaderStageInfo.pName = "main";
+
+    VkComputePipelineCreateInfo pipelineCreateInfo{};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.layout = m_PipelineLayout;
+    pipelineCreateInfo.stage = shaderStageInfo;
+    VK_CHECK_RESULT(vkCreateComputePipelines(
+        m_Device.GetDevice(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &m_Pipeline))
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ShufflePass::CreateDescriptor()
+{
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 2;
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    VK_CHECK_RESULT(vkCreateDescriptorPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_DescriptorPool))
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_DescriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_DescriptorSetLayout;
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device.GetDevice(), &allocInfo, &m_DescriptorSet))
+
+    std::array<VkDescriptorBufferInfo, 2> bufferInfos{};
+    bufferInfos[0].buffer = m_SrcBuffer;
+    bufferInfos[1].buffer = m_DstBuffer;
+    std::array<VkWriteDescriptorSet, 2> writes{};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+        bufferInfos[i].offset = 0;
+        bufferInfos[i].range = VK_WHOLE_SIZE;
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = m_DescriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(m_Device.GetDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ShufflePass::Submit()
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(m_CommandBuffer, &beginInfo))
+
+    // The source was filled by transfers on this queue.
+    VkMemoryBarrier uploadBarrier{};
+    uploadBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    uploadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    uploadBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(
+        m_CommandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &uploadBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+
+    ShuffleParameters parameters{};
+    std::copy(m_Permutation.GetKeys().begin(), m_Permutation.GetKeys().end(), parameters.Keys);
+    parameters.Count = m_Permutation.GetCount();
+    parameters.HalfBits = m_Permutation.GetHalfBits();
+
+    vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    vkCmdBindDescriptorSets(
+        m_CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
+    vkCmdPushConstants(
+        m_CommandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ShuffleParameters), &parameters);
+
+    // The shader loops over the points, so the group count stays within the device limit for any cloud.
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_Device.GetPhysicalDevice(), &properties);
+    const uint32_t groupCount = std::clamp(
+        (parameters.Count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1u, properties.limits.maxComputeWorkGroupCount[0]);
+    vkCmdDispatch(m_CommandBuffer, groupCount, 1, 1);
+
+    // Make the shuffled points visible to the draws and to the prepare pass.
+    VkMemoryBarrier shuffleBarrier{};
+    shuffleBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    shuffleBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    shuffleBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(
+        m_CommandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &shuffleBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(m_CommandBuffer))
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &m_CommandBuffer;
+    VK_CHECK_RESULT(vkQueueSubmit(m_Device.GetGraphicsQueue(), 1, &submitInfo, m_Fence))
+    m_Submitted = true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool ShufflePass::IsFinished() const
+{
+    return m_Submitted && vkGetFenceStatus(m_Device.GetDevice(), m_Fence) == VK_SUCCESS;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ShufflePass::Wait() const
+{
+    if (m_Submitted)
+        vkWaitForFences(m_Device.GetDevice(), 1, &m_Fence, VK_TRUE, UINT64_MAX);
+}
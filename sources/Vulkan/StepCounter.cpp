@@ -0,0 +1,250 @@
+#include "Vulkan/StepCounter.h"
+#include "Olympus/Debug.h"
+#include "Olympus/Shader.h"
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+/// State buffer of advancestep.comp, in std430 layout.
+struct StepCounter::State
+{
+    /// Block of a slot, written by the host before the advance of the slot and read back after it.
+    struct Slot
+    {
+        uint32_t PointCount;
+        uint32_t LoadedCount;
+        uint32_t PointsByStep;
+        float RewindFraction;
+        /// m_Serial when committed.
+        uint32_t Serial;
+        /// Written by the advance.
+        uint32_t StepCount;
+        uint32_t Complete;
+    };
+
+    /// Written by the advances only.
+    VkDrawIndirectCommand Draw;
+    VkDispatchIndirectCommand Dispatch;
+    uint32_t DrawnCount;
+    Slot Slots[SLOT_COUNT];
+};
+
+namespace
+{
+/// Push constants of advancestep.comp.
+struct AdvanceParameters
+{
+    uint32_t Slot;
+};
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+StepCounter::StepCounter(const olp::Device &iDevice)
+    : m_Device(iDevice)
+{
+    static_assert(offsetof(State, Draw) == DRAW_OFFSET, "the draw starts the state buffer");
+    static_assert(offsetof(State, Dispatch) == DISPATCH_OFFSET, "the dispatch follows the draw");
+
+    m_StateBuffer = m_Device.CreateMemoryBuffer(
+        sizeof(State),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    void *data = nullptr;
+    VK_CHECK_RESULT(vkMapMemory(m_Device.GetDevice(), m_StateBuffer.Memory, 0, sizeof(State), 0, &data))
+    m_State = static_cast<State *>(data);
+    *m_State = State{};
+
+    CreatePipeline();
+    CreateDescriptor();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+StepCounter::~StepCounter()
+{
+    vkDestroyDescriptorPool(m_Device.GetDevice(), m_DescriptorPool, nullptr);
+    vkDestroyPipeline(m_Device.GetDevice(), m_Pipeline, nullptr);
+    vkDestroyPipelineLayout(m_Device.GetDevice(), m_PipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_Device.GetDevice(), m_DescriptorSetLayout, nullptr);
+    vkUnmapMemory(m_Device.GetDevice(), m_StateBuffer.Memory);
+    m_StateBuffer.Destroy();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StepCounter::CreatePipeline()
+{
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(m_Device.GetDevice(), &layoutInfo, nullptr, &m_DescriptorSetLayout))
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(AdvanceParameters);
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    VK_CHECK_RESULT(vkCreatePipelineLayout(m_Device.GetDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout))
+
+    olp::Shader shader(m_Device);
+    std::filesystem::path shaderPath = CLOUD_RENDERING_SHADERS;
+    shaderPath /= "advancestep_comp.spv";
+    shader.Load(shaderPath);
+
+    VkPipelineShaderStageCreateInfo shaderStageInfo{};
+    shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStageInfo.module = shader.GetShaderModule();
+    shaderStageInfo.pName = "main";
+
+    VkComputePipelineCreateInfo pipelineCreateInfo{};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.layout = m_PipelineLayout;
+    pipelineCreateInfo.stage = shaderStageInfo;
+    VK_CHECK_RESULT(vkCreateComputePipelines(
+        m_Device.GetDevice(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &m_Pipeline))
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StepCounter::CreateDescriptor()
+{
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 1;
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    VK_CHECK_RESULT(vkCreateDescriptorPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_DescriptorPool))
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_DescriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_DescriptorSetLayout;
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device.GetDevice(), &allocInfo, &m_DescriptorSet))
+
+    VkDescriptorBufferInfo bufferInfo{m_StateBuffer.Buffer, 0, sizeof(State)};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_DescriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(m_Device.GetDevice(), 1, &write, 0, nullptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StepCounter::SetPointCounts(uint32_t iPointCount, uint32_t iLoadedCount, uint32_t iPointsByStep)
+{
+    // The size of the steps does not change which points are drawn.
+    if (iPointCount != m_PointCount || iLoadedCount != m_LoadedCount)
+    {
+        ++m_Serial;
+        m_Complete = false;
+    }
+    m_PointCount = iPointCount;
+    m_LoadedCount = iLoadedCount;
+    m_PointsByStep = iPointsByStep;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StepCounter::Rewind(float iFraction)
+{
+    // A rewind not committed yet is combined with the new one: the points kept are the product of the points kept.
+    const float fraction = std::min(std::max(iFraction, 0.0f), 1.0f);
+    m_RewindFraction = 1.0f - (1.0f - m_RewindFraction) * (1.0f - fraction);
+    ++m_Serial;
+    m_Complete = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StepCounter::Commit(uint32_t iSlot)
+{
+    // The block is written at each submission: an advance submitted again never applies a rewind twice.
+    State::Slot &slot = m_State->Slots[iSlot];
+    slot.PointCount = m_PointCount;
+    slot.LoadedCount = m_LoadedCount;
+    slot.PointsByStep = m_PointsByStep;
+    slot.RewindFraction = std::exchange(m_RewindFraction, 0.0f);
+    slot.Serial = m_Serial;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StepCounter::RecordAdvance(VkCommandBuffer iCommandBuffer, uint32_t iSlot)
+{
+    // The previous advance wrote the state, and the previous frame read its commands.
+    VkMemoryBarrier previousBarrier{};
+    previousBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    previousBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    previousBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        iCommandBuffer,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &previousBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+
+    AdvanceParameters parameters{iSlot};
+    vkCmdBindPipeline(iCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    vkCmdBindDescriptorSets(
+        iCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
+    vkCmdPushConstants(
+        iCommandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(AdvanceParameters), &parameters);
+    vkCmdDispatch(iCommandBuffer, 1, 1, 1);
+
+    // The step is read by the indirect commands, the compute rasterizer and the host once the frame is finished.
+    VkMemoryBarrier advanceBarrier{};
+    advanceBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    advanceBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    advanceBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(
+        iCommandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        1,
+        &advanceBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StepCounter::RecordDraw(VkCommandBuffer iCommandBuffer)
+{
+    vkCmdDrawIndirect(iCommandBuffer, m_StateBuffer.Buffer, DRAW_OFFSET, 1, sizeof(VkDrawIndirectCommand));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t StepCounter::TakeStepPointCount(uint32_t iSlot)
+{
+    // Once drawn, the points stay drawn until a request changes the serial.
+    State::Slot &slot = m_State->Slots[iSlot];
+    if (slot.Serial == m_Serial && slot.Complete != 0)
+        m_Complete = true;
+    return std::exchange(slot.StepCount, 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StepCounter::SetStepPointCount(uint32_t iSlot, uint32_t iPointCount)
+{
+    m_State->Slots[iSlot].StepCount = iPointCount;
+}
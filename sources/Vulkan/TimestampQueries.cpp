@@ -0,0 +1,94 @@
+#include "Vulkan/TimestampQueries.h"
+#include "Olympus/Debug.h"
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+TimestampQueries::TimestampQueries(const olp::Device &iDevice, uint32_t iQueueFamily, uint32_t iCount)
+    : m_Device(iDevice)
+{
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_Device.GetPhysicalDevice(), &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_Device.GetPhysicalDevice(), &familyCount, families.data());
+    const uint32_t validBits = iQueueFamily < familyCount ? families[iQueueFamily].timestampValidBits : 0;
+    if (validBits == 0)
+        return;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_Device.GetPhysicalDevice(), &properties);
+    m_Period = properties.limits.timestampPeriod;
+    m_ValidMask = validBits >= 64 ? ~uint64_t{0} : (uint64_t{1} << validBits) - 1;
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = iCount;
+    VK_CHECK_RESULT(vkCreateQueryPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_Pool))
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+TimestampQueries::~TimestampQueries()
+{
+    vkDestroyQueryPool(m_Device.GetDevice(), m_Pool, nullptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void TimestampQueries::Reset(VkCommandBuffer iCommandBuffer, uint32_t iFirst, uint32_t iCount) const
+{
+    if (m_Pool)
+        vkCmdResetQueryPool(iCommandBuffer, m_Pool, iFirst, iCount);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void TimestampQueries::Write(VkCommandBuffer iCommandBuffer, VkPipelineStageFlagBits iStage, uint32_t iQuery) const
+{
+    if (m_Pool)
+        vkCmdWriteTimestamp(iCommandBuffer, iStage, m_Pool, iQuery);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool TimestampQueries::GetMilliseconds(uint32_t iBegin, uint32_t iEnd, double &oMilliseconds) const
+{
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    if (!Read(iBegin, begin) || !Read(iEnd, end))
+        return false;
+
+    oMilliseconds = static_cast<double>((end - begin) & m_ValidMask) * m_Period * 1e-6;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool TimestampQueries::GetTime(uint32_t iQuery, double &oMilliseconds) const
+{
+    uint64_t ticks = 0;
+    if (!Read(iQuery, ticks))
+        return false;
+
+    oMilliseconds = static_cast<double>(ticks & m_ValidMask) * m_Period * 1e-6;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool TimestampQueries::Read(uint32_t iQuery, uint64_t &oTicks) const
+{
+    if (!m_Pool)
+        return false;
+
+    // The value followed by its availability.
+    uint64_t result[2] = {0, 0};
+    const VkResult status = vkGetQueryPoolResults(
+        m_Device.GetDevice(),
+        m_Pool,
+        iQuery,
+        1,
+        sizeof(result),
+        result,
+        sizeof(result),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if ((status != VK_SUCCESS && status != VK_NOT_READY) || result[1] == 0)
+        return false;
+
+    oTicks = result[0];
+    return true;
+}
@@ -0,0 +1,193 @@
+#include "Vulkan/WorkgroupTuner.h"
+#include "Olympus/Debug.h"
+#include "Olympus/Shader.h"
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+namespace
+{
+/// Sizes chosen on each device, one "<device> <pass> <x> <y> <z>" entry per line.
+std::filesystem::path GetCacheFile()
+{
+    std::error_code error;
+    const std::filesystem::path folder = std::filesystem::temp_directory_path(error);
+    return (error ? std::filesystem::current_path() : folder) / "cloud_rendering_workgroups.txt";
+}
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+WorkgroupTuner::WorkgroupTuner(
+    const olp::Device &iDevice,
+    std::string iPassName,
+    const WorkgroupSize &iDefault,
+    const std::vector<WorkgroupSize> &iCandidates)
+    : m_Device(iDevice),
+      m_PassName(std::move(iPassName)),
+      m_Size(iDefault)
+{
+    m_DeviceKey = GetDeviceKey();
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_Device.GetPhysicalDevice(), &properties);
+    const VkPhysicalDeviceLimits &limits = properties.limits;
+    m_Candidates.push_back(iDefault);
+    for (const WorkgroupSize &candidate : iCandidates)
+    {
+        const bool supported = candidate.GetInvocationCount() <= limits.maxComputeWorkGroupInvocations
+            && candidate.X <= limits.maxComputeWorkGroupSize[0] && candidate.Y <= limits.maxComputeWorkGroupSize[1]
+            && candidate.Z <= limits.maxComputeWorkGroupSize[2];
+        if (supported && std::find(m_Candidates.begin(), m_Candidates.end(), candidate) == m_Candidates.end())
+            m_Candidates.push_back(candidate);
+    }
+
+    m_Tuned = LoadCachedSize();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void WorkgroupTuner::AddSample(const WorkgroupSize &iSize, double iMilliseconds)
+{
+    if (m_Tuned || iSize != GetSize())
+        return;
+
+    if (++m_FedCount <= WARMUP_SAMPLE_COUNT)
+        return;
+    m_Samples.push_back(iMilliseconds);
+    if (m_Samples.size() < SAMPLE_COUNT)
+        return;
+
+    // The median ignores the frames slowed down by a loading or a change of view.
+    std::nth_element(m_Samples.begin(), m_Samples.begin() + m_Samples.size() / 2, m_Samples.end());
+    m_Medians.push_back(m_Samples[m_Samples.size() / 2]);
+    m_Samples.clear();
+    m_FedCount = 0;
+    if (++m_Candidate == m_Candidates.size())
+        Finish();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void WorkgroupTuner::Cancel()
+{
+    if (m_Tuned)
+        return;
+
+    m_Size = m_Candidates.front();
+    m_Tuned = true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void WorkgroupTuner::Finish()
+{
+    const size_t best = std::min_element(m_Medians.begin(), m_Medians.end()) - m_Medians.begin();
+    m_Size = m_Candidates[best];
+    m_Tuned = true;
+    std::cout << "Workgroup size of the " << m_PassName << " pass: " << m_Size.X << "x" << m_Size.Y << "x" << m_Size.Z
+              << " (" << m_Medians[best] << " ms, " << m_Medians.front() << " ms with the default size)" << std::endl;
+    SaveSize();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string WorkgroupTuner::GetDeviceKey() const
+{
+    // The pipeline cache UUID changes with the driver, whose compiler decides which size is the fastest.
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_Device.GetPhysicalDevice(), &properties);
+    std::ostringstream key;
+    key << std::hex << std::setfill('0') << std::setw(4) << properties.vendorID << "-" << std::setw(4)
+        << properties.deviceID << "-";
+    for (uint8_t byte : properties.pipelineCacheUUID)
+        key << std::setw(2) << static_cast<uint32_t>(byte);
+    return key.str();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool WorkgroupTuner::LoadCachedSize()
+{
+    std::ifstream file(GetCacheFile());
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream entry(line);
+        std::string device;
+        std::string pass;
+        WorkgroupSize size;
+        if (!(entry >> device >> pass >> size.X >> size.Y >> size.Z) || device != m_DeviceKey || pass != m_PassName)
+            continue;
+        // A size no longer among the candidates comes from another version of the pass.
+        if (std::find(m_Candidates.begin(), m_Candidates.end(), size) == m_Candidates.end())
+            return false;
+        m_Size = size;
+        return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void WorkgroupTuner::SaveSize() const
+{
+    const std::filesystem::path cacheFile = GetCacheFile();
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(cacheFile);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream entry(line);
+            std::string device;
+            std::string pass;
+            if ((entry >> device >> pass) && (device != m_DeviceKey || pass != m_PassName))
+                lines.push_back(line);
+        }
+    }
+
+    std::ofstream file(cacheFile, std::ios::trunc);
+    for (const std::string &line : lines)
+        file << line << "\n";
+    file << m_DeviceKey << " " << m_PassName << " " << m_Size.X << " " << m_Size.Y << " " << m_Size.Z << "\n";
+    if (!file)
+        std::cerr << "Failed to write the workgroup sizes to " << cacheFile << std::endl;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+VkPipeline WorkgroupTuner::CreatePipeline(
+    const olp::Device &iDevice,
+    VkPipelineLayout iLayout,
+    const std::filesystem::path &iShaderPath,
+    const WorkgroupSize &iSize,
+    const std::vector<uint32_t> &iConstants)
+{
+    olp::Shader shader(iDevice);
+    shader.Load(iShaderPath);
+
+    // The constant of id i is the i-th value.
+    std::vector<uint32_t> values = {iSize.X, iSize.Y, iSize.Z};
+    values.insert(values.end(), iConstants.begin(), iConstants.end());
+    std::vector<VkSpecializationMapEntry> entries(values.size());
+    for (uint32_t i = 0; i < entries.size(); ++i)
+        entries[i] = {i, static_cast<uint32_t>(i * sizeof(uint32_t)), sizeof(uint32_t)};
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(entries.size());
+    specializationInfo.pMapEntries = entries.data();
+    specializationInfo.dataSize = values.size() * sizeof(uint32_t);
+    specializationInfo.pData = values.data();
+
+    VkPipelineShaderStageCreateInfo shaderStageInfo{};
+    shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStageInfo.module = shader.GetShaderModule();
+    shaderStageInfo.pName = "main";
+    shaderStageInfo.pSpecializationInfo = &specializationInfo;
+
+    VkComputePipelineCreateInfo pipelineCreateInfo{};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.layout = iLayout;
+    pipelineCreateInfo.stage = shaderStageInfo;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VK_CHECK_RESULT(
+        vkCreateComputePipelines(iDevice.GetDevice(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pipeline))
+    return pipeline;
+}
@@ -77,10 +77,68 @@ void Window::Run()
         UpdateParameters();
 
         m_Renderer->DrawNextFrame(m_Camera.GetViewMatrix(), m_Camera.GetPerspectiveMatrix());
-        glfwPollEvents();
+        // A converged image needs no new frame: sleep until an input, or a while for the background loading.
+        if (m_Renderer->IsIdle())
+            glfwWaitEventsTimeout(IDLE_TIMEOUT_SECONDS);
+        else
+            glfwPollEvents();
     }
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+void Window::AddCloud(const std::filesystem::path &iFilePath)
+{
+    m_Renderer->AddCloud(iFilePath);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Window::AddClouds(const std::vector<CloudSource> &iSources, float iVoxelSize, uint32_t iPointsPerVoxel)
+{
+    m_Renderer->AddClouds(iSources, iVoxelSize, iPointsPerVoxel);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Window::SetFrameTimeTarget(float iMilliseconds)
+{
+    m_Renderer->SetFrameTimeTarget(iMilliseconds);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Window::SetPointRasterization(PointRasterization iRasterization)
+{
+    m_Renderer->SetPointRasterization(iRasterization);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Window::EnableHoleFilling(bool iEnabled)
+{
+    m_Renderer->EnableHoleFilling(iEnabled);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Window::SetFramesInFlight(uint32_t iFrameCount)
+{
+    m_Renderer->SetFramesInFlight(iFrameCount);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Window::EnableOverlapReport(bool iEnabled)
+{
+    m_Renderer->EnableOverlapReport(iEnabled);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Window::EnableCommandBufferReuse(bool iEnabled)
+{
+    m_Renderer->EnableCommandBufferReuse(iEnabled);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Window::AddMesh(const std::filesystem::path &iFilePath)
+{
+    m_Renderer->AddMesh(iFilePath);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 void Window::CreateSurface()
 {
@@ -1,8 +1,136 @@
 #include "Window.h"
+#include "IO/CloudReader.h"
+#include "IO/OpcWriter.h"
+#include "IO/ProgressiveOrder.h"
+#include "IO/VoxelGridReader.h"
+#include <iostream>
+#include <string>
+#include <vector>
 
-int main()
+int main(int argc, char *argv[])
 {
+    // --voxel <size> [--per-voxel <count>] decimates the clouds at import, in the viewer and in --convert.
+    float voxelSize = 0.0f;
+    uint32_t pointsPerVoxel = 1;
+
+    // --benchmark-order <cloud>: compare the coverage of the random and stratified progressive orders.
+    if (argc >= 3 && std::string(argv[1]) == "--benchmark-order")
+    {
+        try
+        {
+            BenchmarkProgressiveOrders(*CloudReader::Open(argv[2]));
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // --convert <cloud> <output.opc> [quantization] [--compress] [--stratified]: preprocess a cloud once, without
+    // opening the viewer.
+    if (argc >= 4 && std::string(argv[1]) == "--convert")
+    {
+        try
+        {
+            float quantization = 0.0f;
+            bool compress = false;
+            ProgressiveOrder order = ProgressiveOrder::Random;
+            for (int i = 4; i < argc; ++i)
+            {
+                const std::string argument = argv[i];
+                if (argument == "--compress")
+                    compress = true;
+                else if (argument == "--stratified")
+                    order = ProgressiveOrder::Stratified;
+                else if (argument == "--voxel" && i + 1 < argc)
+                    voxelSize = std::stof(argv[++i]);
+                else if (argument == "--per-voxel" && i + 1 < argc)
+                    pointsPerVoxel = static_cast<uint32_t>(std::stoul(argv[++i]));
+                else
+                    quantization = std::stof(argument);
+            }
+            std::unique_ptr<CloudReader> reader = CloudReader::Open(argv[2]);
+            if (voxelSize > 0.0f)
+                reader = std::make_unique<VoxelGridReader>(std::move(reader), voxelSize, pointsPerVoxel);
+            WriteOpcCloud(*reader, argv[3], quantization, compress, order);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     Window window("Galaxy simation", 1200, 800);
+    // Clouds to render are given on the command line and merged in one scene, meshes are OBJ files or follow --mesh.
+    // --matrix <16 values, row by row> places the next cloud. --frame-time <ms> sets the GPU frame time the step size
+    // adapts to, 0 for a fixed step. --compute-raster draws the points with the compute rasterizer, --hole-filling
+    // also fills the holes between them.
+    // --record-every-frame records the command buffers each frame instead of reusing them. --overlap-stats prints how
+    // much of the prepare pass overlaps the next frame. --frames-in-flight <n> sets how many frames the host submits
+    // ahead of the GPU, 2 by default.
+    std::vector<CloudSource> clouds;
+    glm::mat4 transform(1.0f);
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument == "--mesh" && i + 1 < argc)
+        {
+            window.AddMesh(argv[++i]);
+        }
+        else if (argument == "--matrix" && i + 16 < argc)
+        {
+            for (int row = 0; row < 4; ++row)
+                for (int column = 0; column < 4; ++column)
+                    transform[column][row] = std::stof(argv[++i]);
+        }
+        else if (argument == "--frame-time" && i + 1 < argc)
+        {
+            window.SetFrameTimeTarget(std::stof(argv[++i]));
+        }
+        else if (argument == "--compute-raster")
+        {
+            window.SetPointRasterization(PointRasterization::Compute);
+        }
+        else if (argument == "--hole-filling")
+        {
+            window.EnableHoleFilling(true);
+        }
+        else if (argument == "--record-every-frame")
+        {
+            window.EnableCommandBufferReuse(false);
+        }
+        else if (argument == "--frames-in-flight" && i + 1 < argc)
+        {
+            window.SetFramesInFlight(static_cast<uint32_t>(std::stoul(argv[++i])));
+        }
+        else if (argument == "--overlap-stats")
+        {
+            window.EnableOverlapReport(true);
+        }
+        else if (argument == "--voxel" && i + 1 < argc)
+        {
+            voxelSize = std::stof(argv[++i]);
+        }
+        else if (argument == "--per-voxel" && i + 1 < argc)
+        {
+            pointsPerVoxel = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (std::filesystem::path(argument).extension() == ".obj")
+        {
+            window.AddMesh(argument);
+        }
+        else
+        {
+            clouds.push_back({argument, transform});
+            transform = glm::mat4(1.0f);
+        }
+    }
+    if (!clouds.empty())
+        window.AddClouds(clouds, voxelSize, pointsPerVoxel);
     window.Run();
     return 0;
 }
\ No newline at end of file